@@ -0,0 +1,403 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Client.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * Sends the messages and waits for each echo. Busy polls the socket, so the
+ * client does not add latency to the measurement.
+ */
+static bool runEchoClient(unsigned short port, unsigned int messages,
+                          std::size_t size) {
+  Client client("127.0.0.1", port);
+  if (!client.open()) {
+    return false;
+  }
+
+  std::string message(size, 'x');
+  for (unsigned int i = 0; i < messages; i++) {
+    if (!client.write(message.c_str(), message.size())) {
+      return false;
+    }
+    // the echo might be split into several reads
+    std::size_t received = 0;
+    while (received < size) {
+      BufferView response;
+      int rc = client.tryRead(response);
+      if (rc < 0) {
+        return false;
+      } else if (rc == 0) {
+        std::this_thread::yield();
+      } else if (response.empty()) {
+        // the server closed the connection
+        return false;
+      } else {
+        received += response.size();
+      }
+    }
+  }
+
+  client.close();
+  return true;
+}
+
+int Benchmark::runEcho(Server::Backend backend, unsigned short port,
+                       unsigned int connections, unsigned int messages,
+                       std::size_t size) {
+  Server server(port, "127.0.0.1", backend);
+  if (!server.open()) {
+    std::cerr << "Failed to open server." << std::endl;
+    return -1;
+  }
+
+  std::atomic<unsigned int> failed{0};
+  std::vector<std::thread> clients;
+  std::size_t allocations = BufferPool::getAllocationCount();
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < connections; i++) {
+    clients.emplace_back([port, messages, size, &failed]() {
+      if (!runEchoClient(port, messages, size)) {
+        failed++;
+      }
+    });
+  }
+  for (std::thread &client : clients) {
+    client.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  server.close();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double total = static_cast<double>(connections) * messages;
+
+  std::cout << "Backend: "
+            << (server.getBackend() == Server::Backend::IoUring ? "io_uring"
+                                                                : "posix")
+            << std::endl;
+  std::cout << "Connections: " << connections << std::endl;
+  std::cout << "Messages per connection: " << messages << std::endl;
+  std::cout << "Message size: " << size << " bytes" << std::endl;
+  std::cout << "Failed connections: " << failed << std::endl;
+  std::cout << "Duration: " << seconds << " s" << std::endl;
+  std::cout << "Round trips/s: " << total / seconds << std::endl;
+  std::cout << "Throughput: " << (total * size) / seconds / (1024 * 1024)
+            << " MiB/s" << std::endl;
+  // grows with the number of threads and not with the number of messages
+  std::cout << "Pooled buffer allocations: "
+            << BufferPool::getAllocationCount() - allocations << std::endl;
+
+  return failed == 0 ? 0 : -1;
+}
+
+int Benchmark::runLatency(Server::Backend backend, unsigned short port,
+                          unsigned int messages,
+                          unsigned int idleMilliseconds) {
+  Server server(port, "127.0.0.1", backend);
+  if (!server.open()) {
+    std::cerr << "Failed to open server." << std::endl;
+    return -1;
+  }
+
+  Client client("127.0.0.1", port);
+  if (!client.open()) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    server.close();
+    return -1;
+  }
+
+  std::string message = "ping";
+  std::vector<double> latencies;
+  bool failed = false;
+  for (unsigned int i = 0; i < messages && !failed; i++) {
+    // let the worker go idle
+    std::this_thread::sleep_for(std::chrono::milliseconds(idleMilliseconds));
+
+    auto start = std::chrono::steady_clock::now();
+    if (!client.write(message.c_str(), message.size())) {
+      failed = true;
+      break;
+    }
+    std::size_t received = 0;
+    while (received < message.size()) {
+      BufferView response;
+      int rc = client.tryRead(response);
+      if (rc < 0 || (rc > 0 && response.empty())) {
+        failed = true;
+        break;
+      } else if (rc == 0) {
+        std::this_thread::yield();
+      } else {
+        received += response.size();
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  client.close();
+  server.close();
+
+  if (failed || latencies.empty()) {
+    std::cerr << "Failed to measure latency." << std::endl;
+    return -1;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (double latency : latencies) {
+    sum += latency;
+  }
+
+  std::cout << "Backend: "
+            << (server.getBackend() == Server::Backend::IoUring ? "io_uring"
+                                                                : "posix")
+            << std::endl;
+  std::cout << "Messages: " << latencies.size() << std::endl;
+  std::cout << "Idle before each message: " << idleMilliseconds << " ms"
+            << std::endl;
+  std::cout << "Min latency: " << latencies.front() << " us" << std::endl;
+  std::cout << "Avg latency: " << sum / latencies.size() << " us"
+            << std::endl;
+  std::cout << "Median latency: " << latencies[latencies.size() / 2] << " us"
+            << std::endl;
+  std::cout << "Max latency: " << latencies.back() << " us" << std::endl;
+  return 0;
+}
+
+/**
+ * Opens the connections one after another. Each connection waits for the echo
+ * of one byte.
+ */
+static bool runAcceptClient(unsigned short port, unsigned int connections) {
+  for (unsigned int i = 0; i < connections; i++) {
+    Client client("127.0.0.1", port);
+    if (!client.open()) {
+      return false;
+    }
+    if (!client.write("x", 1)) {
+      return false;
+    }
+    BufferView response;
+    int rc;
+    while ((rc = client.tryRead(response)) == 0) {
+      std::this_thread::yield();
+    }
+    if (rc < 0 || response.empty()) {
+      return false;
+    }
+    client.close();
+  }
+  return true;
+}
+
+int Benchmark::runAccept(Server::Backend backend, unsigned short port,
+                         unsigned int clients, unsigned int connections) {
+  const unsigned int shardCounts[] = {1, 2, 4, 8};
+
+  std::cout << "Clients: " << clients << std::endl;
+  std::cout << "Connections per client: " << connections << std::endl;
+
+  int result = 0;
+  for (unsigned int shardCount : shardCounts) {
+    Server server(port, "127.0.0.1", backend, shardCount);
+    if (!server.open()) {
+      std::cerr << "Failed to open server." << std::endl;
+      return -1;
+    }
+
+    std::atomic<unsigned int> failed{0};
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < clients; i++) {
+      threads.emplace_back([port, connections, &failed]() {
+        if (!runAcceptClient(port, connections)) {
+          failed++;
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    server.close();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double total = static_cast<double>(clients) * connections;
+
+    std::cout << "Backend: "
+              << (server.getBackend() == Server::Backend::IoUring ? "io_uring"
+                                                                  : "posix")
+              << ", Shards: " << shardCount
+              << ", Failed clients: " << failed
+              << ", Connections/s: " << total / seconds << std::endl;
+    if (failed != 0) {
+      result = -1;
+    }
+  }
+  return result;
+}
+
+/**
+ * Sends the frames in batches of depth frames and waits for the echo of each
+ * batch.
+ */
+static bool runPipelineClient(unsigned short port, unsigned int messages,
+                              std::size_t size, unsigned int depth) {
+  Client client("127.0.0.1", port);
+  if (!client.open()) {
+    return false;
+  }
+
+  BufferRef payloadBuffer = BufferPool::acquire(size);
+  std::fill(payloadBuffer.data(), payloadBuffer.data() + size, 'x');
+  BufferView payload(payloadBuffer, 0, size);
+  std::vector<BufferView> batch;
+
+  unsigned int sent = 0;
+  while (sent < messages) {
+    batch.assign(std::min(depth, messages - sent), payload);
+    if (!client.writeFrames(batch)) {
+      return false;
+    }
+    sent += batch.size();
+
+    // the echoes arrive in order
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      BufferView frame;
+      int rc;
+      while ((rc = client.tryReadFrame(frame)) == 0) {
+        std::this_thread::yield();
+      }
+      if (rc < 0 || frame.size() != size) {
+        return false;
+      }
+    }
+  }
+
+  client.close();
+  return true;
+}
+
+int Benchmark::runPipeline(Server::Backend backend, unsigned short port,
+                           unsigned int connections, unsigned int messages,
+                           std::size_t size, unsigned int depth) {
+  if (depth == 0) {
+    depth = 1;
+  }
+
+  Server server(port, "127.0.0.1", backend);
+  server.setFraming(true);
+  if (!server.open()) {
+    std::cerr << "Failed to open server." << std::endl;
+    return -1;
+  }
+
+  std::atomic<unsigned int> failed{0};
+  std::vector<std::thread> clients;
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < connections; i++) {
+    clients.emplace_back([port, messages, size, depth, &failed]() {
+      if (!runPipelineClient(port, messages, size, depth)) {
+        failed++;
+      }
+    });
+  }
+  for (std::thread &client : clients) {
+    client.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  server.close();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double total = static_cast<double>(connections) * messages;
+
+  std::cout << "Backend: "
+            << (server.getBackend() == Server::Backend::IoUring ? "io_uring"
+                                                                : "posix")
+            << std::endl;
+  std::cout << "Connections: " << connections << std::endl;
+  std::cout << "Frames per connection: " << messages << std::endl;
+  std::cout << "Frames per write: " << depth << std::endl;
+  std::cout << "Payload size: " << size << " bytes" << std::endl;
+  std::cout << "Failed connections: " << failed << std::endl;
+  std::cout << "Duration: " << seconds << " s" << std::endl;
+  std::cout << "Frames/s: " << total / seconds << std::endl;
+
+  return failed == 0 ? 0 : -1;
+}
+
+int Benchmark::runSplice(unsigned short port, unsigned int connections,
+                         unsigned int messages) {
+  const std::size_t sizes[] = {1024, 64 * 1024, 1024 * 1024};
+  const Worker::Mode modes[] = {Worker::Mode::Forward, Worker::Mode::Splice};
+
+  std::cout << "Connections: " << connections << std::endl;
+  std::cout << "Messages per connection: " << messages << std::endl;
+
+  int result = 0;
+  for (std::size_t size : sizes) {
+    for (Worker::Mode mode : modes) {
+      Server server(port, "127.0.0.1", Server::Backend::Posix);
+      server.setWorkerMode(mode);
+      if (!server.open()) {
+        std::cerr << "Failed to open server." << std::endl;
+        return -1;
+      }
+
+      std::atomic<unsigned int> failed{0};
+      std::vector<std::thread> clients;
+
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned int i = 0; i < connections; i++) {
+        clients.emplace_back([port, messages, size, &failed]() {
+          if (!runEchoClient(port, messages, size)) {
+            failed++;
+          }
+        });
+      }
+      for (std::thread &client : clients) {
+        client.join();
+      }
+      auto end = std::chrono::steady_clock::now();
+
+      server.close();
+
+      double seconds = std::chrono::duration<double>(end - start).count();
+      double total = static_cast<double>(connections) * messages;
+
+      std::cout << "Mode: "
+                << (mode == Worker::Mode::Splice ? "splice" : "copy")
+                << ", Message size: " << size << " bytes"
+                << ", Failed connections: " << failed
+                << ", Throughput: " << (total * size) / seconds / (1024 * 1024)
+                << " MiB/s" << std::endl;
+      if (failed != 0) {
+        result = -1;
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Server.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * Measurements of the socket classes.
+ */
+class Benchmark {
+ public:
+  /**
+   * Starts an echo server with the given backend and measures the throughput
+   * of clients which send messages and wait for the echo.
+   *
+   * @param backend the I/O interface of the server
+   * @param port the port of the server
+   * @param connections the number of concurrent clients
+   * @param messages the number of messages each client sends
+   * @param size the size of each message in bytes
+   * @return 0 on success, otherwise -1
+   */
+  static int runEcho(Server::Backend backend, unsigned short port,
+                     unsigned int connections, unsigned int messages,
+                     std::size_t size);
+  /**
+   * Starts an echo server with the given backend and measures the round trip
+   * time of a client which pauses before each message, so the worker is idle
+   * whenever a message arrives.
+   *
+   * @param backend the I/O interface of the server
+   * @param port the port of the server
+   * @param messages the number of messages to send
+   * @param idleMilliseconds the pause before each message
+   * @return 0 on success, otherwise -1
+   */
+  static int runLatency(Server::Backend backend, unsigned short port,
+                        unsigned int messages, unsigned int idleMilliseconds);
+  /**
+   * Measures how many connections per second a server accepts with 1, 2, 4
+   * and 8 shards. Each connection sends one byte and waits for the echo
+   * before it is closed, so every connection has been accepted and served.
+   *
+   * @param backend the I/O interface of the server
+   * @param port the port of the server
+   * @param clients the number of concurrent clients
+   * @param connections the number of connections each client opens
+   * @return 0 on success, otherwise -1
+   */
+  static int runAccept(Server::Backend backend, unsigned short port,
+                       unsigned int clients, unsigned int connections);
+  /**
+   * Starts an echo server with length-prefixed framing and measures the
+   * throughput of clients which pipeline frames: each client encodes depth
+   * frames into a single write and waits for all echoes before the next batch.
+   *
+   * @param backend the I/O interface of the server
+   * @param port the port of the server
+   * @param connections the number of concurrent clients
+   * @param messages the number of frames each client sends
+   * @param size the payload size of each frame in bytes
+   * @param depth the number of frames per write
+   * @return 0 on success, otherwise -1
+   */
+  static int runPipeline(Server::Backend backend, unsigned short port,
+                         unsigned int connections, unsigned int messages,
+                         std::size_t size, unsigned int depth);
+  /**
+   * Compares the throughput of the copying and the zero-copy echo path with
+   * 1KiByte, 64KiByte and 1MiByte messages. The copying path reads into
+   * pooled buffers and writes them with writev(), the zero-copy path moves
+   * the data with splice(). Neither path inspects the data.
+   *
+   * @param port the port of the server
+   * @param connections the number of concurrent clients
+   * @param messages the number of messages each client sends
+   * @return 0 on success, otherwise -1
+   */
+  static int runSplice(unsigned short port, unsigned int connections,
+                       unsigned int messages);
+
+ private:
+  Benchmark() = delete;
+};
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
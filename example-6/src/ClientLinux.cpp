@@ -6,12 +6,14 @@
 #include <fcntl.h>       // ::fcntl(...)
 #include <netdb.h>       // ::gethostbyname(...) ; hostent
 #include <netinet/in.h>  // sockaddr_in
+#include <poll.h>        // ::poll(...) ; pollfd ; POLLIN
 #include <sys/socket.h>  // ::socket(...) ; SOCK_STREAM ; AF_INET ; connect(...)
 #include <unistd.h>      // ::close(int), ::read(int, void*, size_t), write(...)
 
 #include <cerrno>    // errno
 #include <cstring>   // strerror_r(...) , std::memcpy(...)
 #include <iostream>  // std::cout(...), std::cerr(...)
+#include <utility>   // std::move
 
 #include "Client.h"
 
@@ -328,6 +330,8 @@ bool Client::open() {
   }
 
   this->enabled = true;
+  // drop partial frames of a previous connection
+  this->frameParser.reset();
 
   // create a socket address
   sockaddr_in address;
@@ -404,6 +408,19 @@ bool Client::closeSocket() {
   return true;
 }
 
+/**
+ * Blocks until the socket is writable or the timeout expires. The timeout
+ * allows the caller to check whether the client has been closed.
+ */
+static void waitWritable(int socket) {
+  pollfd fd = {};
+  fd.fd = socket;
+  fd.events = POLLOUT;
+  // milliseconds
+  int timeout = 100;
+  ::poll(&fd, 1, timeout);
+}
+
 /**
  * ssize_t write(int fd, const void *buf, size_t count);
  */
@@ -422,12 +439,10 @@ bool Client::write(const byte data[], size_t length) {
                    remaining);
 
       if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-        std::cout << "Worker read AGAIN" << std::endl;
         // The file descriptor fd refers to a file other than a socket and has
-        // been marked nonblocking (O_NONBLOCK), and the read would block.
-        if (this->enabled) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+        // been marked nonblocking (O_NONBLOCK), and the write would block.
+        // Wait until the peer has taken data from the send buffer.
+        waitWritable(this->clientSocket);
         continue;
       } else if (rc < 0) {
         // an error occurred
@@ -452,6 +467,45 @@ bool Client::write(const byte data[], size_t length) {
   return false;
 }
 
+/**
+ * Blocks until the socket is readable or the timeout expires. The timeout
+ * allows the caller to check whether the client has been closed.
+ *
+ * The method call
+ *   int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+ * is defined in header <poll.h>
+ */
+static void waitReadable(int socket) {
+  pollfd fd = {};
+  fd.fd = socket;
+  fd.events = POLLIN;
+  // milliseconds
+  int timeout = 100;
+  ::poll(&fd, 1, timeout);
+}
+
+/**
+ * ppoll() is like poll() but takes the timeout as timespec, so the timeout is
+ * not rounded to milliseconds.
+ *
+ * The method call
+ *   int ppoll(struct pollfd *fds, nfds_t nfds, const struct timespec
+ * *tmo_p, const sigset_t *sigmask);
+ * is defined in header <poll.h>
+ */
+bool Client::waitForData(long timeoutMicroseconds) {
+  pollfd fd = {};
+  fd.fd = this->clientSocket;
+  fd.events = POLLIN;
+  timespec timeout = {};
+  if (timeoutMicroseconds > 0) {
+    timeout.tv_sec = timeoutMicroseconds / 1000000;
+    timeout.tv_nsec = (timeoutMicroseconds % 1000000) * 1000;
+  }
+  // POLLHUP and POLLERR are reported by the next read
+  return ::ppoll(&fd, 1, &timeout, nullptr) > 0;
+}
+
 bool Client::readString(std::string &message) {
   int result = -1;
   do {
@@ -459,20 +513,29 @@ bool Client::readString(std::string &message) {
     if (result > 0) {
       return true;
     } else if (result == 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      waitReadable(this->clientSocket);
     }
   } while (this->enabled && result == 0);
   return false;
 }
 
 int Client::tryReadString(std::string &message) {
-  byte recvbuf[Client::MAX_BUFFER_SIZE];
+  BufferView view;
+  int rc = this->tryRead(view);
+  message = view.toString();
+  return rc;
+}
+
+int Client::tryRead(BufferView &view) {
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte *recvbuf = buffer.data();
 
-  message = "";
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::read(this->clientSocket, recvbuf, Client::MAX_BUFFER_SIZE);
+    rc = ::read(this->clientSocket, recvbuf, buffer.capacity());
     if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
       return 0;
     } else if (rc < 0) {
@@ -485,7 +548,9 @@ int Client::tryReadString(std::string &message) {
       return 1;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
       return rc;
     }
   }
@@ -493,6 +558,53 @@ int Client::tryReadString(std::string &message) {
   return false;
 }
 
+int Client::tryReadFrame(BufferView &frame) {
+  // deliver the frames of the previous reads first
+  if (this->frameParser.next(frame)) {
+    return 1;
+  }
+
+  BufferView data;
+  int rc = this->tryRead(data);
+  if (rc <= 0) {
+    return rc;
+  } else if (data.empty()) {
+    // the server closed the connection
+    return -1;
+  }
+  if (!this->frameParser.feed(data)) {
+    std::cerr << "Received invalid frame" << std::endl;
+    return -1;
+  }
+  return this->frameParser.next(frame) ? 1 : 0;
+}
+
+bool Client::readFrame(BufferView &frame) {
+  int result = -1;
+  do {
+    result = this->tryReadFrame(frame);
+    if (result > 0) {
+      return true;
+    } else if (result == 0) {
+      waitReadable(this->clientSocket);
+    }
+  } while (this->enabled && result == 0);
+  return false;
+}
+
+bool Client::writeFrame(const byte data[], size_t length) {
+  BufferView frame = Frame::encode(data, length);
+  return this->write(frame.data(), frame.size());
+}
+
+bool Client::writeFrames(const std::vector<BufferView> &payloads) {
+  if (payloads.empty()) {
+    return true;
+  }
+  BufferView frames = Frame::encode(payloads);
+  return this->write(frames.data(), frames.size());
+}
+
 }  // namespace socket
 }  // namespace cpp
 }  // namespace ggolbik
@@ -31,7 +31,21 @@ bool Client::write(const byte data[], size_t length) { return false; }
 
 bool Client::readString(std::string &message) { return false; }
 
-bool Client::tryReadString(std::string &message) { return false; }
+int Client::tryReadString(std::string &message) { return -1; }
+
+int Client::tryRead(BufferView &view) { return -1; }
+
+bool Client::waitForData(long timeoutMicroseconds) { return false; }
+
+int Client::tryReadFrame(BufferView &frame) { return -1; }
+
+bool Client::readFrame(BufferView &frame) { return false; }
+
+bool Client::writeFrame(const byte data[], size_t length) { return false; }
+
+bool Client::writeFrames(const std::vector<BufferView> &payloads) {
+  return false;
+}
 
 }  // namespace socket
 }  // namespace cpp
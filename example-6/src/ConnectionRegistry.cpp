@@ -0,0 +1,119 @@
+#include "ConnectionRegistry.h"
+
+#include "Worker.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+ConnectionRegistry::~ConnectionRegistry() { this->closeAll(); }
+
+ConnectionRegistry::Handle ConnectionRegistry::insert(
+    std::shared_ptr<Worker> worker) {
+  Handle handle;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->freeSlots.empty()) {
+      handle = this->slots.size();
+      this->slots.push_back(worker);
+    } else {
+      handle = this->freeSlots.back();
+      this->freeSlots.pop_back();
+      this->slots[handle] = worker;
+    }
+    this->liveCount++;
+    this->totalCount++;
+  }
+
+  // the registry outlives the worker thread, because reap() and closeAll()
+  // close the worker before its slot is freed.
+  const Worker *pointer = worker.get();
+  worker->setFinishedCallback(
+      [this, handle, pointer]() { this->markFinished(handle, pointer); });
+
+  return handle;
+}
+
+void ConnectionRegistry::remove(Handle handle) {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  if (handle < this->slots.size() && this->slots[handle]) {
+    this->slots[handle].reset();
+    this->freeSlots.push_back(handle);
+    this->liveCount--;
+  }
+}
+
+void ConnectionRegistry::markFinished(Handle handle, const Worker *worker) {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->finished.push_back(std::make_pair(handle, worker));
+}
+
+std::size_t ConnectionRegistry::reap() {
+  std::vector<std::pair<Handle, const Worker *>> finishedWorkers;
+  std::vector<std::shared_ptr<Worker>> workers;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->finished.empty()) {
+      return 0;
+    }
+    finishedWorkers.swap(this->finished);
+    for (auto &entry : finishedWorkers) {
+      Handle handle = entry.first;
+      if (handle < this->slots.size() &&
+          this->slots[handle].get() == entry.second) {
+        workers.push_back(this->slots[handle]);
+        this->slots[handle].reset();
+        this->freeSlots.push_back(handle);
+        this->liveCount--;
+      }
+    }
+  }
+
+  // close outside of the lock. close() joins the worker thread, which might
+  // wait for the lock in markFinished().
+  for (std::shared_ptr<Worker> &worker : workers) {
+    worker->close();
+  }
+  return workers.size();
+}
+
+void ConnectionRegistry::closeAll() {
+  std::vector<std::shared_ptr<Worker>> workers;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    for (std::shared_ptr<Worker> &worker : this->slots) {
+      if (worker) {
+        workers.push_back(worker);
+      }
+    }
+    this->slots.clear();
+    this->freeSlots.clear();
+    this->liveCount = 0;
+  }
+
+  for (std::shared_ptr<Worker> &worker : workers) {
+    worker->close();
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->finished.clear();
+}
+
+std::size_t ConnectionRegistry::getLiveCount() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  return this->liveCount;
+}
+
+std::size_t ConnectionRegistry::getTotalCount() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  return this->totalCount;
+}
+
+std::size_t ConnectionRegistry::getCapacity() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  return this->slots.size();
+}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
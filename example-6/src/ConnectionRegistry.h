@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+class Worker;
+
+/**
+ * Keeps track of the workers of the open connections.
+ *
+ * The workers are stored in a slab. Insert and remove are O(1) and the slots
+ * of removed workers are reused, so the memory of a long-lived server depends
+ * on the number of concurrent connections and not on the number of accepted
+ * connections.
+ *
+ * A worker reports through its finished callback that its connection has been
+ * closed. reap() closes these workers and frees their slots.
+ */
+class ConnectionRegistry {
+ public:  // type definitions
+  /**
+   * Identifies a slot of the registry.
+   */
+  typedef std::size_t Handle;
+
+ public:  // construction/destruction/operators
+  /**
+   * Default constructor
+   */
+  ConnectionRegistry() = default;
+  /**
+   * Move constructor
+   */
+  ConnectionRegistry(ConnectionRegistry &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  ConnectionRegistry &operator=(ConnectionRegistry &&) = delete;
+  /**
+   * Copy constructor
+   */
+  ConnectionRegistry(const ConnectionRegistry &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  ConnectionRegistry &operator=(const ConnectionRegistry &) = delete;
+  /**
+   * Destructor. Closes all workers.
+   */
+  virtual ~ConnectionRegistry();
+
+ public:  // methods
+  /**
+   * Stores the worker in a free slot and registers the finished callback of
+   * the worker. Must be called before the worker is started.
+   */
+  Handle insert(std::shared_ptr<Worker> worker);
+  /**
+   * Frees the slot. The worker is not closed.
+   */
+  void remove(Handle handle);
+  /**
+   * Marks the worker as finished. Called by the worker if its connection has
+   * been closed. Thread safe.
+   */
+  void markFinished(Handle handle, const Worker *worker);
+  /**
+   * Closes the finished workers and frees their slots.
+   *
+   * @return the number of reaped workers.
+   */
+  std::size_t reap();
+  /**
+   * Closes all workers and frees all slots.
+   */
+  void closeAll();
+  /**
+   * Returns the number of workers in the registry.
+   */
+  std::size_t getLiveCount();
+  /**
+   * Returns the number of workers which have been inserted since the registry
+   * has been created.
+   */
+  std::size_t getTotalCount();
+  /**
+   * Returns the number of slots of the slab.
+   */
+  std::size_t getCapacity();
+
+ private:  // fields
+  std::mutex mutex;
+  /**
+   * The slab. Empty slots hold no worker.
+   */
+  std::vector<std::shared_ptr<Worker>> slots;
+  /**
+   * The indexes of the empty slots.
+   */
+  std::vector<Handle> freeSlots;
+  /**
+   * The finished workers which have not been reaped yet. The pointer detects
+   * handles which have been reused in the meantime.
+   */
+  std::vector<std::pair<Handle, const Worker *>> finished;
+  std::size_t liveCount = 0;
+  std::size_t totalCount = 0;
+};
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
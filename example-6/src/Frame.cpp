@@ -0,0 +1,145 @@
+#include "Frame.h"
+
+#include <cstring>  // std::memcpy(...)
+#include <utility>  // std::move
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+static void writeHeader(std::uint32_t length, char *header) {
+  header[0] = static_cast<char>((length >> 24) & 0xff);
+  header[1] = static_cast<char>((length >> 16) & 0xff);
+  header[2] = static_cast<char>((length >> 8) & 0xff);
+  header[3] = static_cast<char>(length & 0xff);
+}
+
+static std::uint32_t readHeader(const unsigned char *header) {
+  return (static_cast<std::uint32_t>(header[0]) << 24) |
+         (static_cast<std::uint32_t>(header[1]) << 16) |
+         (static_cast<std::uint32_t>(header[2]) << 8) |
+         static_cast<std::uint32_t>(header[3]);
+}
+
+BufferView Frame::encode(const char *data, std::size_t length) {
+  BufferRef buffer = BufferPool::acquire(Frame::HEADER_SIZE + length);
+  writeHeader(static_cast<std::uint32_t>(length), buffer.data());
+  if (length > 0) {
+    std::memcpy(buffer.data() + Frame::HEADER_SIZE, data, length);
+  }
+  return BufferView(std::move(buffer), 0, Frame::HEADER_SIZE + length);
+}
+
+BufferView Frame::encode(const std::vector<BufferView> &payloads) {
+  std::size_t size = 0;
+  for (const BufferView &payload : payloads) {
+    size += Frame::HEADER_SIZE + payload.size();
+  }
+
+  BufferRef buffer = BufferPool::acquire(size);
+  char *position = buffer.data();
+  for (const BufferView &payload : payloads) {
+    writeHeader(static_cast<std::uint32_t>(payload.size()), position);
+    position += Frame::HEADER_SIZE;
+    if (!payload.empty()) {
+      std::memcpy(position, payload.data(), payload.size());
+      position += payload.size();
+    }
+  }
+  return BufferView(std::move(buffer), 0, size);
+}
+
+bool FrameParser::feed(const BufferView &data) {
+  if (this->invalid) {
+    return false;
+  }
+
+  // drop the delivered frames, so the vector does not grow
+  if (this->nextFrame == this->frames.size()) {
+    this->frames.clear();
+    this->nextFrame = 0;
+  }
+
+  const char *bytes = data.data();
+  std::size_t position = 0;
+  while (position < data.size()) {
+    if (this->headerLength < Frame::HEADER_SIZE) {
+      // collect the header. It might be split across reads.
+      std::size_t count = Frame::HEADER_SIZE - this->headerLength;
+      if (count > data.size() - position) {
+        count = data.size() - position;
+      }
+      std::memcpy(this->header + this->headerLength, bytes + position, count);
+      this->headerLength += count;
+      position += count;
+      if (this->headerLength < Frame::HEADER_SIZE) {
+        break;
+      }
+
+      std::uint32_t length = readHeader(this->header);
+      if (length > Frame::MAX_PAYLOAD_SIZE) {
+        this->invalid = true;
+        return false;
+      }
+      this->payloadLength = length;
+      this->payloadReceived = 0;
+
+      if (length == 0) {
+        this->frames.push_back(BufferView());
+        this->headerLength = 0;
+        continue;
+      } else if (length <= data.size() - position) {
+        // the payload is part of this view
+        this->frames.push_back(data.subview(position, length));
+        position += length;
+        this->headerLength = 0;
+        continue;
+      }
+      // the payload is split across reads
+      this->payload = BufferPool::acquire(length);
+    }
+
+    // copy the next part of a split payload
+    std::size_t count = this->payloadLength - this->payloadReceived;
+    if (count > data.size() - position) {
+      count = data.size() - position;
+    }
+    std::memcpy(this->payload.data() + this->payloadReceived, bytes + position,
+                count);
+    this->payloadReceived += count;
+    position += count;
+
+    if (this->payloadReceived == this->payloadLength) {
+      this->frames.push_back(
+          BufferView(std::move(this->payload), 0, this->payloadLength));
+      this->headerLength = 0;
+    }
+  }
+
+  return true;
+}
+
+bool FrameParser::next(BufferView &frame) {
+  if (this->nextFrame >= this->frames.size()) {
+    return false;
+  }
+  frame = std::move(this->frames[this->nextFrame]);
+  this->nextFrame++;
+  return true;
+}
+
+bool FrameParser::hasPartialFrame() const { return this->headerLength > 0; }
+
+void FrameParser::reset() {
+  this->frames.clear();
+  this->nextFrame = 0;
+  this->headerLength = 0;
+  this->payload.reset();
+  this->payloadLength = 0;
+  this->payloadReceived = 0;
+  this->invalid = false;
+}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
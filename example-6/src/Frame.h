@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BufferPool.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * Length-prefixed framing. Each frame starts with a 4 byte header which holds
+ * the length of the payload as unsigned integer in network byte order (big
+ * endian), followed by the payload:
+ *
+ *   +--------+--------+--------+--------+----------------------+
+ *   |          payload length           | payload ...          |
+ *   +--------+--------+--------+--------+----------------------+
+ */
+class Frame {
+ public:  // const
+  // size of the length header
+  static const std::size_t HEADER_SIZE = 4;
+  // largest accepted payload (16MiByte). Larger lengths are treated as a
+  // protocol error, so a corrupt header cannot request a huge allocation.
+  static const std::uint32_t MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+
+ public:  // methods
+  /**
+   * Encodes the payload into a single frame.
+   */
+  static BufferView encode(const char *data, std::size_t length);
+  /**
+   * Encodes the payloads into consecutive frames of one buffer, so they can be
+   * sent with a single write.
+   */
+  static BufferView encode(const std::vector<BufferView> &payloads);
+
+ private:
+  Frame() = delete;
+};
+
+/**
+ * Incremental parser for length-prefixed frames. The data is fed as it is
+ * read from the stream. A frame can be split across several reads and one
+ * read can contain several frames.
+ *
+ * A frame which is completely contained in a fed view is delivered as a view
+ * of the same buffer without copying. Frames which are split across views are
+ * assembled in a pooled buffer.
+ */
+class FrameParser {
+ public:  // methods
+  /**
+   * Parses the data. Complete frames can be taken with next().
+   *
+   * @return false if the data contains an invalid frame header. The parser
+   * must not be used afterwards.
+   */
+  bool feed(const BufferView &data);
+  /**
+   * Takes the next complete frame.
+   *
+   * @return false if there is no complete frame.
+   */
+  bool next(BufferView &frame);
+  /**
+   * Returns true if a header or a payload has been received partially.
+   */
+  bool hasPartialFrame() const;
+  /**
+   * Drops all frames and partial data.
+   */
+  void reset();
+
+ private:  // fields
+  /**
+   * The complete frames. frames[nextFrame] is the next frame to deliver. The
+   * vector keeps its capacity, so parsing does not allocate in the steady
+   * state.
+   */
+  std::vector<BufferView> frames;
+  std::size_t nextFrame = 0;
+  /**
+   * The received bytes of the current header.
+   */
+  unsigned char header[Frame::HEADER_SIZE] = {};
+  std::size_t headerLength = 0;
+  /**
+   * The partial payload and the number of received payload bytes.
+   */
+  BufferRef payload;
+  std::size_t payloadLength = 0;
+  std::size_t payloadReceived = 0;
+  bool invalid = false;
+};
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
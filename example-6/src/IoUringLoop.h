@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * An io_uring based I/O loop which serves the listen socket and all accepted
+ * connections with a single thread. The loop uses a multishot accept, multishot
+ * receives into a provided buffer ring and linked sends, so one submission
+ * covers many operations.
+ *
+ * The loop is only available if the project has been built with liburing
+ * (HAVE_LIBURING) and the kernel supports the required features.
+ */
+class IoUringLoop {
+ public:  // type definitions
+  /**
+   * The ring and the connection state. Defined in the implementation to keep
+   * liburing out of the header.
+   */
+  struct State;
+
+ public:  // const
+  // number of submission queue entries
+  static const unsigned int QUEUE_ENTRIES = 1024;
+  // number of buffers in the provided buffer ring. Must be a power of 2.
+  static const unsigned int BUFFER_COUNT = 256;
+  // size of each buffer in the provided buffer ring (16KiByte)
+  static const unsigned int BUFFER_SIZE = 16384;
+  // the id of the provided buffer group
+  static const unsigned short BUFFER_GROUP = 1;
+
+ public:  // construction/destruction/operators
+  /**
+   * Default constructor
+   */
+  IoUringLoop();
+  /**
+   * Move constructor
+   */
+  IoUringLoop(IoUringLoop &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  IoUringLoop &operator=(IoUringLoop &&) = delete;
+  /**
+   * Copy constructor
+   */
+  IoUringLoop(const IoUringLoop &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  IoUringLoop &operator=(const IoUringLoop &) = delete;
+  /**
+   * Destructor
+   */
+  virtual ~IoUringLoop();
+
+ public:  // methods
+  /**
+   * Returns true if the binary has been built with liburing and the kernel
+   * supports io_uring with provided buffer rings.
+   */
+  static bool isSupported();
+  /**
+   * Creates the ring and the provided buffers.
+   *
+   * @param listenSocket the bound and listening socket.
+   * @return false if the ring could not be created.
+   */
+  bool open(int listenSocket);
+  /**
+   * Serves the listen socket and all connections until enabled is false.
+   * Closes all accepted connections before it returns.
+   */
+  void run(const std::atomic_bool &enabled);
+
+ private:  // fields
+  std::unique_ptr<State> state;
+};
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,409 @@
+#if defined(__linux__) && defined(HAVE_LIBURING)
+// linux code goes here
+// The io_uring backend requires liburing. See CMakeLists.txt.
+
+#include <liburing.h>    // io_uring_*(...)
+#include <sys/socket.h>  // ::shutdown(...) ; SHUT_RDWR ; MSG_WAITALL
+#include <unistd.h>      // ::close(int)
+
+#include <algorithm>      // std::stable_sort
+#include <cerrno>         // ENOBUFS ; EINTR ; ETIME
+#include <cstdint>        // uint64_t
+#include <cstring>        // ::strerror_r(...)
+#include <iostream>       // std::cout(...) ; std::cerr(...)
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+#include "IoUringLoop.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * The operation of a submission. Stored in the upper bits of the user data.
+ */
+enum Operation : uint64_t { Accept = 1, Receive = 2, Send = 3 };
+
+/**
+ * The state of an accepted connection.
+ */
+struct Connection {
+  // whether a multishot receive is armed for the socket
+  bool receiving = false;
+  // whether the connection shall be closed
+  bool closing = false;
+  // number of sends which are not completed yet
+  unsigned int pendingSends = 0;
+};
+
+/**
+ * A send which has been collected while processing the completions.
+ */
+struct PendingSend {
+  int socket;
+  unsigned short bufferId;
+  unsigned int length;
+};
+
+struct IoUringLoop::State {
+  io_uring ring = {};
+  bool ringInitialized = false;
+  io_uring_buf_ring *bufferRing = nullptr;
+  std::vector<char> buffers;
+  int listenSocket = -1;
+  std::unordered_map<int, Connection> connections;
+  // sends and starved sockets collected while processing a batch
+  std::vector<PendingSend> sends;
+  std::vector<int> starved;
+  // number of buffers given back to the kernel in the current batch
+  int returnedBuffers = 0;
+};
+
+/**
+ * The user data of a submission identifies the operation, the socket and the
+ * used buffer:
+ *   bits 56-63: operation
+ *   bits 32-47: buffer id
+ *   bits  0-31: socket
+ */
+static uint64_t encode(Operation operation, int socket,
+                       unsigned short bufferId = 0) {
+  return (static_cast<uint64_t>(operation) << 56) |
+         (static_cast<uint64_t>(bufferId) << 32) |
+         static_cast<uint32_t>(socket);
+}
+
+static Operation decodeOperation(uint64_t data) {
+  return static_cast<Operation>(data >> 56);
+}
+
+static int decodeSocket(uint64_t data) {
+  return static_cast<int>(static_cast<uint32_t>(data));
+}
+
+static unsigned short decodeBufferId(uint64_t data) {
+  return static_cast<unsigned short>(data >> 32);
+}
+
+static void printError(int error) {
+  size_t length = 1024;
+  char buffer[length];
+  std::cerr << "(" << error << ") " << ::strerror_r(error, buffer, length)
+            << std::endl;
+}
+
+/**
+ * Returns a free submission queue entry. Submits the queued entries if the
+ * submission queue is full.
+ */
+static io_uring_sqe *getSqe(io_uring *ring) {
+  io_uring_sqe *sqe = ::io_uring_get_sqe(ring);
+  if (sqe == nullptr) {
+    ::io_uring_submit(ring);
+    sqe = ::io_uring_get_sqe(ring);
+  }
+  return sqe;
+}
+
+IoUringLoop::IoUringLoop() : state{new State()} {}
+
+IoUringLoop::~IoUringLoop() {
+  if (this->state->bufferRing != nullptr) {
+    ::io_uring_free_buf_ring(&this->state->ring, this->state->bufferRing,
+                             IoUringLoop::BUFFER_COUNT,
+                             IoUringLoop::BUFFER_GROUP);
+  }
+  if (this->state->ringInitialized) {
+    ::io_uring_queue_exit(&this->state->ring);
+  }
+}
+
+/**
+ * Creates a small ring with a provided buffer ring. Kernels older than 5.19
+ * and kernels with io_uring disabled (e.g. by seccomp or
+ * kernel.io_uring_disabled) fail here.
+ */
+bool IoUringLoop::isSupported() {
+  io_uring ring = {};
+  if (::io_uring_queue_init(8, &ring, 0) != 0) {
+    return false;
+  }
+
+  bool supported = false;
+  io_uring_probe *probe = ::io_uring_get_probe_ring(&ring);
+  if (probe != nullptr) {
+    supported = ::io_uring_opcode_supported(probe, IORING_OP_ACCEPT) &&
+                ::io_uring_opcode_supported(probe, IORING_OP_RECV) &&
+                ::io_uring_opcode_supported(probe, IORING_OP_SEND);
+    ::io_uring_free_probe(probe);
+  }
+
+  if (supported) {
+    int rc = 0;
+    io_uring_buf_ring *bufferRing = ::io_uring_setup_buf_ring(
+        &ring, IoUringLoop::BUFFER_COUNT, IoUringLoop::BUFFER_GROUP, 0, &rc);
+    if (bufferRing == nullptr) {
+      supported = false;
+    } else {
+      ::io_uring_free_buf_ring(&ring, bufferRing, IoUringLoop::BUFFER_COUNT,
+                               IoUringLoop::BUFFER_GROUP);
+    }
+  }
+
+  ::io_uring_queue_exit(&ring);
+  return supported;
+}
+
+bool IoUringLoop::open(int listenSocket) {
+  State &s = *this->state;
+
+  int rc = ::io_uring_queue_init(IoUringLoop::QUEUE_ENTRIES, &s.ring, 0);
+  if (rc != 0) {
+    std::cerr << "Failed to create io_uring." << std::endl;
+    printError(-rc);
+    return false;
+  }
+  s.ringInitialized = true;
+
+  // The provided buffer ring is shared memory between the application and the
+  // kernel. The kernel picks a buffer when data arrives, so no buffer is
+  // reserved for idle connections.
+  s.bufferRing = ::io_uring_setup_buf_ring(&s.ring, IoUringLoop::BUFFER_COUNT,
+                                           IoUringLoop::BUFFER_GROUP, 0, &rc);
+  if (s.bufferRing == nullptr) {
+    std::cerr << "Failed to create provided buffer ring." << std::endl;
+    printError(-rc);
+    return false;
+  }
+
+  s.buffers.resize(IoUringLoop::BUFFER_COUNT * IoUringLoop::BUFFER_SIZE);
+  int mask = ::io_uring_buf_ring_mask(IoUringLoop::BUFFER_COUNT);
+  for (unsigned int i = 0; i < IoUringLoop::BUFFER_COUNT; i++) {
+    ::io_uring_buf_ring_add(s.bufferRing,
+                            s.buffers.data() + i * IoUringLoop::BUFFER_SIZE,
+                            IoUringLoop::BUFFER_SIZE,
+                            static_cast<unsigned short>(i), mask, i);
+  }
+  ::io_uring_buf_ring_advance(s.bufferRing, IoUringLoop::BUFFER_COUNT);
+
+  s.listenSocket = listenSocket;
+  return true;
+}
+
+/**
+ * A multishot accept creates one completion for each accepted connection.
+ */
+static void armAccept(IoUringLoop::State &s) {
+  io_uring_sqe *sqe = getSqe(&s.ring);
+  ::io_uring_prep_multishot_accept(sqe, s.listenSocket, nullptr, nullptr, 0);
+  ::io_uring_sqe_set_data64(sqe, encode(Operation::Accept, s.listenSocket));
+}
+
+/**
+ * A multishot receive creates one completion for each received chunk. The
+ * kernel selects the buffer from the provided buffer group.
+ */
+static void armReceive(IoUringLoop::State &s, int socket) {
+  io_uring_sqe *sqe = getSqe(&s.ring);
+  ::io_uring_prep_recv_multishot(sqe, socket, nullptr, 0, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = IoUringLoop::BUFFER_GROUP;
+  ::io_uring_sqe_set_data64(sqe, encode(Operation::Receive, socket));
+  s.connections[socket].receiving = true;
+}
+
+static void returnBuffer(IoUringLoop::State &s, unsigned short bufferId) {
+  ::io_uring_buf_ring_add(
+      s.bufferRing, s.buffers.data() + bufferId * IoUringLoop::BUFFER_SIZE,
+      IoUringLoop::BUFFER_SIZE, bufferId,
+      ::io_uring_buf_ring_mask(IoUringLoop::BUFFER_COUNT), s.returnedBuffers);
+  s.returnedBuffers++;
+}
+
+/**
+ * Queues the collected sends. Sends to the same socket are linked, so the
+ * kernel executes them in order.
+ */
+static void submitSends(IoUringLoop::State &s) {
+  std::stable_sort(s.sends.begin(), s.sends.end(),
+                   [](const PendingSend &a, const PendingSend &b) {
+                     return a.socket < b.socket;
+                   });
+  for (size_t i = 0; i < s.sends.size(); i++) {
+    const PendingSend &send = s.sends[i];
+    io_uring_sqe *sqe = getSqe(&s.ring);
+    // MSG_WAITALL lets the kernel retry short sends.
+    ::io_uring_prep_send(
+        sqe, send.socket,
+        s.buffers.data() + send.bufferId * IoUringLoop::BUFFER_SIZE,
+        send.length, MSG_WAITALL);
+    ::io_uring_sqe_set_data64(
+        sqe, encode(Operation::Send, send.socket, send.bufferId));
+    if (i + 1 < s.sends.size() && s.sends[i + 1].socket == send.socket) {
+      sqe->flags |= IOSQE_IO_LINK;
+    }
+  }
+  s.sends.clear();
+}
+
+static void handleCompletion(IoUringLoop::State &s, io_uring_cqe *cqe) {
+  uint64_t data = ::io_uring_cqe_get_data64(cqe);
+  bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+  switch (decodeOperation(data)) {
+    case Operation::Accept: {
+      if (cqe->res >= 0) {
+        armReceive(s, cqe->res);
+      } else {
+        std::cerr << "Failed to accept." << std::endl;
+        printError(-cqe->res);
+      }
+      if (!more) {
+        // the multishot accept has been terminated
+        armAccept(s);
+      }
+      break;
+    }
+    case Operation::Receive: {
+      int socket = decodeSocket(data);
+      Connection &connection = s.connections[socket];
+      if (cqe->res > 0) {
+        unsigned short bufferId =
+            static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        // echo the data of the buffer
+        s.sends.push_back(
+            {socket, bufferId, static_cast<unsigned int>(cqe->res)});
+        connection.pendingSends++;
+      } else if (cqe->res == -ENOBUFS) {
+        // all buffers are in use. Rearm once buffers have been returned.
+        s.starved.push_back(socket);
+      } else {
+        // reached end of file or an error occurred
+        if (cqe->res < 0) {
+          std::cerr << "Failed to read" << std::endl;
+          printError(-cqe->res);
+        }
+        connection.closing = true;
+      }
+      if (!more) {
+        connection.receiving = false;
+        if (!connection.closing && cqe->res != -ENOBUFS) {
+          armReceive(s, socket);
+        }
+      }
+      break;
+    }
+    case Operation::Send: {
+      int socket = decodeSocket(data);
+      Connection &connection = s.connections[socket];
+      returnBuffer(s, decodeBufferId(data));
+      connection.pendingSends--;
+      if (cqe->res < 0) {
+        // -ECANCELED if a previous linked send failed
+        if (cqe->res != -ECANCELED) {
+          std::cerr << "Failed to write" << std::endl;
+          printError(-cqe->res);
+        }
+        if (!connection.closing) {
+          connection.closing = true;
+          // terminates the armed receive
+          ::shutdown(socket, SHUT_RDWR);
+        }
+      }
+      break;
+    }
+  }
+}
+
+void IoUringLoop::run(const std::atomic_bool &enabled) {
+  State &s = *this->state;
+
+  armAccept(s);
+
+  // wake up regulary to check whether the loop shall stop.
+  __kernel_timespec timeout = {};
+  timeout.tv_sec = 0;
+  timeout.tv_nsec = 100000000;  // 100ms
+
+  while (enabled) {
+    io_uring_cqe *cqe = nullptr;
+    int rc = ::io_uring_submit_and_wait_timeout(&s.ring, &cqe, 1, &timeout,
+                                                nullptr);
+    if (rc < 0 && rc != -ETIME && rc != -EINTR) {
+      std::cerr << "Failed to wait for completions." << std::endl;
+      printError(-rc);
+      break;
+    }
+
+    // process all available completions
+    unsigned int head;
+    unsigned int count = 0;
+    io_uring_for_each_cqe(&s.ring, head, cqe) {
+      handleCompletion(s, cqe);
+      count++;
+    }
+    ::io_uring_cq_advance(&s.ring, count);
+
+    // give the buffers of the completed sends back to the kernel
+    if (s.returnedBuffers > 0) {
+      ::io_uring_buf_ring_advance(s.bufferRing, s.returnedBuffers);
+      s.returnedBuffers = 0;
+      for (int socket : s.starved) {
+        armReceive(s, socket);
+      }
+      s.starved.clear();
+    }
+
+    submitSends(s);
+
+    // close connections without pending operations
+    for (auto it = s.connections.begin(); it != s.connections.end();) {
+      Connection &connection = it->second;
+      if (connection.closing && !connection.receiving &&
+          connection.pendingSends == 0) {
+        ::close(it->first);
+        it = s.connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // close all connections. The ring is destroyed with the loop, which cancels
+  // all pending operations.
+  for (auto &entry : s.connections) {
+    ::close(entry.first);
+  }
+  s.connections.clear();
+}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
+
+#else
+// io_uring is not available. The server uses the POSIX backend.
+
+#include "IoUringLoop.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+struct IoUringLoop::State {};
+
+IoUringLoop::IoUringLoop() : state{new State()} {}
+
+IoUringLoop::~IoUringLoop() {}
+
+bool IoUringLoop::isSupported() { return false; }
+
+bool IoUringLoop::open(int listenSocket) { return false; }
+
+void IoUringLoop::run(const std::atomic_bool &enabled) {}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
+#endif
@@ -0,0 +1,123 @@
+#include "LatencyHistogram.h"
+
+#include <limits>  // std::numeric_limits
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+LatencyHistogram::LatencyHistogram()
+    : counts((64 - LatencyHistogram::SUB_BUCKET_BITS + 1) *
+                 LatencyHistogram::SUB_BUCKET_COUNT,
+             0),
+      count{0},
+      min{std::numeric_limits<std::uint64_t>::max()},
+      max{0},
+      sum{0} {}
+
+/**
+ * Returns the position of the highest set bit. The value must not be 0.
+ */
+static unsigned int getHighestBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - static_cast<unsigned int>(__builtin_clzll(value));
+#else
+  unsigned int bit = 0;
+  while (value >>= 1) {
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+/**
+ * Values below 2 * SUB_BUCKET_COUNT have their own bucket. Larger values are
+ * shifted right until they fit into [SUB_BUCKET_COUNT, 2 * SUB_BUCKET_COUNT),
+ * so each power of two is split into SUB_BUCKET_COUNT buckets.
+ */
+std::size_t LatencyHistogram::getIndex(std::uint64_t value) {
+  if (value < 2 * LatencyHistogram::SUB_BUCKET_COUNT) {
+    return static_cast<std::size_t>(value);
+  }
+  unsigned int shift =
+      getHighestBit(value) - LatencyHistogram::SUB_BUCKET_BITS;
+  std::uint64_t top = value >> shift;
+  return static_cast<std::size_t>(LatencyHistogram::SUB_BUCKET_COUNT * shift +
+                                  top);
+}
+
+std::uint64_t LatencyHistogram::getHighestValue(std::size_t index) {
+  if (index < 2 * LatencyHistogram::SUB_BUCKET_COUNT) {
+    return index;
+  }
+  unsigned int shift =
+      static_cast<unsigned int>(index / LatencyHistogram::SUB_BUCKET_COUNT) -
+      1;
+  std::uint64_t top = index - LatencyHistogram::SUB_BUCKET_COUNT * shift;
+  return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t value) {
+  this->counts[LatencyHistogram::getIndex(value)]++;
+  this->count++;
+  this->sum += static_cast<double>(value);
+  if (value < this->min) {
+    this->min = value;
+  }
+  if (value > this->max) {
+    this->max = value;
+  }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (std::size_t i = 0; i < this->counts.size(); i++) {
+    this->counts[i] += other.counts[i];
+  }
+  this->count += other.count;
+  this->sum += other.sum;
+  if (other.min < this->min) {
+    this->min = other.min;
+  }
+  if (other.max > this->max) {
+    this->max = other.max;
+  }
+}
+
+std::uint64_t LatencyHistogram::getCount() const { return this->count; }
+
+std::uint64_t LatencyHistogram::getMin() const {
+  return this->count == 0 ? 0 : this->min;
+}
+
+std::uint64_t LatencyHistogram::getMax() const { return this->max; }
+
+double LatencyHistogram::getMean() const {
+  return this->count == 0 ? 0 : this->sum / static_cast<double>(this->count);
+}
+
+std::uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+  if (this->count == 0) {
+    return 0;
+  }
+  // the rank of the value. At least the first value is counted.
+  double rank = percentile / 100.0 * static_cast<double>(this->count);
+  std::uint64_t target = static_cast<std::uint64_t>(rank);
+  if (static_cast<double>(target) < rank || target == 0) {
+    target++;
+  }
+
+  std::uint64_t counted = 0;
+  for (std::size_t i = 0; i < this->counts.size(); i++) {
+    counted += this->counts[i];
+    if (counted >= target) {
+      std::uint64_t value = LatencyHistogram::getHighestValue(i);
+      // the bucket might exceed the largest recorded value
+      return value < this->max ? value : this->max;
+    }
+  }
+  return this->max;
+}
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
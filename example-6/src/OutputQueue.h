@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "BufferPool.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace socket {
+
+/**
+ * The pending output of a connection. The queue holds views of pooled
+ * buffers, so queued data is not copied, and sends as many of them as
+ * possible with a single writev().
+ *
+ * The queue applies backpressure with two watermarks: it is full once the
+ * pending bytes reach the high watermark and stays full until they have been
+ * drained to the low watermark. The connection stops reading while the queue
+ * is full, so a slow peer cannot make the queue grow without bounds.
+ */
+class OutputQueue {
+ public:  // const
+  // pending bytes at which the queue becomes full (1MiByte)
+  static const std::size_t HIGH_WATERMARK = 1024 * 1024;
+  // pending bytes at which a full queue accepts data again (256KiByte)
+  static const std::size_t LOW_WATERMARK = 256 * 1024;
+  // maximum number of buffers passed to a single writev()
+  static const unsigned int MAX_WRITE_BUFFERS = 64;
+
+ public:  // methods
+  /**
+   * Appends the view. Empty views are ignored.
+   */
+  void push(BufferView view);
+  /**
+   * Returns true if there is no pending data.
+   */
+  bool empty() const;
+  /**
+   * Returns the number of pending bytes.
+   */
+  std::size_t size() const;
+  /**
+   * Returns true if the pending bytes reached the high watermark and have not
+   * been drained to the low watermark yet.
+   */
+  bool isFull() const;
+  /**
+   * Removes the given number of bytes from the front of the queue.
+   */
+  void consume(std::size_t count);
+  /**
+   * Drops all pending data.
+   */
+  void clear();
+#ifndef _WIN32
+  /**
+   * Writes the pending data with writev() until the queue is empty or the
+   * socket would block.
+   *
+   * @return 1 if the queue is empty, 0 if the socket would block and -1 if an
+   * error occured.
+   */
+  int flush(int socket);
+#endif
+
+ private:  // fields
+  /**
+   * The pending views. buffers[head] is the next view to send. The vector
+   * keeps its capacity, so queueing does not allocate in the steady state.
+   */
+  std::vector<BufferView> buffers;
+  std::size_t head = 0;
+  /**
+   * The number of bytes of buffers[head] which have already been sent.
+   */
+  std::size_t offset = 0;
+  std::size_t pending = 0;
+  bool full = false;
+};
+
+}  // namespace socket
+}  // namespace cpp
+}  // namespace ggolbik
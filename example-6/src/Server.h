@@ -1,14 +1,20 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #endif
 
+#include "ConnectionRegistry.h"
+#include "IoUringLoop.h"
+#include "Worker.h"
+
 namespace ggolbik {
 namespace cpp {
 namespace socket {
@@ -20,6 +26,39 @@ class Server {
  private:  // type definitions
   typedef char byte;
 
+ private:  // type definitions
+#ifndef _WIN32
+  /**
+   * A listen socket bound to the port and the thread which accepts and serves
+   * its connections.
+   */
+  struct Shard {
+    int listenSocket = -1;
+    std::thread thread;
+    /**
+     * The io_uring loop if the io_uring backend is used.
+     */
+    std::unique_ptr<IoUringLoop> ioUringLoop;
+  };
+#endif
+
+ public:  // type definitions
+  /**
+   * Defines the I/O interface used to serve the connections.
+   */
+  enum class Backend {
+    /**
+     * select() and accept() on the server thread of each shard and a worker
+     * thread with read() and write() for each connection.
+     */
+    Posix,
+    /**
+     * An io_uring loop per shard serves the connections of the shard. Falls
+     * back to Posix if io_uring is not available.
+     */
+    IoUring
+  };
+
  public:  // construction/destruction/operators
   /**
    * @param port define port of server
@@ -30,6 +69,22 @@ class Server {
    * @param interfaceAddress the interface
    */
   Server(unsigned short port, std::string interfaceAddress);
+  /**
+   * @param port define port of server
+   * @param interfaceAddress the interface
+   * @param backend the I/O interface used to serve the connections
+   */
+  Server(unsigned short port, std::string interfaceAddress, Backend backend);
+  /**
+   * @param port define port of server
+   * @param interfaceAddress the interface
+   * @param backend the I/O interface used to serve the connections
+   * @param shardCount the number of listen sockets bound to the port with
+   * SO_REUSEPORT. Each shard has its own thread which accepts and serves its
+   * connections. 0 uses one shard per core. Windows always uses one shard.
+   */
+  Server(unsigned short port, std::string interfaceAddress, Backend backend,
+         unsigned int shardCount);
   /**
    * Move constructor
    */
@@ -65,8 +120,39 @@ class Server {
    * Close the server socket.
    */
   void close();
+  /**
+   * Returns the I/O interface used to serve the connections.
+   */
+  Backend getBackend();
+  /**
+   * Returns the number of listen sockets.
+   */
+  unsigned int getShardCount();
+  /**
+   * Enables length-prefixed framing. The workers echo complete frames and
+   * answer all frames of one read with a single write. The io_uring backend
+   * echoes the raw stream, which keeps the frames intact. Must be called
+   * before open().
+   */
+  void setFraming(bool framing);
+  /**
+   * Sets how the workers answer the received data. The io_uring backend
+   * always echoes the raw stream. Must be called before open().
+   */
+  void setWorkerMode(Worker::Mode mode);
+  /**
+   * Returns the number of open connections served by workers. Finished
+   * workers are reaped by the server thread within one select() timeout.
+   */
+  std::size_t getConnectionCount();
+  /**
+   * Returns the number of connections which have been passed to workers since
+   * the server has been created.
+   */
+  std::size_t getTotalConnectionCount();
 
  private:  // helper methods
+#ifdef _WIN32
   /**
    * Close the socket and sets the socket member to an invalid value.
    *
@@ -77,6 +163,32 @@ class Server {
    * The method executed by the server thread.
    */
   void run();
+  /**
+   * The method executed by the server thread if the io_uring backend is used.
+   */
+  void runIoUring();
+#else
+  /**
+   * Close the socket of the shard and sets the socket member to an invalid
+   * value.
+   *
+   * @return true if socket could be closed, otherwise false.
+   */
+  bool closeSocket(Shard &shard);
+  /**
+   * Joins the threads of the shards, closes their sockets and removes them.
+   */
+  void closeShards();
+  /**
+   * The method executed by the thread of a shard.
+   */
+  void run(Shard *shard);
+  /**
+   * The method executed by the thread of a shard if the io_uring backend is
+   * used.
+   */
+  void runIoUring(Shard *shard);
+#endif
 
  private:  // fields
   std::mutex mutexPublicMethods;
@@ -97,17 +209,40 @@ class Server {
    * Whether the server is running.
    */
   std::atomic_bool running;
+  /**
+   * The I/O interface used to serve the connections.
+   */
+  Backend backend;
+  /**
+   * How the workers answer the received data.
+   */
+  Worker::Mode workerMode;
+  /**
+   * The workers of the accepted connections.
+   */
+  ConnectionRegistry connections;
+#ifdef _WIN32
   /**
    * The thread used to listen for connections.
    */
   std::thread serverThread;
-/**
- * The current listen socket.
- */
-#ifdef _WIN32
+  /**
+   * The current listen socket.
+   */
   SOCKET listenSocket;
 #else
-  int listenSocket;
+  /**
+   * The requested number of shards. 0 uses one shard per core.
+   */
+  unsigned int shardCount;
+  /**
+   * The listen sockets and their threads while the server is open.
+   */
+  std::vector<std::unique_ptr<Shard>> shards;
+  /**
+   * The number of shard threads which have not stopped yet.
+   */
+  std::atomic<unsigned int> runningShards;
 #endif
 };
 
@@ -10,8 +10,9 @@
 #include <sys/time.h>    // struct timeval
 #include <unistd.h>      // ::close(int), ::read(int, void*, size_t)
 
-#include <cerrno>    // errno
-#include <cstring>   // ::strerror_r(...)
+#include <algorithm>  // std::max(...)
+#include <cerrno>     // errno
+#include <cstring>    // ::strerror_r(...)
 #include <iostream>  // std::cout(...) ; std::cerr(...)
 #include <string>    // std::string
 #include <vector>    // std::vector
@@ -26,11 +27,22 @@ namespace socket {
 Server::Server(unsigned short port) : Server(port, "") {}
 
 Server::Server(unsigned short port, std::string interfaceAddress)
+    : Server(port, interfaceAddress, Backend::Posix) {}
+
+Server::Server(unsigned short port, std::string interfaceAddress,
+               Backend backend)
+    : Server(port, interfaceAddress, backend, 1) {}
+
+Server::Server(unsigned short port, std::string interfaceAddress,
+               Backend backend, unsigned int shardCount)
     : port{port},
       interfaceAddress{interfaceAddress},
       enabled{false},
       running{false},
-      listenSocket{-1} {}
+      backend{backend},
+      workerMode{Worker::Mode::Echo},
+      shardCount{shardCount},
+      runningShards{0} {}
 
 Server::~Server() { this->close(); }
 
@@ -221,22 +233,22 @@ static int createSocket(sockaddr_in &socketAddress) {
  * @return true on success. On error, false is returned, and errno is set
  * appropriately.
  */
-bool Server::closeSocket() {
+bool Server::closeSocket(Shard &shard) {
   // lock mutex to set listen socket appropriately
   std::unique_lock<std::mutex> lock(this->mutexCloseSocket);
 
   // check if socket is valid
-  if (this->listenSocket == -1) {
+  if (shard.listenSocket == -1) {
     // invalid socket
     // socket seems to be already closed.
     return true;
   }
 
   // close socket
-  int closed = ::close(this->listenSocket) != -1;
+  int closed = ::close(shard.listenSocket) != -1;
 
   // set socket to an invalid value.
-  this->listenSocket = -1;
+  shard.listenSocket = -1;
 
   // return whether socket has been closed successfully.
   return closed;
@@ -258,7 +270,10 @@ bool Server::closeSocket() {
  * unexpected data comes in, it may confuse your server, but while this is
  * possible, it is not likely.
  *
- * SO_REUSEPORT: SO_REUSEADDR socket option already allows multiple UDP sockets
+ * SO_REUSEPORT: Allows multiple sockets to be bound to the same address and
+ * port. For TCP the kernel distributes the incoming connections across the
+ * listen sockets, which is used to shard the server.
+ * SO_REUSEADDR socket option already allows multiple UDP sockets
  * to be bound to, and accept datagrams on, the same UDP port. However, by
  * contrast with SO_REUSEPORT, SO_REUSEADDR does not prevent port hijacking and
  * does not distribute datagrams evenly across the receiving threads.
@@ -284,8 +299,14 @@ static bool setSocketOptions(int socket) {
   int enable = 1;
   // On success, zero is returned. On error, -1 is returned, and errno is set
   // appropriately.
-  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &enable,
-                   sizeof(int)) != 0) {
+  // optname is a single option and not a bit mask, so each option requires its
+  // own call.
+  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) !=
+      0) {
+    return false;
+  }
+  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) !=
+      0) {
     return false;
   }
   return true;
@@ -561,81 +582,128 @@ static int accept(int socket, sockaddr_in &peerAddress) {
   return ::accept(socket, (sockaddr *)&peerAddress, (socklen_t *)&addrlen);
 }
 
-bool Server::open() {
-  // lock mutex
-  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
-
-  // check if server is already listening
-  if (this->enabled) {
-    std::cerr << "Server is already listening." << std::endl;
-    return false;
-  }
-
-  // create a socket address
-  sockaddr_in address;
-  if (!createSocketAddress(this->port, this->interfaceAddress, address)) {
-    std::cerr << "Failed to create socket address." << std::endl;
-    printError();
-    return false;
-  }
-
+/**
+ * Creates a non-blocking listen socket bound to the address.
+ *
+ * @return the socket or -1 on error.
+ */
+static int openListenSocket(sockaddr_in &address) {
   // Create a SOCKET for the server to listen for client
-  this->listenSocket = createSocket(address);
+  int listenSocket = createSocket(address);
   // Check for errors to ensure that the socket is a valid socket.
-  if (this->listenSocket == -1) {
+  if (listenSocket == -1) {
     std::cerr << "Create socket failed." << std::endl;
     printError();
-    return false;
+    return -1;
   }
 
   // Allow socket descriptor to be reuseable (Forecefully attaching socket to
   // the port)
-  if (!setSocketOptions(this->listenSocket)) {
+  if (!setSocketOptions(listenSocket)) {
     std::cerr << "Set socket options failed." << std::endl;
     printError();
-    if (!this->closeSocket()) {
-      printError();
-    }
-    return false;
+    ::close(listenSocket);
+    return -1;
   }
 
   // set socket to be nonblocking.
-  if (!setSocketModeNonBlocking(this->listenSocket)) {
+  if (!setSocketModeNonBlocking(listenSocket)) {
     std::cerr << "Set socket to be non-blocking failed." << std::endl;
     printError();
-    if (!this->closeSocket()) {
-      printError();
-    }
-    return false;
+    ::close(listenSocket);
+    return -1;
   }
 
   // bind the socket
-  if (!bindSocket(this->listenSocket, address)) {
+  if (!bindSocket(listenSocket, address)) {
     std::cerr << "Bind failed." << std::endl;
     printError();
-    if (!this->closeSocket()) {
-      printError();
-    }
-    return false;
+    ::close(listenSocket);
+    return -1;
   }
 
   // start listening
-  if (!listenOnSocket(this->listenSocket)) {
+  if (!listenOnSocket(listenSocket)) {
     std::cerr << "Listen failed." << std::endl;
     printError();
-    if (!this->closeSocket()) {
-      printError();
-    }
+    ::close(listenSocket);
+    return -1;
+  }
+
+  return listenSocket;
+}
+
+bool Server::open() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  // check if server is already listening
+  if (this->enabled) {
+    std::cerr << "Server is already listening." << std::endl;
     return false;
   }
 
+  // create a socket address
+  sockaddr_in address;
+  if (!createSocketAddress(this->port, this->interfaceAddress, address)) {
+    std::cerr << "Failed to create socket address." << std::endl;
+    printError();
+    return false;
+  }
+
+  // Use the POSIX backend if io_uring is not available.
+  if (this->backend == Backend::IoUring && !IoUringLoop::isSupported()) {
+    std::cout << "io_uring is not available. Using POSIX backend."
+              << std::endl;
+    this->backend = Backend::Posix;
+  }
+
+  unsigned int count = this->shardCount;
+  if (count == 0) {
+    // hardware_concurrency returns 0 if the value is not computable.
+    count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // each shard has its own listen socket bound to the same port. The kernel
+  // distributes the connections across the sockets (SO_REUSEPORT).
+  for (unsigned int i = 0; i < count; i++) {
+    std::unique_ptr<Shard> shard(new Shard());
+    shard->listenSocket = openListenSocket(address);
+    if (shard->listenSocket == -1) {
+      this->closeShards();
+      return false;
+    }
+
+    // create the io_uring loop of the shard
+    if (this->backend == Backend::IoUring) {
+      shard->ioUringLoop = std::unique_ptr<IoUringLoop>(new IoUringLoop());
+      if (!shard->ioUringLoop->open(shard->listenSocket)) {
+        std::cerr << "Failed to open io_uring loop." << std::endl;
+        shard->ioUringLoop.reset();
+        if (!this->closeSocket(*shard)) {
+          printError();
+        }
+        this->closeShards();
+        return false;
+      }
+    }
+    this->shards.push_back(std::move(shard));
+  }
+
   // Update status
   this->enabled = true;
   this->running = true;
-
-  // start accept thread
-  this->serverThread = std::thread(&Server::run, this);
-  std::cout << "Server thread ID: " << this->serverThread.get_id() << std::endl;
+  this->runningShards = count;
+
+  // start accept threads
+  for (std::unique_ptr<Shard> &shard : this->shards) {
+    if (this->backend == Backend::IoUring) {
+      shard->thread = std::thread(&Server::runIoUring, this, shard.get());
+    } else {
+      shard->thread = std::thread(&Server::run, this, shard.get());
+    }
+    std::cout << "Server thread ID: " << shard->thread.get_id() << std::endl;
+  }
 
   return true;
 }
@@ -656,21 +724,31 @@ void Server::close() {
     // signal stop
     this->enabled = false;
 
-    std::cout << "Join server thread" << std::endl;
+    std::cout << "Join server threads" << std::endl;
 
-    // wait until thread stops
-    if (this->serverThread.joinable()) {
-      this->serverThread.join();
+    // wait until the threads stop and close the listen sockets
+    this->closeShards();
+
+    this->running = false;
+  }
+}
+
+void Server::closeShards() {
+  for (std::unique_ptr<Shard> &shard : this->shards) {
+    if (shard->thread.joinable()) {
+      shard->thread.join();
     }
 
     // should already be closed by server thread
-    if (!this->closeSocket()) {
+    if (!this->closeSocket(*shard)) {
       std::cerr << "Failed to close socket." << std::endl;
       printError();
     }
 
-    this->running = false;
+    // dispose the ring
+    shard->ioUringLoop.reset();
   }
+  this->shards.clear();
 }
 
 /**
@@ -678,14 +756,16 @@ void Server::close() {
  * #include <sys/socket.h> for accept
  * #include <vector> for std::vector
  */
-void Server::run() {
+void Server::run(Shard *shard) {
   std::cout << "Listening on port " << this->port << std::endl;
 
-  std::vector<std::shared_ptr<Worker>> workers = {};
-
   while (this->enabled) {
+    // close the workers of finished connections. The select timeout limits the
+    // delay if no connections arrive.
+    this->connections.reap();
+
     // select returns 0 if timeout or -1 if error
-    int rc = select(this->listenSocket);
+    int rc = select(shard->listenSocket);
     if (rc < 0) {
       // select failed
       printError();
@@ -704,7 +784,7 @@ void Server::run() {
 
     // Accept a client socket
     sockaddr_in peerAddress;
-    rc = accept(this->listenSocket, peerAddress);
+    rc = accept(shard->listenSocket, peerAddress);
     if (rc == -1) {
       // an error occurred or the connection has been closed before accept could
       // be executed
@@ -729,30 +809,74 @@ void Server::run() {
     }
 
     // pass the accepted client socket to a worker thread
-    std::shared_ptr<Worker> worker(new Worker(clientSocket));
-    // put worker in list to be able to stop all workers
-    workers.push_back(worker);
+    std::shared_ptr<Worker> worker(new Worker(clientSocket, this->workerMode));
+    // put worker in the registry to be able to stop all workers
+    this->connections.insert(worker);
     // start worker to read
     worker->start();
   }
 
   // stop all workers
-  for (std::shared_ptr<Worker> worker : workers) {
-    if (worker) {
-      worker->close();
-    }
+  this->connections.closeAll();
+
+  // close socket
+  if (!this->closeSocket(*shard)) {
+    std::cerr << "Failed to close socket." << std::endl;
+    printError();
+  }
+
+  // the server is running until the last shard stops
+  if (--this->runningShards == 0) {
+    this->running = false;
   }
+  std::cout << "Stopped listening on port " << this->port << std::endl;
+}
+
+void Server::runIoUring(Shard *shard) {
+  std::cout << "Listening on port " << this->port << " (io_uring)"
+            << std::endl;
+
+  // the loop accepts the connections and serves them until the server is
+  // disabled.
+  shard->ioUringLoop->run(this->enabled);
 
   // close socket
-  if (!this->closeSocket()) {
+  if (!this->closeSocket(*shard)) {
     std::cerr << "Failed to close socket." << std::endl;
     printError();
   }
 
-  this->running = false;
+  // the server is running until the last shard stops
+  if (--this->runningShards == 0) {
+    this->running = false;
+  }
   std::cout << "Stopped listening on port " << this->port << std::endl;
 }
 
+Server::Backend Server::getBackend() { return this->backend; }
+
+void Server::setFraming(bool framing) {
+  this->setWorkerMode(framing ? Worker::Mode::Framing : Worker::Mode::Echo);
+}
+
+void Server::setWorkerMode(Worker::Mode mode) {
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  this->workerMode = mode;
+}
+
+unsigned int Server::getShardCount() {
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  return this->shards.empty() ? this->shardCount : this->shards.size();
+}
+
+std::size_t Server::getConnectionCount() {
+  return this->connections.getLiveCount();
+}
+
+std::size_t Server::getTotalConnectionCount() {
+  return this->connections.getTotalCount();
+}
+
 }  // namespace socket
 }  // namespace cpp
 }  // namespace ggolbik
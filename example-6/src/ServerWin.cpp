@@ -22,10 +22,21 @@ namespace socket {
 Server::Server(unsigned short port) : Server(port, "") {}
 
 Server::Server(unsigned short port, std::string interfaceAddress)
+    : Server(port, interfaceAddress, Backend::Posix) {}
+
+Server::Server(unsigned short port, std::string interfaceAddress,
+               Backend backend)
+    : Server(port, interfaceAddress, backend, 1) {}
+
+// io_uring and SO_REUSEPORT are not available on Windows.
+Server::Server(unsigned short port, std::string interfaceAddress,
+               Backend backend, unsigned int shardCount)
     : port{port},
       interfaceAddress{interfaceAddress},
       enabled{false},
       running{false},
+      backend{Backend::Posix},
+      workerMode{Worker::Mode::Echo},
       listenSocket{INVALID_SOCKET} {}
 
 Server::~Server() { this->close(); }
@@ -375,9 +386,11 @@ void Server::close() {
 void Server::run() {
   std::cout << "Listening on port " << this->port << std::endl;
 
-  std::vector<std::shared_ptr<Worker>> workers = {};
-
   while (this->enabled) {
+    // close the workers of finished connections. The select timeout limits the
+    // delay if no connections arrive.
+    this->connections.reap();
+
     // select returns 0 if timeout or -1 if error
     int rc = select(this->listenSocket);
     if (rc < 0) {
@@ -420,19 +433,15 @@ void Server::run() {
     }
 
     // pass the accepted client socket to a worker thread
-    std::shared_ptr<Worker> worker(new Worker(clientSocket));
-    // put worker in list to be able to stop all workers
-    workers.push_back(worker);
+    std::shared_ptr<Worker> worker(new Worker(clientSocket, this->workerMode));
+    // put worker in the registry to be able to stop all workers
+    this->connections.insert(worker);
     // start worker to read
     worker->start();
   }
 
   // stop all workers
-  for (std::shared_ptr<Worker> worker : workers) {
-    if (worker) {
-      worker->close();
-    }
-  }
+  this->connections.closeAll();
 
   // close socket
   if (!this->closeSocket()) {
@@ -444,6 +453,29 @@ void Server::run() {
   std::cout << "Stopped listening on port " << this->port << std::endl;
 }
 
+Server::Backend Server::getBackend() { return this->backend; }
+
+void Server::setFraming(bool framing) {
+  this->setWorkerMode(framing ? Worker::Mode::Framing : Worker::Mode::Echo);
+}
+
+void Server::setWorkerMode(Worker::Mode mode) {
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  this->workerMode = mode;
+}
+
+unsigned int Server::getShardCount() { return 1; }
+
+std::size_t Server::getConnectionCount() {
+  return this->connections.getLiveCount();
+}
+
+std::size_t Server::getTotalConnectionCount() {
+  return this->connections.getTotalCount();
+}
+
+void Server::runIoUring() { this->run(); }
+
 }  // namespace socket
 }  // namespace cpp
 }  // namespace ggolbik
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -10,6 +11,10 @@
 #include <winsock2.h>
 #endif
 
+#include "BufferPool.h"
+#include "Frame.h"
+#include "OutputQueue.h"
+
 namespace ggolbik {
 namespace cpp {
 namespace socket {
@@ -18,12 +23,36 @@ namespace socket {
  *
  */
 class Worker {
+ public:  // type definitions
+  /**
+   * How the worker answers the received data.
+   */
+  enum class Mode {
+    // echo the raw stream and log the received data
+    Echo,
+    // echo length-prefixed frames. All frames of one read are echoed with a
+    // single write.
+    Framing,
+    // echo the raw stream without inspecting it
+    Forward,
+    // echo the raw stream with splice() through a pipe, so the data is not
+    // copied into user space. Falls back to Forward if splice() is not
+    // available.
+    Splice
+  };
+
  private:  // type definitions
   typedef char byte;
 
  private:  // const
   // 64KiByte
   static const unsigned int MAX_BUFFER_SIZE = 65535;
+  // number of reads before the responses are sent. Limits the data which is
+  // read from a fast peer before the worker writes.
+  static const unsigned int MAX_READS_PER_WAKEUP = 16;
+  // requested capacity of the splice pipe (1MiByte). The kernel might limit
+  // the size to /proc/sys/fs/pipe-max-size.
+  static const int PIPE_SIZE = 1024 * 1024;
 
  public:  // construction/destruction/operators
 /**
@@ -33,6 +62,14 @@ class Worker {
   Worker(SOCKET socket);
 #else
   Worker(int socket);
+#endif
+/**
+ * @param mode how the received data is answered.
+ */
+#ifdef _WIN32
+  Worker(SOCKET socket, Mode mode);
+#else
+  Worker(int socket, Mode mode);
 #endif
   /**
    * Move constructor
@@ -62,11 +99,85 @@ class Worker {
    * Stops the worker and closes the socket.
    */
   void close();
+  /**
+   * Sets the callback which is called once the connection has been closed.
+   * The callback is called by the worker thread and must not call close().
+   * Must be set before start().
+   */
+  void setFinishedCallback(std::function<void()> callback);
 
  private:  // helper methods
   void run();
-  bool readString(std::string &message);
+  /**
+   * Calls the finished callback. Subsequent calls do nothing.
+   */
+  void notifyFinished();
+#ifdef _WIN32
+  /**
+   * Reads the available data into a pooled buffer.
+   *
+   * @param view the read data. Shares the pooled buffer.
+   * @return false if the connection has been closed or an error occured.
+   */
+  bool read(BufferView &view);
+  /**
+   * Reads from the socket until at least one complete frame has been parsed.
+   *
+   * @param frames receives all complete frames. Cleared before reading.
+   * @return false if the connection has been closed, an error occured or the
+   * peer sent an invalid frame.
+   */
+  bool readFrames(std::vector<BufferView> &frames);
+#else
+  /**
+   * Reads the available data into a pooled buffer without blocking.
+   *
+   * @param view the read data. Shares the pooled buffer.
+   * @return the size of the read data, 0 if the read would block and -1 if
+   * the connection has been closed or an error occured.
+   */
+  int tryRead(BufferView &view);
+  /**
+   * Queues the response to the read data. In framing mode the complete frames
+   * of the data are queued as a single buffer.
+   *
+   * @return false if the peer sent an invalid frame.
+   */
+  bool handleData(const BufferView &data);
+  /**
+   * Echoes the stream with splice() until the connection is closed. The data
+   * is moved from the socket into a pipe and from the pipe back into the
+   * socket. The bounded pipe applies the backpressure.
+   *
+   * @return false if the pipe could not be created. Nothing has been read
+   * then.
+   */
+  bool runSplice();
+#endif
+  /**
+   * Copies the data into pooled buffers and writes them.
+   */
   bool write(const byte data[], size_t length);
+  /**
+   * Writes the bytes of the view without copying them. On Linux the view is
+   * queued and sent as far as the socket accepts it without blocking.
+   */
+  bool write(const BufferView &view);
+  /**
+   * Encodes the payloads into frames and sends them with a single write.
+   */
+  bool writeFrames(const std::vector<BufferView> &payloads);
+#ifndef _WIN32
+  /**
+   * Blocks until the socket is ready for the events or the worker is woken up
+   * by close().
+   *
+   * @param events POLLIN to wait for data or POLLOUT to wait for space in the
+   * send buffer.
+   * @return false if the worker has been woken up to stop or an error occured.
+   */
+  bool waitForSocket(short events);
+#endif
 
  private:  // fields
   std::mutex mutexPublicMethods;
@@ -75,9 +186,32 @@ class Worker {
   SOCKET clientSocket;
 #else
   int clientSocket;
+  /**
+   * An eventfd which is written by close() to wake up a blocking
+   * waitForSocket().
+   */
+  int wakeupFd;
 #endif
   std::atomic_bool enabled;
   std::atomic_bool running;
+  std::atomic_bool finished;
+  std::function<void()> finishedCallback;
+  Mode mode;
+  FrameParser frameParser;
+#ifndef _WIN32
+  /**
+   * The complete frames of the current read.
+   */
+  std::vector<BufferView> frames;
+  /**
+   * The responses which have not been sent yet.
+   */
+  OutputQueue outputQueue;
+#endif
+  /**
+   * The size of the next receive buffer (see BufferPool::getNextReadSize).
+   */
+  std::size_t readSize = BufferPool::MIN_SIZE;
   std::thread workerThread;
 };
 
@@ -3,14 +3,19 @@
 
 #include <errno.h>  // errno - is thread safe. On Linux, the global errno variable is thread-specific. POSIX requires that errno be threadsafe.
 #include <netinet/in.h>  // contains constants and structures needed for internet domain address.
+#include <fcntl.h>  // ::pipe2(...) ; ::splice(...) ; ::fcntl(...)
+#include <poll.h>          // ::poll(...) ; pollfd ; POLLIN ; POLLOUT
+#include <sys/eventfd.h>   // ::eventfd(...)
 #include <sys/socket.h>  // includes a number of definitions of structures needed for sockets.
 #include <unistd.h>  // ::close(int), ::read(int, void*, size_t)
 
+#include <cstdint>  // uint64_t
 #include <cstring>
 #include <iostream>
 #include <limits>  // for numeric_limits
 #include <memory>
 #include <string>
+#include <utility>  // std::move
 
 #include "Worker.h"
 
@@ -18,10 +23,29 @@ namespace ggolbik {
 namespace cpp {
 namespace socket {
 
-Worker::Worker(int socket)
-    : clientSocket{socket}, enabled{false}, running{false} {}
-
-Worker::~Worker() { this->close(); }
+/**
+ * The eventfd is created non-blocking, so close() never blocks on it.
+ *
+ * The method call
+ *   int eventfd(unsigned int initval, int flags);
+ * is defined in header <sys/eventfd.h>
+ */
+Worker::Worker(int socket) : Worker(socket, Mode::Echo) {}
+
+Worker::Worker(int socket, Mode mode)
+    : clientSocket{socket},
+      wakeupFd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+      enabled{false},
+      running{false},
+      finished{false},
+      mode{mode} {}
+
+Worker::~Worker() {
+  this->close();
+  if (this->wakeupFd != -1) {
+    ::close(this->wakeupFd);
+  }
+}
 
 /**
  * errno is thread safe. On Linux, the global errno variable is thread-specific.
@@ -52,6 +76,11 @@ bool Worker::start() {
     return false;
   }
 
+  if (this->wakeupFd == -1) {
+    std::cerr << "Invalid eventfd" << std::endl;
+    return false;
+  }
+
   this->enabled = true;
   this->running = true;
 
@@ -90,6 +119,13 @@ void Worker::close() {
   if (this->enabled) {
     this->enabled = false;
 
+    // wake up the worker thread if it waits for data
+    uint64_t value = 1;
+    if (::write(this->wakeupFd, &value, sizeof(value)) != sizeof(value) &&
+        errno != EAGAIN) {
+      printError();
+    }
+
     std::cout << "Join worker thread" << std::endl;
 
     if (this->workerThread.joinable()) {
@@ -111,20 +147,30 @@ void Worker::close() {
   }
 }
 
-bool Worker::readString(std::string &message) {
-  byte recvbuf[Worker::MAX_BUFFER_SIZE];
+/**
+ * The socket is non-blocking. A single read takes the data which is available
+ * and returns immediately if there is none.
+ *
+ * The method call
+ *   ssize_t read(int fd, void *buf, size_t count);
+ * is defined in header <unistd.h>
+ */
+int Worker::tryRead(BufferView &view) {
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte *recvbuf = buffer.data();
 
-  message = "";
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::read(this->clientSocket, recvbuf, Worker::MAX_BUFFER_SIZE);
+    rc = ::read(this->clientSocket, recvbuf, buffer.capacity());
     if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
       // The file descriptor fd refers to a file other than a socket and has
       // been marked nonblocking (O_NONBLOCK), and the read would block.
-      if (this->enabled) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      }
+      return 0;
+    } else if (rc < 0 && errno == EINTR) {
+      // interrupted by a signal
       continue;
     } else if (rc < 0) {
       // an error occurred
@@ -136,28 +182,97 @@ bool Worker::readString(std::string &message) {
       break;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
-      return true;
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
+      return static_cast<int>(rc);
     }
   }
 
+  return -1;
+}
+
+/**
+ * poll() waits for one of a set of file descriptors to become ready to perform
+ * I/O. The worker waits for the socket and the eventfd, so close() can
+ * interrupt the wait without a timeout.
+ *
+ * The method call
+ *   int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+ * is defined in header <poll.h>
+ */
+bool Worker::waitForSocket(short events) {
+  while (this->enabled) {
+    pollfd fds[2] = {};
+    fds[0].fd = this->clientSocket;
+    fds[0].events = events;
+    fds[1].fd = this->wakeupFd;
+    fds[1].events = POLLIN;
+
+    // a negative timeout waits until one of the descriptors is ready
+    int rc = ::poll(fds, 2, -1);
+    if (rc < 0 && errno == EINTR) {
+      // interrupted by a signal
+      continue;
+    } else if (rc < 0) {
+      printError();
+      std::cerr << "Failed to poll" << std::endl;
+      return false;
+    }
+
+    if (fds[1].revents != 0) {
+      // woken up by close()
+      return false;
+    }
+    // POLLERR and POLLHUP are reported by the next read or write.
+    return true;
+  }
   return false;
 }
 
 void Worker::run() {
   // Receive until the peer shuts down the connection
-  while (this->enabled) {
-    std::string message;
-    if (this->readString(message)) {
-      std::cout << "Data: " << message << std::endl;
-      if (!this->write(message.c_str(), message.size())) {
-        std::cerr << "Failed to send data to client" << std::endl;
+  bool connected = true;
+  if (this->mode == Mode::Splice && this->runSplice()) {
+    connected = false;
+  }
+  while (this->enabled && connected) {
+    // Read what is available, but stop reading while the peer does not take
+    // the responses. The socket is still polled for writability then.
+    for (unsigned int i = 0;
+         i < Worker::MAX_READS_PER_WAKEUP && !this->outputQueue.isFull(); i++) {
+      BufferView data;
+      int rc = this->tryRead(data);
+      if (rc == 0) {
+        break;
+      } else if (rc < 0 || !this->handleData(data)) {
+        connected = false;
+        break;
       }
-    } else {
-      // failed to read
+    }
+
+    // the responses of all reads are sent with as few writes as possible
+    if (this->outputQueue.flush(this->clientSocket) < 0) {
+      printError();
+      std::cerr << "Failed to send data to client" << std::endl;
+      break;
+    }
+    if (!connected) {
+      break;
+    }
+
+    short events = 0;
+    if (!this->outputQueue.isFull()) {
+      events |= POLLIN;
+    }
+    if (!this->outputQueue.empty()) {
+      events |= POLLOUT;
+    }
+    if (!this->waitForSocket(events)) {
       break;
     }
   }
+  this->outputQueue.clear();
 
   if (!closeSocket(this->clientSocket)) {
     printError();
@@ -169,54 +284,165 @@ void Worker::run() {
   this->running = false;
   std::cout << "Stopped Worker thread ID: " << this->workerThread.get_id()
             << std::endl;
+
+  this->notifyFinished();
+}
+
+void Worker::setFinishedCallback(std::function<void()> callback) {
+  this->finishedCallback = callback;
+}
+
+void Worker::notifyFinished() {
+  if (!this->finished.exchange(true) && this->finishedCallback) {
+    this->finishedCallback();
+  }
+}
+
+bool Worker::handleData(const BufferView &data) {
+  if (this->mode == Mode::Framing) {
+    // echo the frames of each read with a single buffer
+    if (!this->frameParser.feed(data)) {
+      std::cerr << "Received invalid frame" << std::endl;
+      return false;
+    }
+    this->frames.clear();
+    BufferView frame;
+    while (this->frameParser.next(frame)) {
+      this->frames.push_back(std::move(frame));
+    }
+    if (!this->frames.empty()) {
+      this->outputQueue.push(Frame::encode(this->frames));
+    }
+    this->frames.clear();
+  } else {
+    if (this->mode == Mode::Echo) {
+      std::cout << "Data: ";
+      std::cout.write(data.data(), data.size());
+      std::cout << std::endl;
+    }
+    // the response shares the read buffer
+    this->outputQueue.push(data);
+  }
+  return true;
 }
 
 /**
- * ssize_t write(int fd, const void *buf, size_t count);
+ * splice() moves data between two file descriptors without copying it between
+ * kernel address space and user address space. One of the descriptors must
+ * be a pipe, so the data is moved from the socket into a pipe and from the
+ * pipe into the socket.
+ *
+ * The method calls
+ *   int pipe2(int pipefd[2], int flags);
+ *   ssize_t splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out,
+ *                  size_t len, unsigned int flags);
+ * are defined in header <fcntl.h>
  */
-bool Worker::write(const byte data[], size_t length) {
-  if (length == 0) {
-    return true;
+bool Worker::runSplice() {
+  int pipeFds[2];
+  if (::pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    printError();
+    std::cerr << "Failed to create pipe. Forward without splice." << std::endl;
+    return false;
   }
 
-  size_t position = 0;
-  int remaining = length;
-
-  ssize_t rc;
-  while (this->enabled && remaining > 0) {
-    rc = ::write(this->clientSocket, data + (sizeof(byte) * position),
-                 remaining);
+  // a larger pipe moves more data per call. Keep the default size if the
+  // kernel refuses it.
+  int size = ::fcntl(pipeFds[1], F_SETPIPE_SZ, Worker::PIPE_SIZE);
+  if (size <= 0) {
+    size = ::fcntl(pipeFds[1], F_GETPIPE_SZ);
+  }
+  size_t capacity = size > 0 ? static_cast<size_t>(size) : 65536;
+
+  // the number of bytes in the pipe
+  size_t buffered = 0;
+  bool connected = true;
+  while (this->enabled && (connected || buffered > 0)) {
+    bool progress = false;
+
+    if (connected && buffered < capacity) {
+      ssize_t count =
+          ::splice(this->clientSocket, nullptr, pipeFds[1], nullptr,
+                   capacity - buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (count > 0) {
+        buffered += static_cast<size_t>(count);
+        progress = true;
+      } else if (count == 0) {
+        // reached end of file. Send the buffered data before closing.
+        connected = false;
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        printError();
+        std::cerr << "Failed to read" << std::endl;
+        break;
+      }
+    }
 
-    if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-      std::cout << "Worker write AGAIN" << std::endl;
-      // The file descriptor fd refers to a file other than a socket and has
-      // been marked nonblocking (O_NONBLOCK), and the read would block.
-      if (this->enabled) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (buffered > 0) {
+      ssize_t count =
+          ::splice(pipeFds[0], nullptr, this->clientSocket, nullptr, buffered,
+                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (count > 0) {
+        buffered -= static_cast<size_t>(count);
+        progress = true;
+      } else if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                 errno != EINTR) {
+        printError();
+        std::cerr << "Failed to send data to client" << std::endl;
+        break;
       }
+    }
+
+    if (progress) {
       continue;
-    } else if (rc < 0) {
-      // an error occurred
-      printError();
-      std::cerr << "Failed to write" << std::endl;
-      break;
-    } else if (rc == 0) {
-      // reached end of file
-      break;
     }
 
-    remaining -= rc;
-    position += rc;
+    // wait for data while the pipe has space and for the peer while the pipe
+    // holds data
+    short events = 0;
+    if (connected && buffered < capacity) {
+      events |= POLLIN;
+    }
+    if (buffered > 0) {
+      events |= POLLOUT;
+    }
+    if (!this->waitForSocket(events)) {
+      break;
+    }
   }
 
-  if (remaining == 0) {
+  ::close(pipeFds[0]);
+  ::close(pipeFds[1]);
+  return true;
+}
+
+bool Worker::write(const BufferView &view) {
+  this->outputQueue.push(view);
+  return this->outputQueue.flush(this->clientSocket) >= 0;
+}
+
+bool Worker::writeFrames(const std::vector<BufferView> &payloads) {
+  if (payloads.empty()) {
     return true;
   }
+  return this->write(Frame::encode(payloads));
+}
 
-  return false;
+bool Worker::write(const byte data[], size_t length) {
+  size_t position = 0;
+  while (position < length) {
+    size_t count = length - position;
+    if (count > BufferPool::MAX_SIZE) {
+      count = BufferPool::MAX_SIZE;
+    }
+    BufferRef buffer = BufferPool::acquire(count);
+    std::memcpy(buffer.data(), data + position, count);
+    this->outputQueue.push(BufferView(std::move(buffer), 0, count));
+    position += count;
+  }
+  return this->outputQueue.flush(this->clientSocket) >= 0;
 }
 
 }  // namespace socket
 }  // namespace cpp
 }  // namespace ggolbik
-#endif
\ No newline at end of file
+#endif
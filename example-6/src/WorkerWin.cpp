@@ -1,6 +1,7 @@
 #ifdef _WIN32
 
 #include <iostream>
+#include <utility>  // std::move
 // Windows system header files must be lower case.
 #include <winsock2.h>  // The Winsock2.h header file internally includes core elements from the Windows.h header file, so there is not usually an #include line for the Windows.h header file in Winsock applications.
 
@@ -10,8 +11,14 @@ namespace ggolbik {
 namespace cpp {
 namespace socket {
 
-Worker::Worker(SOCKET socket)
-    : clientSocket{socket}, enabled{false}, running{false} {}
+Worker::Worker(SOCKET socket) : Worker(socket, Mode::Echo) {}
+
+Worker::Worker(SOCKET socket, Mode mode)
+    : clientSocket{socket},
+      enabled{false},
+      running{false},
+      finished{false},
+      mode{mode} {}
 
 Worker::~Worker() { this->close(); }
 
@@ -107,16 +114,31 @@ void Worker::close() {
 
 void Worker::run() {
   // Receive until the peer shuts down the connection
-  while (this->enabled) {
-    std::string message;
-    if (this->readString(message)) {
-      std::cout << "Data: " << message << std::endl;
-      if (!this->write(message.c_str(), message.size())) {
+  if (this->mode == Mode::Framing) {
+    // echo the frames of each read with a single write
+    std::vector<BufferView> frames;
+    while (this->enabled && this->readFrames(frames)) {
+      if (!this->writeFrames(frames)) {
         std::cerr << "Failed to send data to client" << std::endl;
       }
-    } else {
-      // failed to read
-      break;
+    }
+  } else {
+    while (this->enabled) {
+      BufferView message;
+      if (this->read(message)) {
+        // there is no splice() on Windows. Splice forwards like Forward.
+        if (this->mode == Mode::Echo) {
+          std::cout << "Data: ";
+          std::cout.write(message.data(), message.size());
+          std::cout << std::endl;
+        }
+        if (!this->write(message)) {
+          std::cerr << "Failed to send data to client" << std::endl;
+        }
+      } else {
+        // failed to read
+        break;
+      }
     }
   }
 
@@ -129,16 +151,30 @@ void Worker::run() {
   this->running = false;
   std::cout << "Stopped Worker thread ID: " << this->workerThread.get_id()
             << std::endl;
+
+  this->notifyFinished();
 }
 
-bool Worker::readString(std::string &message) {
-  byte recvbuf[Worker::MAX_BUFFER_SIZE];
+void Worker::setFinishedCallback(std::function<void()> callback) {
+  this->finishedCallback = callback;
+}
+
+void Worker::notifyFinished() {
+  if (!this->finished.exchange(true) && this->finishedCallback) {
+    this->finishedCallback();
+  }
+}
 
-  message = "";
+bool Worker::read(BufferView &view) {
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte *recvbuf = buffer.data();
+
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::recv(this->clientSocket, recvbuf, Worker::MAX_BUFFER_SIZE, 0);
+    rc = ::recv(this->clientSocket, recvbuf, buffer.capacity(), 0);
     if (rc < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
       // The file descriptor fd refers to a file other than a socket and has
       // been marked nonblocking (O_NONBLOCK), and the read would block.
@@ -158,7 +194,9 @@ bool Worker::readString(std::string &message) {
       break;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
       return true;
     }
   }
@@ -166,6 +204,40 @@ bool Worker::readString(std::string &message) {
   return false;
 }
 
+bool Worker::write(const BufferView &view) {
+  return this->write(view.data(), view.size());
+}
+
+bool Worker::readFrames(std::vector<BufferView> &frames) {
+  frames.clear();
+  while (this->enabled) {
+    BufferView frame;
+    while (this->frameParser.next(frame)) {
+      frames.push_back(std::move(frame));
+    }
+    if (!frames.empty()) {
+      return true;
+    }
+
+    BufferView data;
+    if (!this->read(data)) {
+      return false;
+    }
+    if (!this->frameParser.feed(data)) {
+      std::cerr << "Received invalid frame" << std::endl;
+      return false;
+    }
+  }
+  return false;
+}
+
+bool Worker::writeFrames(const std::vector<BufferView> &payloads) {
+  if (payloads.empty()) {
+    return true;
+  }
+  return this->write(Frame::encode(payloads));
+}
+
 bool Worker::write(const byte data[], size_t length) {
   if (length == 0) {
     return true;
@@ -2,13 +2,17 @@
 #include <iostream>
 #include <string>
 
+#include "Benchmark.h"
 #include "Client.h"
+#include "LoadGenerator.h"
 #include "Server.h"
 
-static int runServer(std::string serverAddress = "",
-                     unsigned short port = 5044) {
+static int runServer(std::string serverAddress = "", unsigned short port = 5044,
+                     ggolbik::cpp::socket::Server::Backend backend =
+                         ggolbik::cpp::socket::Server::Backend::Posix,
+                     unsigned int shards = 1) {
   std::cout << "Starting server..." << std::endl;
-  ggolbik::cpp::socket::Server server(port, serverAddress);
+  ggolbik::cpp::socket::Server server(port, serverAddress, backend, shards);
   server.open();
 
   if (!server.isOpen()) {
@@ -16,13 +20,18 @@ static int runServer(std::string serverAddress = "",
     return -1;
   }
 
-  std::cout << "Started server." << std::endl;
+  std::cout << "Started server with " << server.getShardCount()
+            << " shard(s)." << std::endl;
 
   std::cout << ">>> Type any key and press return to stop." << std::endl;
   char k;
   std::cin >> k;
 
   std::cout << "Stopping server..." << std::endl;
+  std::cout << "Open connections: " << server.getConnectionCount()
+            << std::endl;
+  std::cout << "Served connections: " << server.getTotalConnectionCount()
+            << std::endl;
 
   server.close();
 
@@ -81,18 +90,68 @@ static void printHelp() {
   std::cout << "\tActions:" << std::endl;
   std::cout << "\t\tserver" << std::endl;
   std::cout << "\t\tclient" << std::endl;
+  std::cout << "\t\tbenchmark" << std::endl;
+  std::cout << "\t\tloadgen" << std::endl;
   std::cout << "\tParameters:" << std::endl;
   std::cout << "\t\thost=<IP-Address>" << std::endl;
   std::cout << "\t\tport=<Port Number>" << std::endl;
+  std::cout << "\t\tbackend=<posix|io_uring>" << std::endl;
+  std::cout << "\t\tshards=<number of listen sockets, 0 for one per core>"
+            << std::endl;
+  std::cout << "\t\ttask=<echo|latency|accept|pipeline|splice>" << std::endl;
+  std::cout << "\t\tconnections=<number of benchmark clients>" << std::endl;
+  std::cout << "\t\tmessages=<number of messages per client or connections "
+               "per client for task=accept>"
+            << std::endl;
+  std::cout << "\t\tsize=<message size in bytes>" << std::endl;
+  std::cout << "\t\trate=<messages per second of all connections for loadgen>"
+            << std::endl;
+  std::cout << "\t\tduration=<seconds of load for loadgen>" << std::endl;
+  std::cout << "\t\tidle=<pause before each latency message in ms>"
+            << std::endl;
+  std::cout << "\t\tdepth=<number of frames per write for task=pipeline>"
+            << std::endl;
   std::cout << "\tExample:" << std::endl;
   std::cout << "\t\tproject_cpp_binary client host=127.0.0.1 port=5044" << std::endl;
 }
 
+/**
+ * Parses the value of a numeric parameter like "size=1024".
+ */
+static bool parseNumber(const std::string &argument,
+                        const std::string &delimiter, unsigned long &value) {
+  if (argument.rfind(delimiter, 0) != 0) {
+    return false;
+  }
+  std::string strValue = argument.substr(delimiter.size());
+  try {
+    value = stoul(strValue);
+    return true;
+  } catch (std::invalid_argument &e) {
+    std::cerr << "Failed to parse " << delimiter << "'" << strValue << "'. "
+              << e.what() << std::endl;
+  }
+  return false;
+}
+
 int main(int argc, char *argv[]) {
   bool isServer = false;
   bool isClient = false;
+  bool isBenchmark = false;
+  bool isLoadgen = false;
   std::string serverAddress = "127.0.0.1";
   int port = 5044;
+  ggolbik::cpp::socket::Server::Backend backend =
+      ggolbik::cpp::socket::Server::Backend::Posix;
+  unsigned long connections = 4;
+  unsigned long messages = 1000;
+  unsigned long size = 64;
+  unsigned long idle = 10;
+  unsigned long shards = 1;
+  unsigned long depth = 16;
+  unsigned long rate = 1000;
+  unsigned long duration = 10;
+  std::string task = "echo";
 
   // writing to a broken socket will cause a SIGPIPE and make the program crash.
   // ignore the SIGPIPE and handle the error directly in your code.
@@ -109,6 +168,26 @@ int main(int argc, char *argv[]) {
     if (std::string("server").compare(argv[i]) == 0) {
       isServer = true;
     }
+    if (std::string("benchmark").compare(argv[i]) == 0) {
+      isBenchmark = true;
+    }
+    if (std::string("loadgen").compare(argv[i]) == 0) {
+      isLoadgen = true;
+    }
+    if (std::string("backend=io_uring").compare(argv[i]) == 0) {
+      backend = ggolbik::cpp::socket::Server::Backend::IoUring;
+    }
+    parseNumber(argv[i], "connections=", connections);
+    parseNumber(argv[i], "messages=", messages);
+    parseNumber(argv[i], "size=", size);
+    parseNumber(argv[i], "idle=", idle);
+    parseNumber(argv[i], "shards=", shards);
+    parseNumber(argv[i], "depth=", depth);
+    parseNumber(argv[i], "rate=", rate);
+    parseNumber(argv[i], "duration=", duration);
+    if (std::string(argv[i]).rfind("task=", 0) == 0) {
+      task = std::string(argv[i]).substr(5);
+    }
     if (std::string(argv[i]).rfind("host=", 0) == 0) {
       serverAddress = std::string(argv[i]);
       std::string delimiter = "host=";
@@ -132,12 +211,14 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  if (!isServer && !isClient) {
-    std::cerr << "client and/or server must be started." << std::endl;
+  if (!isServer && !isClient && !isBenchmark && !isLoadgen) {
+    std::cerr << "client, server, benchmark or loadgen must be started."
+              << std::endl;
     printHelp();
     return -1;
-  } else if (isServer && isClient) {
-    std::cerr << "Just client or server can be started and not both."
+  } else if (isServer + isClient + isBenchmark + isLoadgen > 1) {
+    std::cerr << "Just client, server, benchmark or loadgen can be started and "
+                 "not multiple."
               << std::endl;
     printHelp();
     return -1;
@@ -148,8 +229,27 @@ int main(int argc, char *argv[]) {
   std::cout << "Port: " << port << std::endl;
 
   if (isServer) {
-    runServer(serverAddress, port);
+    runServer(serverAddress, port, backend, shards);
   } else if (isClient) {
     runClient(serverAddress, port);
+  } else if (isLoadgen) {
+    return ggolbik::cpp::socket::LoadGenerator::run(
+        serverAddress, port, connections, rate, size, duration);
+  } else if (isBenchmark) {
+    if (task == "latency") {
+      return ggolbik::cpp::socket::Benchmark::runLatency(backend, port,
+                                                         messages, idle);
+    } else if (task == "pipeline") {
+      return ggolbik::cpp::socket::Benchmark::runPipeline(
+          backend, port, connections, messages, size, depth);
+    } else if (task == "accept") {
+      return ggolbik::cpp::socket::Benchmark::runAccept(backend, port,
+                                                        connections, messages);
+    } else if (task == "splice") {
+      return ggolbik::cpp::socket::Benchmark::runSplice(port, connections,
+                                                        messages);
+    }
+    return ggolbik::cpp::socket::Benchmark::runEcho(backend, port, connections,
+                                                    messages, size);
   }
 }
\ No newline at end of file
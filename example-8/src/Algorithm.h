@@ -3,43 +3,161 @@
 
 #include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "Sha256Hasher.h"
+
 namespace ggolbik {
 namespace cpp {
 namespace tls {
 
 class Algorithm {
+ public:  // type definitions
+  /// <summary>The way a file is read to calculate its hash.</summary>
+  enum class HashFileMethod {
+    // Read with a large buffer below MapFileMinSize, otherwise Map
+    Auto,
+    // std::ifstream in chunks of HashFileBufferSize
+    Stream,
+    // aligned reads of HashFileReadSize with a sequential readahead hint
+    Read,
+    // map the file into memory with a sequential access hint
+    Map
+  };
+
  public:  // base64
-  static bool decodeBase64(const std::string& encodedBase64String,
+  static bool decodeBase64(std::string_view encodedBase64String,
                            std::string& decodedString);
-  static bool decodeBase64(const std::string& encodedBase64String,
+  static bool decodeBase64(std::string_view encodedBase64String,
                            std::vector<unsigned char>& decoded);
-  static bool decodeBase64Url(const std::string& encodedBase64UrlString,
+  static bool decodeBase64Url(std::string_view encodedBase64UrlString,
                               std::string& decodedString);
-  static bool decodeBase64Url(const std::string& encodedBase64UrlString,
+  static bool decodeBase64Url(std::string_view encodedBase64UrlString,
                               std::vector<unsigned char>& decoded);
 
-  static bool encodeBase64(const std::string& decodedString,
+  static bool encodeBase64(std::string_view decodedString,
                            std::string& encodedBase64String);
-  static bool encodeBase64(const std::string& decodedString,
+  static bool encodeBase64(std::string_view decodedString,
                            std::vector<unsigned char>& encodedBase64);
-  static bool encodeBase64Url(const std::string& decodedString,
+  static bool encodeBase64Url(std::string_view decodedString,
                               std::string& encodedBase64UrlString);
-  static bool encodeBase64Url(const std::string& decodedString,
+  static bool encodeBase64Url(std::string_view decodedString,
                               std::vector<unsigned char>& encodedBase64Url);
 
+  /// <summary>
+  /// Decodes into a buffer of the caller without a heap allocation.
+  /// </summary>
+  /// <param name="decoded">The buffer for the decoded bytes</param>
+  /// <param name="decodedCapacity">The size of the buffer. At least
+  /// getBase64DecodedSize(encodedBase64String) bytes.</param>
+  /// <param name="decodedSize">The number of bytes written</param>
+  /// <returns>true if decode was successful, false otherwise</returns>
+  static bool decodeBase64(std::string_view encodedBase64String,
+                           unsigned char* decoded, std::size_t decodedCapacity,
+                           std::size_t& decodedSize);
+  static bool decodeBase64Url(std::string_view encodedBase64UrlString,
+                              unsigned char* decoded,
+                              std::size_t decodedCapacity,
+                              std::size_t& decodedSize);
+  /// <summary>
+  /// Encodes into a buffer of the caller without a heap allocation. The
+  /// characters are not terminated by '\0'.
+  /// </summary>
+  /// <param name="encoded">The buffer for the characters</param>
+  /// <param name="encodedCapacity">The size of the buffer. At least
+  /// getBase64EncodedSize(decodedString.size()) characters.</param>
+  /// <param name="encodedSize">The number of characters written</param>
+  /// <returns>true if encode was successful, false otherwise</returns>
+  static bool encodeBase64(std::string_view decodedString, char* encoded,
+                           std::size_t encodedCapacity,
+                           std::size_t& encodedSize);
+  static bool encodeBase64Url(std::string_view decodedString, char* encoded,
+                              std::size_t encodedCapacity,
+                              std::size_t& encodedSize);
+
+  /// <summary>Returns the exact number of characters of the base64 string
+  /// including the padding.</summary>
+  static std::size_t getBase64EncodedSize(std::size_t decodedSize);
+  /// <summary>Returns the exact number of characters of the base64url
+  /// string, which has no padding.</summary>
+  static std::size_t getBase64UrlEncodedSize(std::size_t decodedSize);
+  /// <summary>Returns the exact number of bytes of a valid base64 or
+  /// base64url string. The padding is not counted.</summary>
+  static std::size_t getBase64DecodedSize(std::string_view encodedString);
+
+  /// <summary>Encodes the bytes as lowercase hex digits with the fastest
+  /// kernel of the CPU (see Hex).</summary>
+  static void encodeHex(const unsigned char* data, std::size_t size,
+                        std::string& hexString);
+  /// <summary>
+  /// Encodes into a buffer of the caller without a heap allocation. The
+  /// characters are not terminated by '\0'.
+  /// </summary>
+  /// <param name="encodedCapacity">The size of the buffer. At least
+  /// 2 * size characters.</param>
+  /// <returns>false if the buffer is too small</returns>
+  static bool encodeHex(const unsigned char* data, std::size_t size,
+                        char* encoded, std::size_t encodedCapacity);
+  /// <summary>Decodes lowercase or uppercase hex digits.</summary>
+  /// <returns>false if the number of digits is odd or a character is not a
+  /// digit</returns>
+  static bool decodeHex(std::string_view hexString,
+                        std::vector<unsigned char>& decoded);
+  /// <summary>
+  /// Decodes into a buffer of the caller without a heap allocation.
+  /// </summary>
+  /// <param name="decodedCapacity">The size of the buffer. At least
+  /// hexString.size() / 2 bytes.</param>
+  /// <param name="decodedSize">The number of bytes written</param>
+  static bool decodeHex(std::string_view hexString, unsigned char* decoded,
+                        std::size_t decodedCapacity, std::size_t& decodedSize);
+
   static bool calcSha256File(const std::string& filename,
                              std::vector<unsigned char>& hash);
   static bool calcSha256File(const std::string& filename,
                              std::string& hashString);
+  /// <summary>Calculates the hash of the file with the given method. The
+  /// Read and Map methods are only available on Linux and fall back to
+  /// Stream otherwise.</summary>
+  static bool calcSha256File(const std::string& filename,
+                             std::vector<unsigned char>& hash,
+                             HashFileMethod method);
+  static std::string getHashFileMethodName(HashFileMethod method);
+  /// <summary>Calculates the root of a SHA-256 tree hash (see MerkleHash) of
+  /// the file. The leaves are hashed concurrently, so the root of a large
+  /// file is calculated faster than calcSha256File, but it differs from the
+  /// SHA-256 of the file.</summary>
+  /// <param name="threads">The number of threads, 0 uses one per CPU
+  /// core</param>
+  static bool calcSha256TreeFile(const std::string& filename,
+                                 std::vector<unsigned char>& hash,
+                                 unsigned int threads = 0);
+  static bool calcSha256TreeFile(const std::string& filename,
+                                 std::string& hashString,
+                                 unsigned int threads = 0);
   static bool calcSha256String(const std::string& str,
                                std::vector<unsigned char>& hash);
   static bool calcSha256String(const std::string& str, std::string& hashString);
+  /// <summary>Calculates the SHA-256 of many inputs at once with the fastest
+  /// kernel of the CPU (see Sha256Batch). No memory is allocated per
+  /// input.</summary>
+  /// <param name="inputs">The array of count inputs</param>
+  /// <param name="digests">Receives count * SHA256_DIGEST_LENGTH bytes. The
+  /// digest of input i starts at i * SHA256_DIGEST_LENGTH.</param>
+  static bool calcSha256Batch(const std::string_view* inputs,
+                              std::size_t count, unsigned char* digests);
+  static bool calcSha256Batch(const std::vector<std::string_view>& inputs,
+                              std::vector<unsigned char>& digests);
 
  private:
   // Files should be read in 4 KiB chunks.
   static constexpr int HashFileBufferSize = 4 * 1024;
+  // Large reads save system calls. The buffer is aligned to a page (1 MiB).
+  static constexpr std::size_t HashFileReadSize = 1024 * 1024;
+  static constexpr std::size_t HashFileReadAlignment = 4096;
+  // Files from this size are mapped into memory (64 MiB).
+  static constexpr long long MapFileMinSize = 64LL * 1024 * 1024;
   // Each character is used to represent 6 bits (log2(64) = 6).
   // Therefore 4 chars are used to represent 4 * 6 = 24 bits = 3 bytes
   // So you need 4*(n/3) chars to represent n bytes, and this needs to be
@@ -62,9 +180,12 @@ class Algorithm {
   bool initSha256();
   bool updateSha256(const void* data, std::size_t len);
   bool finalSha256(std::vector<unsigned char>& hash);
+  /// <summary>Passes the content of the file to updateSha256.</summary>
+  bool updateSha256File(const std::string& filename, HashFileMethod method);
+  bool updateSha256Stream(const std::string& filename);
 
  private:
-  ::SHA256_CTX sha256Context;
+  Sha256Hasher sha256Hasher;
 };
 
 }  // namespace tls
@@ -0,0 +1,139 @@
+#ifdef __linux__
+// linux code goes here
+
+#include <fcntl.h>     // ::open(...) ; ::posix_fadvise(...)
+#include <sys/mman.h>  // ::mmap(...) ; ::madvise(...) ; ::munmap(...)
+#include <sys/stat.h>  // ::fstat(...)
+#include <unistd.h>    // ::close(int), ::read(int, void*, size_t)
+
+#include <cerrno>      // errno
+#include <cstdlib>     // ::posix_memalign(...) ; ::free(...)
+#include <functional>  // std::function
+#include <iostream>    // std::cerr(...)
+#include <memory>      // std::unique_ptr
+
+#include "Algorithm.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Closes the file descriptor when it goes out of scope.
+ */
+struct FileDescriptor {
+  int fd;
+
+  explicit FileDescriptor(int fd) : fd{fd} {}
+  ~FileDescriptor() {
+    if (this->fd >= 0) {
+      ::close(this->fd);
+    }
+  }
+};
+
+/**
+ * Reads the file with a page aligned buffer. POSIX_FADV_SEQUENTIAL doubles
+ * the readahead window of the kernel, so the disk is read in large requests
+ * while the previous block is hashed.
+ */
+static bool readFile(
+    int fd, const std::function<bool(const void*, std::size_t)>& update,
+    std::size_t bufferSize, std::size_t alignment) {
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  void* memory = nullptr;
+  if (::posix_memalign(&memory, alignment, bufferSize) != 0) {
+    std::cerr << "Failed to allocate buffer to calculate hash." << std::endl;
+    return false;
+  }
+  std::unique_ptr<void, decltype(&::free)> buffer(memory, &::free);
+  while (true) {
+    ssize_t len = ::read(fd, buffer.get(), bufferSize);
+    if (len == 0) {
+      return true;
+    } else if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "Failed to read complete file to calculate hash."
+                << std::endl;
+      return false;
+    } else if (!update(buffer.get(), static_cast<std::size_t>(len))) {
+      return false;
+    }
+  }
+}
+
+/**
+ * Maps the file into memory, so the data is hashed from the page cache
+ * without a copy. MADV_SEQUENTIAL reads ahead aggressively and frees the
+ * pages early.
+ *
+ * @param mapped false if the file could not be mapped
+ */
+static bool mapFile(int fd, std::size_t size,
+                    const std::function<bool(const void*, std::size_t)>& update,
+                    bool& mapped) {
+  mapped = false;
+  if (size == 0) {
+    mapped = true;
+    return true;
+  }
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  mapped = true;
+  ::madvise(data, size, MADV_SEQUENTIAL);
+  bool result = update(data, size);
+  ::munmap(data, size);
+  return result;
+}
+
+/**
+ * The file is opened once. Its size selects the method for Auto. If the file
+ * can not be mapped, e.g. a pipe, it is read.
+ */
+bool Algorithm::updateSha256File(const std::string& filename,
+                                 HashFileMethod method) {
+  if (method == HashFileMethod::Stream) {
+    return this->updateSha256Stream(filename);
+  }
+  FileDescriptor file(::open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.fd < 0) {
+    std::cerr << "Hash can not be calculated of non existing file."
+              << std::endl;
+    return false;
+  }
+  struct stat fileStatus;
+  if (::fstat(file.fd, &fileStatus) != 0) {
+    std::cerr << "Failed to get size of file to calculate hash." << std::endl;
+    return false;
+  }
+  if (method == HashFileMethod::Auto) {
+    method = S_ISREG(fileStatus.st_mode) &&
+                     static_cast<long long>(fileStatus.st_size) >=
+                         Algorithm::MapFileMinSize
+                 ? HashFileMethod::Map
+                 : HashFileMethod::Read;
+  }
+
+  auto update = [this](const void* data, std::size_t len) {
+    return this->updateSha256(data, len);
+  };
+  if (method == HashFileMethod::Map && S_ISREG(fileStatus.st_mode)) {
+    bool mapped = false;
+    bool result = mapFile(
+        file.fd, static_cast<std::size_t>(fileStatus.st_size), update, mapped);
+    if (mapped) {
+      return result;
+    }
+  }
+  return readFile(file.fd, update, Algorithm::HashFileReadSize,
+                  Algorithm::HashFileReadAlignment);
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+#endif
@@ -0,0 +1,20 @@
+#ifdef _WIN32
+// _WIN32 marco is defined for both 32-bit and 64-bit environments
+// windows code goes here
+
+#include "Algorithm.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// The file is always read with std::ifstream on Windows.
+bool Algorithm::updateSha256File(const std::string& filename,
+                                 HashFileMethod method) {
+  return this->updateSha256Stream(filename);
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+#endif
@@ -0,0 +1,349 @@
+#include "Base64.h"
+
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+
+#include <functional>
+#include <limits>
+#include <memory>  // std::unique_ptr
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+static const char STANDARD_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char URL_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+// marks a character which is not part of the alphabet
+static const unsigned char INVALID = 0xFF;
+
+/**
+ * The value of each character or INVALID.
+ */
+struct DecodeTable {
+  unsigned char values[256];
+
+  explicit DecodeTable(const char *alphabet) {
+    for (unsigned int i = 0; i < 256; i++) {
+      this->values[i] = INVALID;
+    }
+    for (unsigned int i = 0; i < 64; i++) {
+      this->values[static_cast<unsigned char>(alphabet[i])] =
+          static_cast<unsigned char>(i);
+    }
+  }
+};
+
+static const unsigned char *getDecodeTable(Base64::Alphabet alphabet) {
+  // initialized on first use and thread safe since C++11
+  static const DecodeTable standard(STANDARD_ALPHABET);
+  static const DecodeTable url(URL_ALPHABET);
+  return alphabet == Base64::Alphabet::Url ? url.values : standard.values;
+}
+
+/**
+ * Encodes all groups of 3 bytes and the padded rest.
+ */
+static std::size_t encodeScalar(const unsigned char *data, std::size_t size,
+                                char *encoded, Base64::Alphabet alphabet) {
+  const char *chars =
+      alphabet == Base64::Alphabet::Url ? URL_ALPHABET : STANDARD_ALPHABET;
+  char *out = encoded;
+  std::size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    unsigned int value = (static_cast<unsigned int>(data[i]) << 16) |
+                         (static_cast<unsigned int>(data[i + 1]) << 8) |
+                         data[i + 2];
+    out[0] = chars[(value >> 18) & 0x3F];
+    out[1] = chars[(value >> 12) & 0x3F];
+    out[2] = chars[(value >> 6) & 0x3F];
+    out[3] = chars[value & 0x3F];
+    out += 4;
+  }
+  std::size_t rest = size - i;
+  if (rest > 0) {
+    unsigned int value = static_cast<unsigned int>(data[i]) << 16;
+    if (rest == 2) {
+      value |= static_cast<unsigned int>(data[i + 1]) << 8;
+    }
+    *out++ = chars[(value >> 18) & 0x3F];
+    *out++ = chars[(value >> 12) & 0x3F];
+    if (rest == 2) {
+      *out++ = chars[(value >> 6) & 0x3F];
+    }
+    if (alphabet == Base64::Alphabet::Standard) {
+      *out++ = '=';
+      if (rest == 1) {
+        *out++ = '=';
+      }
+    }
+  }
+  return static_cast<std::size_t>(out - encoded);
+}
+
+/**
+ * Decodes characters without padding. The unused bits of an incomplete group
+ * must be zero.
+ */
+static bool decodeScalar(const char *encoded, std::size_t size,
+                         unsigned char *decoded, std::size_t &decodedSize,
+                         Base64::Alphabet alphabet) {
+  const unsigned char *table = getDecodeTable(alphabet);
+  const unsigned char *in = reinterpret_cast<const unsigned char *>(encoded);
+  unsigned char *out = decoded;
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    unsigned int a = table[in[i]];
+    unsigned int b = table[in[i + 1]];
+    unsigned int c = table[in[i + 2]];
+    unsigned int d = table[in[i + 3]];
+    // INVALID is the only value with the high bit
+    if (((a | b | c | d) & 0x80) != 0) {
+      return false;
+    }
+    unsigned int value = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = static_cast<unsigned char>(value >> 16);
+    out[1] = static_cast<unsigned char>(value >> 8);
+    out[2] = static_cast<unsigned char>(value);
+    out += 3;
+  }
+  std::size_t rest = size - i;
+  if (rest == 1) {
+    return false;
+  } else if (rest > 1) {
+    unsigned int a = table[in[i]];
+    unsigned int b = table[in[i + 1]];
+    unsigned int c = rest == 3 ? table[in[i + 2]] : 0;
+    if (((a | b | c) & 0x80) != 0) {
+      return false;
+    }
+    unsigned int value = (a << 18) | (b << 12) | (c << 6);
+    *out++ = static_cast<unsigned char>(value >> 16);
+    if (rest == 3) {
+      *out++ = static_cast<unsigned char>(value >> 8);
+    }
+    // the unused bits must be zero, so each encoding is unique
+    if ((rest == 2 && (value & 0xFFFF) != 0) ||
+        (rest == 3 && (value & 0xFF) != 0)) {
+      return false;
+    }
+  }
+  decodedSize = static_cast<std::size_t>(out - decoded);
+  return true;
+}
+
+Base64::Kernel Base64::getDefaultKernel() {
+  // initialized on first use and thread safe since C++11
+  static const Kernel kernel =
+      Base64::isSupported(Kernel::Avx2)
+          ? Kernel::Avx2
+          : (Base64::isSupported(Kernel::Ssse3) ? Kernel::Ssse3
+                                                : Kernel::Scalar);
+  return kernel;
+}
+
+/**
+ * __builtin_cpu_supports() reads the CPUID flags. For AVX2 it also checks
+ * that the operating system saves the YMM registers.
+ */
+bool Base64::isSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Scalar:
+      return true;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    case Kernel::Ssse3:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("ssse3");
+    case Kernel::Avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+std::string Base64::getKernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Scalar:
+      return "scalar";
+    case Kernel::Ssse3:
+      return "ssse3";
+    case Kernel::Avx2:
+      return "avx2";
+  }
+  return "";
+}
+
+std::size_t Base64::getEncodedSize(std::size_t size, Alphabet alphabet) {
+  if (alphabet == Alphabet::Standard) {
+    return (size + 2) / 3 * 4;
+  }
+  return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+}
+
+std::size_t Base64::getMaxDecodedSize(std::size_t size) {
+  return size / 4 * 3 + (size % 4 == 0 ? 0 : size % 4 - 1);
+}
+
+std::size_t Base64::getDecodedSize(const char *encoded, std::size_t size) {
+  std::size_t length = size;
+  while (length > 0 && size - length < 2 && encoded[length - 1] == '=') {
+    length--;
+  }
+  return Base64::getMaxDecodedSize(length);
+}
+
+std::size_t Base64::encode(const unsigned char *data, std::size_t size,
+                           char *encoded, Alphabet alphabet) {
+  return Base64::encode(data, size, encoded, alphabet,
+                        Base64::getDefaultKernel());
+}
+
+std::size_t Base64::encode(const unsigned char *data, std::size_t size,
+                           char *encoded, Alphabet alphabet, Kernel kernel) {
+  if (!Base64::isSupported(kernel)) {
+    kernel = Kernel::Scalar;
+  }
+  std::size_t consumed = 0;
+  if (kernel == Kernel::Avx2) {
+    consumed = Base64::encodeAvx2(data, size, encoded, alphabet);
+  } else if (kernel == Kernel::Ssse3) {
+    consumed = Base64::encodeSsse3(data, size, encoded, alphabet);
+  }
+  std::size_t written = consumed / 3 * 4;
+  return written + encodeScalar(data + consumed, size - consumed,
+                                encoded + written, alphabet);
+}
+
+bool Base64::decode(const char *encoded, std::size_t size,
+                    unsigned char *decoded, std::size_t &decodedSize,
+                    Alphabet alphabet) {
+  return Base64::decode(encoded, size, decoded, decodedSize, alphabet,
+                        Base64::getDefaultKernel());
+}
+
+/**
+ * The standard alphabet requires the padding, the URL alphabet accepts it.
+ * The padding completes the last group to 4 characters.
+ */
+bool Base64::decode(const char *encoded, std::size_t size,
+                    unsigned char *decoded, std::size_t &decodedSize,
+                    Alphabet alphabet, Kernel kernel) {
+  std::size_t padding = 0;
+  while (padding < size && encoded[size - 1 - padding] == '=') {
+    padding++;
+  }
+  std::size_t length = size - padding;
+  if (padding > 2 || (padding > 0 && size % 4 != 0) ||
+      (alphabet == Alphabet::Standard && size % 4 != 0)) {
+    return false;
+  }
+
+  if (!Base64::isSupported(kernel)) {
+    kernel = Kernel::Scalar;
+  }
+  std::size_t consumed = 0;
+  bool valid = true;
+  if (kernel == Kernel::Avx2) {
+    valid = Base64::decodeAvx2(encoded, length, decoded, alphabet, consumed);
+  } else if (kernel == Kernel::Ssse3) {
+    valid = Base64::decodeSsse3(encoded, length, decoded, alphabet, consumed);
+  }
+  if (!valid) {
+    return false;
+  }
+  std::size_t written = consumed / 4 * 3;
+  std::size_t rest = 0;
+  if (!decodeScalar(encoded + consumed, length - consumed, decoded + written,
+                    rest, alphabet)) {
+    return false;
+  }
+  decodedSize = written + rest;
+  return true;
+}
+
+/// <summary>
+/// Encodes a string with a base64 BIO.
+///
+/// https://www.openssl.org/docs/man1.0.2/man3/BIO_f_base64.html
+/// https://www.openssl.org/docs/man1.0.2/man3/BIO_s_mem.html
+/// </summary>
+bool Base64::encodeOpenSsl(const std::string &decoded, std::string &encoded) {
+  if (decoded.empty()) {
+    encoded = "";
+    return true;
+  }
+  // BIO_free_all() frees up an entire BIO chain.
+  std::unique_ptr<::BIO, std::function<void(::BIO * p)>> b64(
+      ::BIO_new(::BIO_f_base64()), [](::BIO *p) -> void { ::BIO_free_all(p); });
+  if (!b64) {
+    return false;
+  }
+  // encode the data all on one line
+  ::BIO_set_flags(b64.get(), BIO_FLAGS_BASE64_NO_NL);
+  // create BIO that holds the result
+  ::BIO *sink = ::BIO_new(::BIO_s_mem());
+  if (!sink) {
+    return false;
+  }
+  // b64 frees the chain
+  ::BIO_push(b64.get(), sink);
+
+  if (::BIO_write(b64.get(), decoded.c_str(),
+                  static_cast<int>(decoded.size())) <= 0 ||
+      BIO_flush(b64.get()) != 1) {
+    return false;
+  }
+  const char *data;
+  const long len = BIO_get_mem_data(sink, &data);
+  if (len < 1) {
+    return false;
+  }
+  encoded = std::string(data, len);
+  return true;
+}
+
+/// <summary>
+/// Decodes a base64 string with a base64 BIO.
+///
+/// https://www.openssl.org/docs/man1.0.2/man3/BIO_f_base64.html
+/// https://www.openssl.org/docs/man1.0.2/man3/BIO_new_mem_buf.html
+/// </summary>
+bool Base64::decodeOpenSsl(const std::string &encoded, std::string &decoded) {
+  const std::size_t maxlen = ((encoded.size() / 4) * 3) + 1;
+  if (encoded.empty() ||
+      maxlen > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+    return false;
+  }
+  // BIO_free_all() frees up an entire BIO chain.
+  std::unique_ptr<::BIO, std::function<void(::BIO * p)>> b64(
+      ::BIO_new(::BIO_f_base64()), [](::BIO *p) -> void { ::BIO_free_all(p); });
+  if (!b64) {
+    return false;
+  }
+  // expect the data all on one line
+  ::BIO_set_flags(b64.get(), BIO_FLAGS_BASE64_NO_NL);
+  // a read only memory BIO which does not copy the string
+  ::BIO *source = ::BIO_new_mem_buf(static_cast<const void *>(encoded.c_str()),
+                                    static_cast<int>(encoded.size()));
+  if (source == nullptr) {
+    return false;
+  }
+  // b64 frees the chain
+  ::BIO_push(b64.get(), source);
+
+  std::vector<char> buffer(maxlen);
+  const int len = ::BIO_read(b64.get(), buffer.data(), static_cast<int>(maxlen));
+  if (len <= 0) {
+    return false;
+  }
+  decoded = std::string(buffer.data(), static_cast<std::size_t>(len));
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
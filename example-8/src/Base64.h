@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A base64 codec (RFC 4648) without allocations. The data is processed by a
+ * kernel which is selected at runtime by the features of the CPU: AVX2 and
+ * SSSE3 kernels process 24 or 12 bytes per step, the scalar kernel one group
+ * of 3 bytes. All kernels produce the same output.
+ *
+ * The standard alphabet is padded with '=', the URL alphabet is not. The
+ * decoder is strict: it rejects characters of the other alphabet, line
+ * breaks, misplaced padding and encodings whose unused bits are not zero.
+ */
+class Base64 {
+ public:  // type definitions
+  enum class Alphabet {
+    // A-Z a-z 0-9 + / with padding
+    Standard,
+    // A-Z a-z 0-9 - _ without padding
+    Url
+  };
+
+  enum class Kernel { Scalar, Ssse3, Avx2 };
+
+ public:  // methods
+  /**
+   * Returns the fastest kernel supported by the CPU. The CPU is queried once.
+   */
+  static Kernel getDefaultKernel();
+  static bool isSupported(Kernel kernel);
+  static std::string getKernelName(Kernel kernel);
+
+  /**
+   * Returns the number of characters of the encoded data.
+   */
+  static std::size_t getEncodedSize(std::size_t size, Alphabet alphabet);
+  /**
+   * Returns the max number of bytes of the decoded data. The padding reduces
+   * the actual size by up to two bytes.
+   */
+  static std::size_t getMaxDecodedSize(std::size_t size);
+  /**
+   * Returns the exact number of bytes of the decoded data if the characters
+   * are a valid encoding. Up to two '=' at the end are not counted.
+   */
+  static std::size_t getDecodedSize(const char *encoded, std::size_t size);
+
+  /**
+   * Encodes the data with the default kernel.
+   *
+   * @param encoded receives getEncodedSize(size, alphabet) characters
+   * @return the number of characters written
+   */
+  static std::size_t encode(const unsigned char *data, std::size_t size,
+                            char *encoded, Alphabet alphabet);
+  /**
+   * Encodes the data with the kernel. A kernel the CPU does not support
+   * falls back to the scalar code.
+   */
+  static std::size_t encode(const unsigned char *data, std::size_t size,
+                            char *encoded, Alphabet alphabet, Kernel kernel);
+
+  /**
+   * Decodes the characters with the default kernel.
+   *
+   * @param decoded receives up to getMaxDecodedSize(size) bytes
+   * @param decodedSize the number of bytes written
+   * @return false if the characters are not a valid encoding. The content of
+   * decoded is undefined then.
+   */
+  static bool decode(const char *encoded, std::size_t size,
+                     unsigned char *decoded, std::size_t &decodedSize,
+                     Alphabet alphabet);
+  /**
+   * Decodes the characters with the kernel. A kernel the CPU does not
+   * support falls back to the scalar code.
+   */
+  static bool decode(const char *encoded, std::size_t size,
+                     unsigned char *decoded, std::size_t &decodedSize,
+                     Alphabet alphabet, Kernel kernel);
+
+  /**
+   * Encodes the data with the base64 BIO of OpenSSL. The result of the
+   * standard alphabet is the reference for the kernels.
+   */
+  static bool encodeOpenSsl(const std::string &decoded, std::string &encoded);
+  /**
+   * Decodes the standard alphabet with the base64 BIO of OpenSSL.
+   */
+  static bool decodeOpenSsl(const std::string &encoded, std::string &decoded);
+
+ private:  // kernels
+  /**
+   * The SIMD kernels process a prefix of whole blocks and leave the rest to
+   * the scalar kernel.
+   *
+   * @return the number of bytes consumed. The number of characters written is
+   * 4/3 of it.
+   */
+  static std::size_t encodeSsse3(const unsigned char *data, std::size_t size,
+                                 char *encoded, Alphabet alphabet);
+  static std::size_t encodeAvx2(const unsigned char *data, std::size_t size,
+                                char *encoded, Alphabet alphabet);
+  /**
+   * The characters must not contain padding.
+   *
+   * @param consumed the number of characters consumed. The number of bytes
+   * written is 3/4 of it.
+   * @return false if an invalid character has been found
+   */
+  static bool decodeSsse3(const char *encoded, std::size_t size,
+                          unsigned char *decoded, Alphabet alphabet,
+                          std::size_t &consumed);
+  static bool decodeAvx2(const char *encoded, std::size_t size,
+                         unsigned char *decoded, Alphabet alphabet,
+                         std::size_t &consumed);
+
+ private:
+  Base64() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
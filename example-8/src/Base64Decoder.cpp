@@ -0,0 +1,127 @@
+#include "Base64Decoder.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+Base64Decoder::Base64Decoder(Base64::Alphabet alphabet)
+    : alphabet{alphabet},
+      pending{0, 0, 0},
+      pendingSize{0},
+      padded{false},
+      failed{false} {}
+
+std::size_t Base64Decoder::getMaxUpdateSize(std::size_t size) {
+  return (size + 3) / 4 * 3;
+}
+
+bool Base64Decoder::decodeGroups(const char *encoded, std::size_t size,
+                                 unsigned char *decoded,
+                                 std::size_t &decodedSize) {
+  decodedSize = 0;
+  if (size == 0) {
+    return true;
+  }
+  if (this->padded ||
+      !Base64::decode(encoded, size, decoded, decodedSize, this->alphabet)) {
+    return false;
+  }
+  this->padded = encoded[size - 1] == '=';
+  return true;
+}
+
+/**
+ * The kept characters are completed to a group first. The complete groups of
+ * the chunk are passed to the SIMD kernels at once.
+ */
+bool Base64Decoder::update(const char *encoded, std::size_t size,
+                           unsigned char *decoded, std::size_t &decodedSize) {
+  decodedSize = 0;
+  if (this->failed) {
+    return false;
+  }
+  std::size_t written = 0;
+  if (this->pendingSize > 0) {
+    std::size_t missing = 4 - this->pendingSize;
+    if (size < missing) {
+      for (std::size_t i = 0; i < size; i++) {
+        this->pending[this->pendingSize++] = encoded[i];
+      }
+      return true;
+    }
+    char group[4];
+    for (std::size_t i = 0; i < this->pendingSize; i++) {
+      group[i] = this->pending[i];
+    }
+    for (std::size_t i = 0; i < missing; i++) {
+      group[this->pendingSize + i] = encoded[i];
+    }
+    this->pendingSize = 0;
+    if (!this->decodeGroups(group, 4, decoded, written)) {
+      this->failed = true;
+      return false;
+    }
+    encoded += missing;
+    size -= missing;
+  }
+  std::size_t complete = size / 4 * 4;
+  std::size_t groupsSize = 0;
+  if (!this->decodeGroups(encoded, complete, decoded + written, groupsSize)) {
+    this->failed = true;
+    return false;
+  }
+  written += groupsSize;
+  if (this->padded && complete < size) {
+    this->failed = true;
+    return false;
+  }
+  for (std::size_t i = complete; i < size; i++) {
+    this->pending[this->pendingSize++] = encoded[i];
+  }
+  decodedSize = written;
+  return true;
+}
+
+bool Base64Decoder::update(std::string_view chunk, std::string &decoded) {
+  std::size_t offset = decoded.size();
+  decoded.resize(offset + Base64Decoder::getMaxUpdateSize(chunk.size()));
+  std::size_t written = 0;
+  bool result =
+      this->update(chunk.data(), chunk.size(),
+                   reinterpret_cast<unsigned char *>(&decoded[offset]), written);
+  decoded.resize(offset + written);
+  return result;
+}
+
+/**
+ * Only the URL alphabet accepts a last group without padding.
+ */
+bool Base64Decoder::finish(unsigned char *decoded, std::size_t &decodedSize) {
+  decodedSize = 0;
+  bool result = !this->failed;
+  if (result && this->pendingSize > 0) {
+    result = this->alphabet == Base64::Alphabet::Url &&
+             this->decodeGroups(this->pending, this->pendingSize, decoded,
+                                decodedSize);
+  }
+  this->reset();
+  return result;
+}
+
+bool Base64Decoder::finish(std::string &decoded) {
+  unsigned char rest[Base64Decoder::MAX_FINISH_SIZE];
+  std::size_t written = 0;
+  bool result = this->finish(rest, written);
+  decoded.append(reinterpret_cast<const char *>(rest), written);
+  return result;
+}
+
+void Base64Decoder::reset() {
+  this->pendingSize = 0;
+  this->padded = false;
+  this->failed = false;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "Base64.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Decodes characters which arrive in chunks, e.g. from a file or a socket. A
+ * group of 4 characters may be split between two chunks, so up to 3
+ * characters are kept until the next call. The memory does not grow with the
+ * size of the data.
+ *
+ * The decoder is as strict as Base64::decode(). Padding ends the data, so
+ * characters after a group with '=' are rejected. After an error all calls
+ * fail until reset() is called.
+ */
+class Base64Decoder {
+ public:  // const
+  // max number of bytes written by finish()
+  static const std::size_t MAX_FINISH_SIZE = 2;
+
+ public:  // construction/destruction/operators
+  explicit Base64Decoder(
+      Base64::Alphabet alphabet = Base64::Alphabet::Standard);
+  /**
+   * Move constructor
+   */
+  Base64Decoder(Base64Decoder &&) = default;
+  /**
+   * Move assignment operator
+   */
+  Base64Decoder &operator=(Base64Decoder &&) = default;
+  /**
+   * Copy constructor
+   */
+  Base64Decoder(const Base64Decoder &) = default;
+  /**
+   * Copy assignment operator
+   */
+  Base64Decoder &operator=(const Base64Decoder &) = default;
+  /**
+   * Destructor
+   */
+  ~Base64Decoder() = default;
+
+ public:  // methods
+  /**
+   * Returns the max number of bytes written by update() for a chunk.
+   */
+  static std::size_t getMaxUpdateSize(std::size_t size);
+
+  /**
+   * Decodes the complete groups of the kept characters and the chunk.
+   *
+   * @param decoded receives up to getMaxUpdateSize(size) bytes
+   * @param decodedSize the number of bytes written
+   * @return false if the characters are not a valid encoding
+   */
+  bool update(const char *encoded, std::size_t size, unsigned char *decoded,
+              std::size_t &decodedSize);
+  /**
+   * Appends the bytes to the string.
+   */
+  bool update(std::string_view chunk, std::string &decoded);
+  /**
+   * Decodes the kept characters and resets the decoder. The standard
+   * alphabet fails if the last group is incomplete.
+   *
+   * @param decoded receives up to MAX_FINISH_SIZE bytes
+   * @param decodedSize the number of bytes written
+   * @return false if the characters are not a valid encoding
+   */
+  bool finish(unsigned char *decoded, std::size_t &decodedSize);
+  /**
+   * Appends the bytes to the string.
+   */
+  bool finish(std::string &decoded);
+  /**
+   * Drops the kept characters and clears an error.
+   */
+  void reset();
+
+ private:  // helper methods
+  /**
+   * Decodes a group of 4 characters or the complete groups of a chunk. A
+   * group with padding must be the last one.
+   */
+  bool decodeGroups(const char *encoded, std::size_t size,
+                    unsigned char *decoded, std::size_t &decodedSize);
+
+ private:  // fields
+  Base64::Alphabet alphabet;
+  // the characters of an incomplete group
+  char pending[3];
+  std::size_t pendingSize;
+  // a group with padding has been decoded
+  bool padded;
+  bool failed;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
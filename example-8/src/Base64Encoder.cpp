@@ -0,0 +1,74 @@
+#include "Base64Encoder.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+Base64Encoder::Base64Encoder(Base64::Alphabet alphabet)
+    : alphabet{alphabet}, pending{0, 0}, pendingSize{0} {}
+
+std::size_t Base64Encoder::getMaxUpdateSize(std::size_t size) {
+  return (size + 2) / 3 * 4;
+}
+
+/**
+ * The kept bytes are completed to a group first. The complete groups of the
+ * chunk are passed to the SIMD kernels at once.
+ */
+std::size_t Base64Encoder::update(const unsigned char *data, std::size_t size,
+                                  char *encoded) {
+  std::size_t written = 0;
+  if (this->pendingSize > 0) {
+    unsigned char group[3];
+    std::size_t missing = 3 - this->pendingSize;
+    if (size < missing) {
+      for (std::size_t i = 0; i < size; i++) {
+        this->pending[this->pendingSize++] = data[i];
+      }
+      return 0;
+    }
+    for (std::size_t i = 0; i < this->pendingSize; i++) {
+      group[i] = this->pending[i];
+    }
+    for (std::size_t i = 0; i < missing; i++) {
+      group[this->pendingSize + i] = data[i];
+    }
+    written = Base64::encode(group, 3, encoded, this->alphabet);
+    this->pendingSize = 0;
+    data += missing;
+    size -= missing;
+  }
+  std::size_t complete = size / 3 * 3;
+  written += Base64::encode(data, complete, encoded + written, this->alphabet);
+  for (std::size_t i = complete; i < size; i++) {
+    this->pending[this->pendingSize++] = data[i];
+  }
+  return written;
+}
+
+void Base64Encoder::update(std::string_view chunk, std::string &encoded) {
+  std::size_t offset = encoded.size();
+  encoded.resize(offset + Base64Encoder::getMaxUpdateSize(chunk.size()));
+  std::size_t written =
+      this->update(reinterpret_cast<const unsigned char *>(chunk.data()),
+                   chunk.size(), &encoded[offset]);
+  encoded.resize(offset + written);
+}
+
+std::size_t Base64Encoder::finish(char *encoded) {
+  std::size_t written =
+      Base64::encode(this->pending, this->pendingSize, encoded, this->alphabet);
+  this->reset();
+  return written;
+}
+
+void Base64Encoder::finish(std::string &encoded) {
+  char rest[Base64Encoder::MAX_FINISH_SIZE];
+  encoded.append(rest, this->finish(rest));
+}
+
+void Base64Encoder::reset() { this->pendingSize = 0; }
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "Base64.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Encodes data which arrives in chunks, e.g. from a file or a socket. A
+ * group of 3 bytes may be split between two chunks, so up to 2 bytes are kept
+ * until the next call. The memory does not grow with the size of the data.
+ *
+ * The concatenated output of update() and finish() equals the output of
+ * Base64::encode() for the whole data.
+ */
+class Base64Encoder {
+ public:  // const
+  // max number of characters written by finish()
+  static const std::size_t MAX_FINISH_SIZE = 4;
+
+ public:  // construction/destruction/operators
+  explicit Base64Encoder(
+      Base64::Alphabet alphabet = Base64::Alphabet::Standard);
+  /**
+   * Move constructor
+   */
+  Base64Encoder(Base64Encoder &&) = default;
+  /**
+   * Move assignment operator
+   */
+  Base64Encoder &operator=(Base64Encoder &&) = default;
+  /**
+   * Copy constructor
+   */
+  Base64Encoder(const Base64Encoder &) = default;
+  /**
+   * Copy assignment operator
+   */
+  Base64Encoder &operator=(const Base64Encoder &) = default;
+  /**
+   * Destructor
+   */
+  ~Base64Encoder() = default;
+
+ public:  // methods
+  /**
+   * Returns the max number of characters written by update() for a chunk.
+   */
+  static std::size_t getMaxUpdateSize(std::size_t size);
+
+  /**
+   * Encodes the complete groups of the kept bytes and the chunk.
+   *
+   * @param encoded receives up to getMaxUpdateSize(size) characters
+   * @return the number of characters written
+   */
+  std::size_t update(const unsigned char *data, std::size_t size,
+                     char *encoded);
+  /**
+   * Appends the characters to the string.
+   */
+  void update(std::string_view chunk, std::string &encoded);
+  /**
+   * Encodes the kept bytes with padding and resets the encoder.
+   *
+   * @param encoded receives up to MAX_FINISH_SIZE characters
+   * @return the number of characters written
+   */
+  std::size_t finish(char *encoded);
+  /**
+   * Appends the characters to the string.
+   */
+  void finish(std::string &encoded);
+  /**
+   * Drops the kept bytes.
+   */
+  void reset();
+
+ private:  // fields
+  Base64::Alphabet alphabet;
+  // the bytes of an incomplete group
+  unsigned char pending[2];
+  std::size_t pendingSize;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,327 @@
+#include "Base64.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>  // std::memcpy(...)
+
+/**
+ * The kernels are compiled for their instruction set with the target
+ * attribute, so the binary runs on CPUs without them. Base64::isSupported()
+ * must be checked before a kernel is called.
+ *
+ * The algorithms are described by Wojciech Muła and Daniel Lemire in
+ * "Faster Base64 Encoding and Decoding Using AVX2 Instructions" (2018).
+ */
+#define BASE64_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_AVX2 __attribute__((target("avx2")))
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * The characters of the values 62 and 63.
+ */
+static char getChar62(Base64::Alphabet alphabet) {
+  return alphabet == Base64::Alphabet::Url ? '-' : '+';
+}
+
+static char getChar63(Base64::Alphabet alphabet) {
+  return alphabet == Base64::Alphabet::Url ? '_' : '/';
+}
+
+// encode
+
+/**
+ * Moves the 4 groups of 6 bits of each group of 3 bytes into the 4 bytes of
+ * a 32 bit lane. The input bytes 0..11 are spread as [1 0 2 1] per lane.
+ */
+BASE64_SSSE3 static inline __m128i splitSsse3(__m128i in) {
+  in = _mm_shuffle_epi8(
+      in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(t1, t3);
+}
+
+/**
+ * Translates the values 0..63 to characters by adding an offset. The offset
+ * is looked up by a reduced value: 0 for 26..51, 1..12 for 52..63 and 13 for
+ * 0..25.
+ */
+BASE64_SSSE3 static inline __m128i translateSsse3(__m128i values,
+                                                  __m128i offsets) {
+  __m128i reduced = _mm_subs_epu8(values, _mm_set1_epi8(51));
+  const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+  reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(offsets, reduced), values);
+}
+
+BASE64_SSSE3 static inline __m128i getOffsetsSsse3(Base64::Alphabet alphabet) {
+  return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, getChar62(alphabet) - 62,
+                       getChar63(alphabet) - 63, 'A', 0, 0);
+}
+
+/**
+ * Each step loads 16 bytes and encodes the first 12 of them.
+ */
+BASE64_SSSE3 std::size_t Base64::encodeSsse3(const unsigned char *data,
+                                             std::size_t size, char *encoded,
+                                             Alphabet alphabet) {
+  const __m128i offsets = getOffsetsSsse3(alphabet);
+  std::size_t i = 0;
+  char *out = encoded;
+  for (; i + 16 <= size; i += 12) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i chars = translateSsse3(splitSsse3(in), offsets);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), chars);
+    out += 16;
+  }
+  return i;
+}
+
+BASE64_AVX2 static inline __m256i splitAvx2(__m256i in) {
+  in = _mm256_shuffle_epi8(
+      in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                          10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+  const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+  const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+  const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+  return _mm256_or_si256(t1, t3);
+}
+
+BASE64_AVX2 static inline __m256i translateAvx2(__m256i values,
+                                                __m256i offsets) {
+  __m256i reduced = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+  const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), values);
+  reduced =
+      _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+  return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, reduced), values);
+}
+
+/**
+ * Each step encodes 24 bytes. The lanes are loaded from the offsets 0 and 12,
+ * so 28 bytes must be readable.
+ */
+BASE64_AVX2 std::size_t Base64::encodeAvx2(const unsigned char *data,
+                                           std::size_t size, char *encoded,
+                                           Alphabet alphabet) {
+  const __m256i offsets = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, getChar62(alphabet) - 62,
+      getChar63(alphabet) - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, getChar62(alphabet) - 62, getChar63(alphabet) - 63, 'A', 0, 0);
+  std::size_t i = 0;
+  char *out = encoded;
+  for (; i + 28 <= size; i += 24) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    __m256i chars = translateAvx2(splitAvx2(in), offsets);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), chars);
+    out += 32;
+  }
+  return i;
+}
+
+// decode
+
+/**
+ * Returns 0xFF for each byte in [low, high]. Bytes >= 0x80 are negative and
+ * never in range.
+ */
+BASE64_SSSE3 static inline __m128i inRangeSsse3(__m128i in, char low,
+                                                char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(low - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), in));
+}
+
+/**
+ * Translates characters to their values. Returns false if a character is not
+ * part of the alphabet.
+ */
+BASE64_SSSE3 static inline bool toValuesSsse3(__m128i in, char char62,
+                                              char char63, __m128i &values) {
+  const __m128i upper = inRangeSsse3(in, 'A', 'Z');
+  const __m128i lower = inRangeSsse3(in, 'a', 'z');
+  const __m128i digit = inRangeSsse3(in, '0', '9');
+  const __m128i is62 = _mm_cmpeq_epi8(in, _mm_set1_epi8(char62));
+  const __m128i is63 = _mm_cmpeq_epi8(in, _mm_set1_epi8(char63));
+  const __m128i valid = _mm_or_si128(
+      _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, is62)),
+      is63);
+  if (_mm_movemask_epi8(valid) != 0xFFFF) {
+    return false;
+  }
+  __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+  shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+  shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+  shift = _mm_or_si128(shift, _mm_and_si128(is62, _mm_set1_epi8(62 - char62)));
+  shift = _mm_or_si128(shift, _mm_and_si128(is63, _mm_set1_epi8(63 - char63)));
+  values = _mm_add_epi8(in, shift);
+  return true;
+}
+
+/**
+ * Joins the 6 bit values to 12 bytes in the low 96 bits.
+ */
+BASE64_SSSE3 static inline __m128i packSsse3(__m128i values) {
+  const __m128i pairs =
+      _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+                                                13, 12, -1, -1, -1, -1));
+}
+
+BASE64_SSSE3 bool Base64::decodeSsse3(const char *encoded, std::size_t size,
+                                      unsigned char *decoded,
+                                      Alphabet alphabet,
+                                      std::size_t &consumed) {
+  const char char62 = getChar62(alphabet);
+  const char char63 = getChar63(alphabet);
+  std::size_t i = 0;
+  unsigned char *out = decoded;
+  for (; i + 16 <= size; i += 16) {
+    __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(encoded + i));
+    __m128i values;
+    if (!toValuesSsse3(in, char62, char63, values)) {
+      return false;
+    }
+    __m128i bytes = packSsse3(values);
+    // store 12 bytes, the output has no room for 16
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), bytes);
+    std::uint32_t last = static_cast<std::uint32_t>(
+        _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+    std::memcpy(out + 8, &last, sizeof(last));
+    out += 12;
+  }
+  consumed = i;
+  return true;
+}
+
+BASE64_AVX2 static inline __m256i inRangeAvx2(__m256i in, char low,
+                                              char high) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(low - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), in));
+}
+
+BASE64_AVX2 static inline bool toValuesAvx2(__m256i in, char char62,
+                                            char char63, __m256i &values) {
+  const __m256i upper = inRangeAvx2(in, 'A', 'Z');
+  const __m256i lower = inRangeAvx2(in, 'a', 'z');
+  const __m256i digit = inRangeAvx2(in, '0', '9');
+  const __m256i is62 = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(char62));
+  const __m256i is63 = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(char63));
+  const __m256i valid = _mm256_or_si256(
+      _mm256_or_si256(_mm256_or_si256(upper, lower),
+                      _mm256_or_si256(digit, is62)),
+      is63);
+  if (_mm256_movemask_epi8(valid) != -1) {
+    return false;
+  }
+  __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+  shift = _mm256_or_si256(shift,
+                          _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+  shift = _mm256_or_si256(shift,
+                          _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+  shift = _mm256_or_si256(
+      shift, _mm256_and_si256(is62, _mm256_set1_epi8(62 - char62)));
+  shift = _mm256_or_si256(
+      shift, _mm256_and_si256(is63, _mm256_set1_epi8(63 - char63)));
+  values = _mm256_add_epi8(in, shift);
+  return true;
+}
+
+/**
+ * Joins the 6 bit values to 24 bytes in the low 192 bits. Each lane packs 12
+ * bytes, which are moved together by a permutation of the 32 bit words.
+ */
+BASE64_AVX2 static inline __m256i packAvx2(__m256i values) {
+  const __m256i pairs =
+      _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+  const __m256i groups =
+      _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+  const __m256i lanes = _mm256_shuffle_epi8(
+      groups,
+      _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                       2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  return _mm256_permutevar8x32_epi32(lanes,
+                                     _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+}
+
+BASE64_AVX2 bool Base64::decodeAvx2(const char *encoded, std::size_t size,
+                                    unsigned char *decoded, Alphabet alphabet,
+                                    std::size_t &consumed) {
+  const char char62 = getChar62(alphabet);
+  const char char63 = getChar63(alphabet);
+  std::size_t i = 0;
+  unsigned char *out = decoded;
+  for (; i + 32 <= size; i += 32) {
+    __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(encoded + i));
+    __m256i values;
+    if (!toValuesAvx2(in, char62, char63, values)) {
+      return false;
+    }
+    __m256i bytes = packAvx2(values);
+    // store 24 bytes, the output has no room for 32
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm256_castsi256_si128(bytes));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16),
+                     _mm256_extracti128_si256(bytes, 1));
+    out += 24;
+  }
+  consumed = i;
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#else
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// The SIMD kernels are only available on x86. Base64::isSupported() returns
+// false for them.
+std::size_t Base64::encodeSsse3(const unsigned char *, std::size_t, char *,
+                                Alphabet) {
+  return 0;
+}
+
+std::size_t Base64::encodeAvx2(const unsigned char *, std::size_t, char *,
+                               Alphabet) {
+  return 0;
+}
+
+bool Base64::decodeSsse3(const char *, std::size_t, unsigned char *, Alphabet,
+                         std::size_t &consumed) {
+  consumed = 0;
+  return true;
+}
+
+bool Base64::decodeAvx2(const char *, std::size_t, unsigned char *, Alphabet,
+                        std::size_t &consumed) {
+  consumed = 0;
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#endif
@@ -0,0 +1,1048 @@
+#include "Benchmark.h"
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#ifdef __linux__
+#include <fcntl.h>   // ::open(...) ; ::posix_fadvise(...)
+#include <unistd.h>  // ::close(...)
+#endif
+
+#include <algorithm>  // std::find(...) ; std::max(...) ; std::transform(...)
+#include <cctype>     // std::toupper(...)
+#include <chrono>
+#include <cstdio>    // std::remove(...)
+#include <fstream>
+#include <iomanip>   // std::setw(...)
+#include <iostream>  // std::cout(...) ; std::cerr(...)
+#include <random>    // std::mt19937
+#include <sstream>
+#include <string>
+#include <thread>  // std::thread::hardware_concurrency(...)
+#include <vector>
+
+#include "Algorithm.h"
+#include "Client.h"
+#include "KeyStore.h"
+#include "LatencyHistogram.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Removes the clean pages of the file from the page cache, so the next read
+ * comes from the disk.
+ */
+static bool dropFileCache(const std::string &fileName) {
+#ifdef __linux__
+  int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  bool result = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  ::close(fd);
+  return result;
+#else
+  return false;
+#endif
+}
+
+double Benchmark::measure(const std::function<bool()> &operation,
+                          unsigned int milliseconds) {
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::milliseconds(milliseconds);
+  unsigned long count = 0;
+  Clock::time_point now;
+  do {
+    if (!operation()) {
+      return -1;
+    }
+    count++;
+    now = Clock::now();
+  } while (now < end);
+  return count / std::chrono::duration<double>(now - start).count();
+}
+
+/**
+ * A BIO pair buffers the records of each side until the other side reads
+ * them. The handshake is complete if both objects returned 1.
+ */
+bool Benchmark::handshake(::SSL_CTX *serverContext, ::SSL_CTX *clientContext) {
+  ::SSL *server = ::SSL_new(serverContext);
+  ::SSL *client = ::SSL_new(clientContext);
+  ::BIO *serverBio = nullptr;
+  ::BIO *clientBio = nullptr;
+  if (server == nullptr || client == nullptr ||
+      ::BIO_new_bio_pair(&serverBio, 0, &clientBio, 0) != 1) {
+    ::SSL_free(server);
+    ::SSL_free(client);
+    return false;
+  }
+  ::SSL_set_bio(server, serverBio, serverBio);
+  ::SSL_set_bio(client, clientBio, clientBio);
+  ::SSL_set_accept_state(server);
+  ::SSL_set_connect_state(client);
+
+  bool serverDone = false;
+  bool clientDone = false;
+  bool failed = false;
+  // a TLS 1.3 handshake needs two flights per side
+  for (int i = 0; i < 16 && !failed && !(serverDone && clientDone); i++) {
+    if (!clientDone) {
+      int rc = ::SSL_do_handshake(client);
+      clientDone = rc == 1;
+      failed = rc != 1 && ::SSL_get_error(client, rc) != SSL_ERROR_WANT_READ;
+    }
+    if (!serverDone && !failed) {
+      int rc = ::SSL_do_handshake(server);
+      serverDone = rc == 1;
+      failed = rc != 1 && ::SSL_get_error(server, rc) != SSL_ERROR_WANT_READ;
+    }
+  }
+  if (failed) {
+    ::ERR_print_errors_fp(stderr);
+  }
+  ::SSL_free(server);
+  ::SSL_free(client);
+  return serverDone && clientDone;
+}
+
+/**
+ * The server context has neither a session cache nor tickets, so each
+ * handshake performs the key exchange and the signature of the server key.
+ */
+int Benchmark::runKeyAlgorithms(unsigned int milliseconds) {
+  const std::vector<OpenSslWrapper::KeyAlgorithm> algorithms = {
+      OpenSslWrapper::KeyAlgorithm::Rsa2048,
+      OpenSslWrapper::KeyAlgorithm::Rsa3072,
+      OpenSslWrapper::KeyAlgorithm::Rsa4096,
+      OpenSslWrapper::KeyAlgorithm::EcdsaP256,
+      OpenSslWrapper::KeyAlgorithm::EcdsaP384,
+      OpenSslWrapper::KeyAlgorithm::Ed25519};
+  const std::string message(64, 'x');
+
+  OpenSslWrapper::TlsContextPtr clientContext(
+      OpenSslWrapper::createTlsContextClient());
+  if (!clientContext) {
+    return -1;
+  }
+  ::SSL_CTX_set_session_cache_mode(clientContext.get(), SSL_SESS_CACHE_OFF);
+
+  std::cout << "Operations per second (" << milliseconds << " ms each)"
+            << std::endl;
+  std::cout << std::left << std::setw(10) << "Algorithm" << std::right
+            << std::setw(12) << "keygen/s" << std::setw(12) << "sign/s"
+            << std::setw(12) << "verify/s" << std::setw(14) << "handshakes/s"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  int result = 0;
+  for (OpenSslWrapper::KeyAlgorithm algorithm : algorithms) {
+    OpenSslWrapper::TlsKey key = {};
+    double keygen = Benchmark::measure(
+        [algorithm, &key]() {
+          return OpenSslWrapper::generateKey(algorithm, key);
+        },
+        milliseconds);
+
+    OpenSslWrapper::TlsX509Cert cert = {};
+    OpenSslWrapper::TlsKey publicKey = {};
+    std::string signature;
+    if (keygen < 0 || !OpenSslWrapper::createSelfSignedCert(key, cert) ||
+        !OpenSslWrapper::readCertKey(cert, publicKey) ||
+        !OpenSslWrapper::signData(key, message, signature)) {
+      std::cerr << "Failed to create key "
+                << OpenSslWrapper::getKeyAlgorithmName(algorithm) << "."
+                << std::endl;
+      result = -1;
+      continue;
+    }
+
+    double sign = Benchmark::measure(
+        [&key, &message, &signature]() {
+          return OpenSslWrapper::signData(key, message, signature);
+        },
+        milliseconds);
+    double verify = Benchmark::measure(
+        [&publicKey, &message, &signature]() {
+          return OpenSslWrapper::verifySignedData(publicKey, message,
+                                                  signature, "");
+        },
+        milliseconds);
+
+    double handshakes = -1;
+    OpenSslWrapper::TlsContextPtr serverContext(
+        OpenSslWrapper::createTlsContextServer());
+    if (serverContext &&
+        ::SSL_CTX_use_certificate(serverContext.get(), cert.get()) == 1 &&
+        ::SSL_CTX_use_PrivateKey(serverContext.get(), key.get()) == 1) {
+      ::SSL_CTX_set_session_cache_mode(serverContext.get(), SSL_SESS_CACHE_OFF);
+      ::SSL_CTX_set_options(serverContext.get(), SSL_OP_NO_TICKET);
+      ::SSL_CTX *server = serverContext.get();
+      ::SSL_CTX *client = clientContext.get();
+      handshakes = Benchmark::measure(
+          [server, client]() { return Benchmark::handshake(server, client); },
+          milliseconds);
+    }
+
+    if (sign < 0 || verify < 0 || handshakes < 0) {
+      result = -1;
+    }
+    std::cout << std::left << std::setw(10)
+              << OpenSslWrapper::getKeyAlgorithmName(algorithm) << std::right
+              << std::setw(12) << keygen << std::setw(12) << sign
+              << std::setw(12) << verify << std::setw(14) << handshakes
+              << std::endl;
+  }
+  return result;
+}
+
+/**
+ * Each operation processes the whole batch, so the rate is multiplied by the
+ * batch size. Every message differs, so no signature is computed twice.
+ */
+int Benchmark::runSignatures(OpenSslWrapper::KeyAlgorithm algorithm,
+                             unsigned int milliseconds, unsigned int threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  OpenSslWrapper::TlsKey key = {};
+  OpenSslWrapper::TlsX509Cert cert = {};
+  OpenSslWrapper::TlsKey publicKey = {};
+  if (!OpenSslWrapper::generateKey(algorithm, key) ||
+      !OpenSslWrapper::createSelfSignedCert(key, cert) ||
+      !OpenSslWrapper::readCertKey(cert, publicKey)) {
+    std::cerr << "Failed to create key." << std::endl;
+    return -1;
+  }
+
+  std::vector<std::string> messages;
+  for (unsigned int i = 0; i < Benchmark::SIGNATURE_BATCH_SIZE; i++) {
+    messages.push_back("message " + std::to_string(i));
+  }
+  std::vector<std::string> signatures;
+  std::vector<bool> results;
+  if (!OpenSslWrapper::signDataBatch(key, messages, signatures, results)) {
+    std::cerr << "Failed to sign batch." << std::endl;
+    return -1;
+  }
+
+  auto allValid = [&results]() {
+    return std::find(results.begin(), results.end(), false) == results.end();
+  };
+  std::vector<std::string> singleSignatures(messages.size());
+  double singleSign = Benchmark::measure(
+      [&]() {
+        for (std::size_t i = 0; i < messages.size(); i++) {
+          if (!OpenSslWrapper::signData(key, messages[i],
+                                        singleSignatures[i])) {
+            return false;
+          }
+        }
+        return true;
+      },
+      milliseconds);
+  double singleVerify = Benchmark::measure(
+      [&]() {
+        for (std::size_t i = 0; i < messages.size(); i++) {
+          if (!OpenSslWrapper::verifySignedData(publicKey, messages[i],
+                                                signatures[i], "")) {
+            return false;
+          }
+        }
+        return true;
+      },
+      milliseconds);
+  double batchSign[2];
+  double batchVerify[2];
+  unsigned int batchThreads[2] = {1, threads};
+  for (int i = 0; i < 2; i++) {
+    unsigned int count = batchThreads[i];
+    batchSign[i] = Benchmark::measure(
+        [&]() {
+          return OpenSslWrapper::signDataBatch(key, messages, signatures,
+                                               results, count) &&
+                 allValid();
+        },
+        milliseconds);
+    batchVerify[i] = Benchmark::measure(
+        [&]() {
+          return OpenSslWrapper::verifySignedDataBatch(
+                     publicKey, messages, signatures, "", results, count) &&
+                 allValid();
+        },
+        milliseconds);
+  }
+
+  const double size = Benchmark::SIGNATURE_BATCH_SIZE;
+  std::cout << "Messages per second with "
+            << OpenSslWrapper::getKeyAlgorithmName(algorithm) << " ("
+            << messages.size() << " messages per batch, " << milliseconds
+            << " ms each)" << std::endl;
+  std::cout << std::left << std::setw(20) << "Method" << std::right
+            << std::setw(12) << "sign/s" << std::setw(12) << "verify/s"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::left << std::setw(20) << "single calls" << std::right
+            << std::setw(12) << singleSign * size << std::setw(12)
+            << singleVerify * size << std::endl;
+  for (int i = 0; i < 2; i++) {
+    std::cout << std::left << std::setw(20)
+              << "batch " + std::to_string(batchThreads[i]) + " thread(s)"
+              << std::right << std::setw(12) << batchSign[i] * size
+              << std::setw(12) << batchVerify[i] * size << std::endl;
+  }
+
+  bool failed = singleSign < 0 || singleVerify < 0;
+  for (int i = 0; i < 2; i++) {
+    failed = failed || batchSign[i] < 0 || batchVerify[i] < 0;
+  }
+  return failed ? -1 : 0;
+}
+
+int Benchmark::runKeyStore(OpenSslWrapper::KeyAlgorithm algorithm,
+                           unsigned int milliseconds) {
+  const std::string keyFileName = "benchmark-key.pem";
+  const std::string certFileName = "benchmark-cert.pem";
+  if (!OpenSslWrapper::createSelfSignedCert(keyFileName, certFileName, "",
+                                            algorithm)) {
+    std::cerr << "Failed to create self signed certificate." << std::endl;
+    return -1;
+  }
+  const std::string message(64, 'x');
+  std::string signature;
+
+  double readSign = Benchmark::measure(
+      [&]() {
+        OpenSslWrapper::TlsKey key = {};
+        return OpenSslWrapper::readKeyFile(keyFileName, key, "") &&
+               OpenSslWrapper::signData(key, message, signature);
+      },
+      milliseconds);
+  double readVerify = Benchmark::measure(
+      [&]() {
+        OpenSslWrapper::TlsKey key = {};
+        return OpenSslWrapper::readCertKey(certFileName, key) &&
+               OpenSslWrapper::verifySignedData(key, message, signature, "");
+      },
+      milliseconds);
+
+  KeyStore keyStore;
+  double storeSign = Benchmark::measure(
+      [&]() {
+        OpenSslWrapper::TlsKey key = {};
+        return keyStore.getKey(keyFileName, "", key) &&
+               OpenSslWrapper::signData(key, message, signature);
+      },
+      milliseconds);
+  double storeVerify = Benchmark::measure(
+      [&]() {
+        OpenSslWrapper::TlsKey key = {};
+        return keyStore.getCertKey(certFileName, key) &&
+               OpenSslWrapper::verifySignedData(key, message, signature, "");
+      },
+      milliseconds);
+
+  std::remove(keyFileName.c_str());
+  std::remove(certFileName.c_str());
+
+  std::cout << "Operations per second with "
+            << OpenSslWrapper::getKeyAlgorithmName(algorithm) << " ("
+            << milliseconds << " ms each)" << std::endl;
+  std::cout << std::left << std::setw(20) << "Key source" << std::right
+            << std::setw(12) << "sign/s" << std::setw(12) << "verify/s"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::left << std::setw(20) << "read file" << std::right
+            << std::setw(12) << readSign << std::setw(12) << readVerify
+            << std::endl;
+  std::cout << std::left << std::setw(20) << "key store" << std::right
+            << std::setw(12) << storeSign << std::setw(12) << storeVerify
+            << std::endl;
+  std::cout << "Parsed files: " << keyStore.getLoadCount()
+            << ", cache hits: " << keyStore.getHitCount() << std::endl;
+
+  return readSign < 0 || readVerify < 0 || storeSign < 0 || storeVerify < 0
+             ? -1
+             : 0;
+}
+
+/**
+ * The URL alphabet is compared with the BIO output after the characters 62
+ * and 63 have been replaced and the padding has been removed.
+ */
+bool Benchmark::verifyBase64(Base64::Kernel kernel) {
+  // a fixed seed, so a failure can be reproduced
+  std::mt19937 random(42);
+  for (std::size_t size = 0; size <= 300; size++) {
+    std::string data(size, '\0');
+    for (char &c : data) {
+      c = static_cast<char>(random() & 0xFF);
+    }
+    const unsigned char *bytes =
+        reinterpret_cast<const unsigned char *>(data.data());
+    std::string expected;
+    if (!Base64::encodeOpenSsl(data, expected)) {
+      return false;
+    }
+    std::string expectedUrl = expected;
+    std::replace(expectedUrl.begin(), expectedUrl.end(), '+', '-');
+    std::replace(expectedUrl.begin(), expectedUrl.end(), '/', '_');
+    expectedUrl.erase(expectedUrl.find_last_not_of('=') + 1);
+
+    for (Base64::Alphabet alphabet :
+         {Base64::Alphabet::Standard, Base64::Alphabet::Url}) {
+      const std::string &reference =
+          alphabet == Base64::Alphabet::Url ? expectedUrl : expected;
+      std::string encoded(Base64::getEncodedSize(size, alphabet), '\0');
+      encoded.resize(
+          Base64::encode(bytes, size, &encoded[0], alphabet, kernel));
+      if (encoded != reference) {
+        std::cerr << "Encoding of " << size << " bytes differs." << std::endl;
+        return false;
+      }
+      std::string decoded(Base64::getMaxDecodedSize(encoded.size()), '\0');
+      std::size_t decodedSize = 0;
+      if (!Base64::decode(encoded.data(), encoded.size(),
+                          reinterpret_cast<unsigned char *>(&decoded[0]),
+                          decodedSize, alphabet, kernel) ||
+          decoded.substr(0, decodedSize) != data) {
+        std::cerr << "Decoding of " << size << " bytes differs." << std::endl;
+        return false;
+      }
+      if (encoded.empty()) {
+        continue;
+      }
+      // a character which is not part of the alphabet at a random position
+      const char invalid[] = {'*', '\n', '=', '\x80',
+                              alphabet == Base64::Alphabet::Url ? '+' : '-'};
+      for (char c : invalid) {
+        std::string corrupted = encoded;
+        corrupted[random() % (encoded.find('=') == std::string::npos
+                                  ? encoded.size()
+                                  : encoded.find('='))] = c;
+        if (Base64::decode(corrupted.data(), corrupted.size(),
+                           reinterpret_cast<unsigned char *>(&decoded[0]),
+                           decodedSize, alphabet, kernel)) {
+          std::cerr << "Invalid character in " << corrupted << " accepted."
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  // unused bits which are not zero and misplaced padding
+  for (const char *invalid : {"QR==", "QUJ=", "Q===", "QQ=A", "=QQA", "A"}) {
+    std::string encoded(invalid);
+    unsigned char decoded[4];
+    std::size_t decodedSize = 0;
+    if (Base64::decode(encoded.data(), encoded.size(), decoded, decodedSize,
+                       Base64::Alphabet::Standard, kernel)) {
+      std::cerr << "Invalid encoding " << encoded << " accepted." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Small inputs are repeated within one operation, so the time of the clock
+ * does not dominate the result.
+ */
+int Benchmark::runBase64(unsigned int milliseconds) {
+  const std::vector<Base64::Kernel> allKernels = {
+      Base64::Kernel::Scalar, Base64::Kernel::Ssse3, Base64::Kernel::Avx2};
+  const std::vector<std::size_t> sizes = {64, 1024, 65536, 1048576};
+
+  int result = 0;
+  std::vector<Base64::Kernel> kernels;
+  for (Base64::Kernel kernel : allKernels) {
+    if (!Base64::isSupported(kernel)) {
+      std::cout << "Kernel " << Base64::getKernelName(kernel)
+                << " is not supported by the CPU." << std::endl;
+      continue;
+    }
+    bool valid = Benchmark::verifyBase64(kernel);
+    std::cout << "Kernel " << Base64::getKernelName(kernel)
+              << (valid ? " matches" : " differs from")
+              << " the OpenSSL base64 BIO." << std::endl;
+    if (valid) {
+      kernels.push_back(kernel);
+    } else {
+      result = -1;
+    }
+  }
+
+  std::cout << "GB/s of the input (" << milliseconds << " ms each)"
+            << std::endl;
+  std::cout << std::left << std::setw(10) << "Kernel" << std::right
+            << std::setw(10) << "Size" << std::setw(12) << "encode"
+            << std::setw(12) << "decode" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  std::mt19937 random(42);
+  for (std::size_t size : sizes) {
+    std::string data(size, '\0');
+    for (char &c : data) {
+      c = static_cast<char>(random() & 0xFF);
+    }
+    const unsigned char *bytes =
+        reinterpret_cast<const unsigned char *>(data.data());
+    std::string encoded;
+    Base64::encodeOpenSsl(data, encoded);
+    std::vector<char> encodeBuffer(encoded.size());
+    std::vector<unsigned char> decodeBuffer(size);
+    const std::size_t repeats =
+        std::max<std::size_t>(1, Benchmark::BASE64_MIN_BYTES / size);
+    const double bytesPerOperation = static_cast<double>(size * repeats);
+
+    auto print = [&](const std::string &name, double encodeRate,
+                     double decodeRate) {
+      if (encodeRate < 0 || decodeRate < 0) {
+        result = -1;
+      }
+      std::cout << std::left << std::setw(10) << name << std::right
+                << std::setw(10) << size << std::setw(12)
+                << encodeRate * bytesPerOperation / 1e9 << std::setw(12)
+                << decodeRate * bytesPerOperation / 1e9 << std::endl;
+    };
+
+    for (Base64::Kernel kernel : kernels) {
+      double encodeRate = Benchmark::measure(
+          [&]() {
+            for (std::size_t i = 0; i < repeats; i++) {
+              Base64::encode(bytes, size, encodeBuffer.data(),
+                             Base64::Alphabet::Standard, kernel);
+            }
+            return true;
+          },
+          milliseconds);
+      double decodeRate = Benchmark::measure(
+          [&]() {
+            std::size_t decodedSize = 0;
+            for (std::size_t i = 0; i < repeats; i++) {
+              if (!Base64::decode(encoded.data(), encoded.size(),
+                                  decodeBuffer.data(), decodedSize,
+                                  Base64::Alphabet::Standard, kernel)) {
+                return false;
+              }
+            }
+            return true;
+          },
+          milliseconds);
+      print(Base64::getKernelName(kernel), encodeRate, decodeRate);
+    }
+
+    std::string output;
+    double encodeRate = Benchmark::measure(
+        [&]() {
+          for (std::size_t i = 0; i < repeats; i++) {
+            if (!Base64::encodeOpenSsl(data, output)) {
+              return false;
+            }
+          }
+          return true;
+        },
+        milliseconds);
+    double decodeRate = Benchmark::measure(
+        [&]() {
+          for (std::size_t i = 0; i < repeats; i++) {
+            if (!Base64::decodeOpenSsl(encoded, output)) {
+              return false;
+            }
+          }
+          return true;
+        },
+        milliseconds);
+    print("openssl", encodeRate, decodeRate);
+  }
+  return result;
+}
+
+int Benchmark::runHashFile(const std::string &fileName,
+                           unsigned int milliseconds, unsigned int threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::string hashFileName = fileName;
+  if (hashFileName.empty()) {
+    hashFileName = "benchmark-hash.bin";
+    std::ofstream file(hashFileName.c_str(), std::ofstream::binary);
+    std::mt19937 random(42);
+    std::vector<char> block(1024 * 1024);
+    for (unsigned long long written = 0;
+         written < Benchmark::HASH_FILE_SIZE && file.good();
+         written += block.size()) {
+      for (char &c : block) {
+        c = static_cast<char>(random() & 0xFF);
+      }
+      file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    if (!file.good()) {
+      std::cerr << "Failed to create file " << hashFileName << "."
+                << std::endl;
+      std::remove(hashFileName.c_str());
+      return -1;
+    }
+  }
+  std::ifstream file(hashFileName.c_str(),
+                     std::ifstream::binary | std::ifstream::ate);
+  const double size = static_cast<double>(file.tellg());
+  file.close();
+
+  const std::vector<Algorithm::HashFileMethod> methods = {
+      Algorithm::HashFileMethod::Stream, Algorithm::HashFileMethod::Read,
+      Algorithm::HashFileMethod::Map, Algorithm::HashFileMethod::Auto};
+  const bool coldSupported = dropFileCache(hashFileName);
+  std::vector<unsigned char> expected;
+  int result = 0;
+
+  std::cout << "MB/s of " << hashFileName << " (" << size / 1e6 << " MB, "
+            << milliseconds << " ms each)" << std::endl;
+  std::cout << std::left << std::setw(10) << "Method" << std::right
+            << std::setw(12) << "cold" << std::setw(12) << "warm"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  auto print = [&](const std::string &name, double cold, double warm) {
+    if (warm < 0 || (coldSupported && cold < 0)) {
+      std::cerr << "The hash of " << name << " failed or differs."
+                << std::endl;
+      result = -1;
+    }
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(12);
+    if (coldSupported) {
+      std::cout << cold * size / 1e6;
+    } else {
+      std::cout << "n/a";
+    }
+    std::cout << std::setw(12) << warm * size / 1e6 << std::endl;
+  };
+
+  for (Algorithm::HashFileMethod method : methods) {
+    std::vector<unsigned char> hash;
+    auto calc = [&]() {
+      return Algorithm::calcSha256File(hashFileName, hash, method) &&
+             (expected.empty() || hash == expected);
+    };
+    double cold = -1;
+    if (coldSupported) {
+      cold = Benchmark::measure(
+          [&]() { return dropFileCache(hashFileName) && calc(); },
+          milliseconds);
+    }
+    double warm = Benchmark::measure(calc, milliseconds);
+    if (expected.empty()) {
+      expected = hash;
+    }
+    print(Algorithm::getHashFileMethodName(method), cold, warm);
+  }
+
+  // the tree root differs from the SHA-256 of the file
+  std::vector<unsigned char> expectedRoot;
+  unsigned int treeThreads[2] = {1, threads};
+  for (unsigned int count : treeThreads) {
+    std::vector<unsigned char> root;
+    auto calc = [&]() {
+      return Algorithm::calcSha256TreeFile(hashFileName, root, count) &&
+             (expectedRoot.empty() || root == expectedRoot);
+    };
+    double cold = -1;
+    if (coldSupported) {
+      cold = Benchmark::measure(
+          [&]() { return dropFileCache(hashFileName) && calc(); },
+          milliseconds);
+    }
+    double warm = Benchmark::measure(calc, milliseconds);
+    if (expectedRoot.empty()) {
+      expectedRoot = root;
+    }
+    print("tree " + std::to_string(count), cold, warm);
+  }
+
+  if (fileName.empty()) {
+    std::remove(hashFileName.c_str());
+  }
+  return result;
+}
+
+bool Benchmark::verifySha256Batch(Sha256Batch::Kernel kernel) {
+  // a fixed seed, so a failure can be reproduced
+  std::mt19937 random(42);
+  std::vector<std::string> data;
+  for (std::size_t size = 0; size <= 300; size++) {
+    data.emplace_back(size, '\0');
+  }
+  for (std::size_t i = 0; i < 100; i++) {
+    data.emplace_back(random() % 2000, '\0');
+  }
+  for (std::string &input : data) {
+    for (char &c : input) {
+      c = static_cast<char>(random() & 0xFF);
+    }
+  }
+  std::vector<std::string_view> inputs(data.begin(), data.end());
+  // every batch size up to a few times the 8 lanes of the AVX2 kernel
+  for (std::size_t count = 0; count <= inputs.size(); count++) {
+    if (count > 24 && count != inputs.size()) {
+      continue;
+    }
+    std::vector<unsigned char> expected(count * Sha256Batch::DIGEST_SIZE);
+    std::vector<unsigned char> digests(count * Sha256Batch::DIGEST_SIZE);
+    // the reference does not share code with any kernel
+    for (std::size_t i = 0; i < count; i++) {
+      if (::EVP_Digest(inputs[i].data(), inputs[i].size(),
+                       expected.data() + i * Sha256Batch::DIGEST_SIZE,
+                       nullptr, ::EVP_sha256(), nullptr) != 1) {
+        return false;
+      }
+    }
+    if (!Sha256Batch::hash(inputs.data(), count, digests.data(), kernel)) {
+      return false;
+    }
+    if (digests != expected) {
+      std::cerr << "Digests of a batch of " << count << " inputs differ."
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int Benchmark::runSha256Batch(unsigned int milliseconds) {
+  const std::vector<Sha256Batch::Kernel> allKernels = {
+      Sha256Batch::Kernel::OpenSsl, Sha256Batch::Kernel::Avx2,
+      Sha256Batch::Kernel::ShaNi};
+
+  int result = 0;
+  std::vector<Sha256Batch::Kernel> kernels;
+  for (Sha256Batch::Kernel kernel : allKernels) {
+    if (!Sha256Batch::isSupported(kernel)) {
+      std::cout << "Kernel " << Sha256Batch::getKernelName(kernel)
+                << " is not supported by the CPU." << std::endl;
+      continue;
+    }
+    bool valid = Benchmark::verifySha256Batch(kernel);
+    std::cout << "Kernel " << Sha256Batch::getKernelName(kernel)
+              << (valid ? " matches" : " differs from")
+              << " the OpenSSL SHA-256." << std::endl;
+    if (valid) {
+      kernels.push_back(kernel);
+    } else {
+      result = -1;
+    }
+  }
+
+  std::mt19937 random(42);
+  std::vector<std::string> keys(Benchmark::SHA256_BATCH_SIZE);
+  for (std::string &key : keys) {
+    key.resize(16 + random() % 49);
+    for (char &c : key) {
+      c = static_cast<char>(random() & 0xFF);
+    }
+  }
+  std::vector<std::string_view> inputs(keys.begin(), keys.end());
+  std::vector<unsigned char> digests(keys.size() * Sha256Batch::DIGEST_SIZE);
+
+  std::cout << "Hashes/s of " << keys.size() << " keys of 16 to 64 bytes ("
+            << milliseconds << " ms each)" << std::endl;
+  std::cout << std::left << std::setw(18) << "Kernel" << std::right
+            << std::setw(14) << "hashes/s" << std::setw(10) << "speedup"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  double baseline = 0;
+  auto print = [&](const std::string &name, double rate) {
+    if (rate < 0) {
+      result = -1;
+    }
+    double hashes = rate * static_cast<double>(keys.size());
+    if (baseline == 0) {
+      baseline = hashes;
+    }
+    std::cout << std::left << std::setw(18) << name << std::right
+              << std::setw(14) << std::setprecision(0) << hashes
+              << std::setw(10) << std::setprecision(2) << hashes / baseline
+              << std::endl;
+  };
+
+  std::string hashString;
+  double rate = Benchmark::measure(
+      [&]() {
+        for (const std::string &key : keys) {
+          if (!Algorithm::calcSha256String(key, hashString)) {
+            return false;
+          }
+        }
+        return true;
+      },
+      milliseconds);
+  print("calcSha256String", rate);
+  for (Sha256Batch::Kernel kernel : kernels) {
+    rate = Benchmark::measure(
+        [&]() {
+          return Sha256Batch::hash(inputs.data(), inputs.size(),
+                                   digests.data(), kernel);
+        },
+        milliseconds);
+    print(Sha256Batch::getKernelName(kernel), rate);
+  }
+  return result;
+}
+
+/**
+ * The formatting of the hex digits which Algorithm used before the Hex
+ * codec.
+ */
+static std::string encodeHexStream(const unsigned char *data,
+                                   std::size_t size) {
+  std::stringstream stream;
+  stream << std::hex << std::setfill('0');
+  for (std::size_t i = 0; i < size; i++) {
+    stream << std::setw(2) << static_cast<int>(data[i]);
+  }
+  return stream.str();
+}
+
+bool Benchmark::verifyHex(Hex::Kernel kernel) {
+  // a fixed seed, so a failure can be reproduced
+  std::mt19937 random(42);
+  for (std::size_t size = 0; size <= 300; size++) {
+    std::vector<unsigned char> data(size);
+    for (unsigned char &c : data) {
+      c = static_cast<unsigned char>(random() & 0xFF);
+    }
+    const std::string expected = encodeHexStream(data.data(), size);
+    std::string encoded(Hex::getEncodedSize(size), '\0');
+    Hex::encode(data.data(), size, &encoded[0], kernel);
+    if (encoded != expected) {
+      std::cerr << "Encoding of " << size << " bytes differs." << std::endl;
+      return false;
+    }
+    std::string upper = encoded;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](char c) {
+      return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    });
+    std::vector<unsigned char> decoded(size);
+    for (const std::string &digits : {encoded, upper}) {
+      if (!Hex::decode(digits.data(), digits.size(), decoded.data(),
+                       kernel) ||
+          decoded != data) {
+        std::cerr << "Decoding of " << size << " bytes differs." << std::endl;
+        return false;
+      }
+    }
+    if (encoded.empty()) {
+      continue;
+    }
+    // a character which is not a digit at a random position
+    for (char c : {'g', 'G', '/', ':', '@', '`', ' ', '\x80', '\xB0'}) {
+      std::string corrupted = encoded;
+      corrupted[random() % corrupted.size()] = c;
+      if (Hex::decode(corrupted.data(), corrupted.size(), decoded.data(),
+                      kernel)) {
+        std::cerr << "Invalid character in " << corrupted << " accepted."
+                  << std::endl;
+        return false;
+      }
+    }
+    if (Hex::decode(encoded.data(), encoded.size() - 1, decoded.data(),
+                    kernel)) {
+      std::cerr << "Odd number of digits accepted." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int Benchmark::runHex(unsigned int milliseconds) {
+  const std::vector<Hex::Kernel> allKernels = {Hex::Kernel::Scalar,
+                                               Hex::Kernel::Ssse3};
+  const std::vector<std::size_t> sizes = {SHA256_DIGEST_LENGTH, 1024, 65536};
+
+  int result = 0;
+  std::vector<Hex::Kernel> kernels;
+  for (Hex::Kernel kernel : allKernels) {
+    if (!Hex::isSupported(kernel)) {
+      std::cout << "Kernel " << Hex::getKernelName(kernel)
+                << " is not supported by the CPU." << std::endl;
+      continue;
+    }
+    bool valid = Benchmark::verifyHex(kernel);
+    std::cout << "Kernel " << Hex::getKernelName(kernel)
+              << (valid ? " matches" : " differs from")
+              << " std::stringstream." << std::endl;
+    if (valid) {
+      kernels.push_back(kernel);
+    } else {
+      result = -1;
+    }
+  }
+
+  std::cout << "ns per operation (" << milliseconds << " ms each)"
+            << std::endl;
+  std::cout << std::left << std::setw(14) << "Kernel" << std::right
+            << std::setw(10) << "Size" << std::setw(12) << "encode"
+            << std::setw(12) << "decode" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  std::mt19937 random(42);
+  for (std::size_t size : sizes) {
+    std::vector<unsigned char> data(size);
+    for (unsigned char &c : data) {
+      c = static_cast<unsigned char>(random() & 0xFF);
+    }
+    const std::string encoded = encodeHexStream(data.data(), size);
+    std::vector<char> encodeBuffer(encoded.size());
+    std::vector<unsigned char> decodeBuffer(size);
+    // repeat small operations, so the clock is not measured
+    const std::size_t repeats =
+        std::max<std::size_t>(1, Benchmark::BASE64_MIN_BYTES / size);
+
+    auto print = [&](const std::string &name, double encodeRate,
+                     double decodeRate) {
+      if (encodeRate < 0 || decodeRate < 0) {
+        result = -1;
+      }
+      std::cout << std::left << std::setw(14) << name << std::right
+                << std::setw(10) << size << std::setw(12)
+                << 1e9 / (encodeRate * static_cast<double>(repeats));
+      if (decodeRate == 0) {
+        std::cout << std::setw(12) << "n/a";
+      } else {
+        std::cout << std::setw(12)
+                  << 1e9 / (decodeRate * static_cast<double>(repeats));
+      }
+      std::cout << std::endl;
+    };
+
+    double encodeRate = Benchmark::measure(
+        [&]() {
+          for (std::size_t i = 0; i < repeats; i++) {
+            if (encodeHexStream(data.data(), size).size() != encoded.size()) {
+              return false;
+            }
+          }
+          return true;
+        },
+        milliseconds);
+    print("stringstream", encodeRate, 0);
+
+    for (Hex::Kernel kernel : kernels) {
+      encodeRate = Benchmark::measure(
+          [&]() {
+            for (std::size_t i = 0; i < repeats; i++) {
+              Hex::encode(data.data(), size, encodeBuffer.data(), kernel);
+            }
+            return true;
+          },
+          milliseconds);
+      double decodeRate = Benchmark::measure(
+          [&]() {
+            for (std::size_t i = 0; i < repeats; i++) {
+              if (!Hex::decode(encoded.data(), encoded.size(),
+                               decodeBuffer.data(), kernel)) {
+                return false;
+              }
+            }
+            return true;
+          },
+          milliseconds);
+      print(Hex::getKernelName(kernel), encodeRate, decodeRate);
+    }
+  }
+  return result;
+}
+
+/**
+ * The client waits for the socket after a read which would block, so the
+ * round trip includes the wake up of both sides like a real client.
+ */
+int Benchmark::runLatency(Server::Mode mode, unsigned short port,
+                          unsigned int messages,
+                          unsigned int idleMilliseconds) {
+  const std::string keyFileName = "benchmark-key.pem";
+  const std::string certFileName = "benchmark-cert.pem";
+  if (!OpenSslWrapper::createSelfSignedCert(keyFileName, certFileName, "")) {
+    std::cerr << "Failed to create self signed certificate." << std::endl;
+    return -1;
+  }
+  Server server(port, "127.0.0.1", mode, 1);
+  server.setKeyFileName(keyFileName);
+  server.setCertFileName(certFileName);
+  bool opened = server.open();
+  std::remove(keyFileName.c_str());
+  std::remove(certFileName.c_str());
+  if (!opened) {
+    std::cerr << "Failed to open server." << std::endl;
+    return -1;
+  }
+
+  Client client("127.0.0.1", port);
+  if (!client.open()) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    server.close();
+    return -1;
+  }
+
+  const std::string message = "ping";
+  LatencyHistogram histogram;
+  bool failed = false;
+  for (unsigned int i = 0; i < messages && !failed; i++) {
+    // let the worker go idle
+    std::this_thread::sleep_for(std::chrono::milliseconds(idleMilliseconds));
+
+    auto start = std::chrono::steady_clock::now();
+    if (!client.write(message.c_str(), message.size())) {
+      failed = true;
+      break;
+    }
+    std::size_t received = 0;
+    while (received < message.size()) {
+      BufferView response;
+      int rc = client.tryRead(response);
+      if (rc < 0 || (rc > 0 && response.empty())) {
+        failed = true;
+        break;
+      } else if (rc == 0) {
+        client.waitForData(1000000);
+      } else {
+        received += response.size();
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    histogram.record(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count()));
+  }
+
+  client.close();
+  server.close();
+
+  if (failed || histogram.getCount() == 0) {
+    std::cerr << "Failed to measure latency." << std::endl;
+    return -1;
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "Messages: " << histogram.getCount() << std::endl;
+  std::cout << "Idle before each message: " << idleMilliseconds << " ms"
+            << std::endl;
+  std::cout << "Min latency: " << histogram.getMin() / 1000.0 << " us"
+            << std::endl;
+  std::cout << "Avg latency: " << histogram.getMean() / 1000.0 << " us"
+            << std::endl;
+  std::cout << "p50 latency: " << histogram.getValueAtPercentile(50.0) / 1000.0
+            << " us" << std::endl;
+  std::cout << "p99 latency: " << histogram.getValueAtPercentile(99.0) / 1000.0
+            << " us" << std::endl;
+  std::cout << "Max latency: " << histogram.getMax() / 1000.0 << " us"
+            << std::endl;
+  return 0;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Base64.h"
+#include "Hex.h"
+#include "Sha256Batch.h"
+#include "OpenSslWrapper.h"
+#include "Server.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Measures the throughput of the cryptographic operations used by the server.
+ * Each operation is repeated until the measurement time has elapsed and is
+ * reported in operations per second.
+ */
+class Benchmark {
+ public:  // const
+  // default time to repeat each operation (1s)
+  static const unsigned int DEFAULT_MILLISECONDS = 1000;
+  // number of messages of a signature batch
+  static const unsigned int SIGNATURE_BATCH_SIZE = 1024;
+  // min number of bytes processed per measured base64 operation (64 KiB)
+  static const unsigned int BASE64_MIN_BYTES = 65536;
+  // size of the file created by runHashFile (256 MiB)
+  static const unsigned long long HASH_FILE_SIZE = 256ULL * 1024 * 1024;
+  // number of keys hashed per measured SHA-256 batch operation
+  static const unsigned int SHA256_BATCH_SIZE = 4096;
+
+ public:
+  /**
+   * Measures key generation, signing, verification and full TLS handshakes
+   * for each key algorithm and prints a table of the results.
+   *
+   * @param milliseconds the time to repeat each operation
+   * @return 0 on success, otherwise -1
+   */
+  static int runKeyAlgorithms(unsigned int milliseconds);
+  /**
+   * Compares signing and verifying a batch of messages with single calls of
+   * signData/verifySignedData, with the batch API in one thread and with the
+   * batch API in the given number of threads.
+   *
+   * @param algorithm the algorithm of the generated key
+   * @param milliseconds the time to repeat each operation
+   * @param threads the number of batch threads, 0 uses one per CPU core
+   * @return 0 on success, otherwise -1
+   */
+  static int runSignatures(OpenSslWrapper::KeyAlgorithm algorithm,
+                           unsigned int milliseconds, unsigned int threads);
+  /**
+   * Compares signing and verifying a message with keys which are read from
+   * the files for each operation and with keys from a KeyStore. The files
+   * are created in the working directory and removed afterwards.
+   *
+   * @param algorithm the algorithm of the generated key
+   * @param milliseconds the time to repeat each operation
+   * @return 0 on success, otherwise -1
+   */
+  static int runKeyStore(OpenSslWrapper::KeyAlgorithm algorithm,
+                         unsigned int milliseconds);
+  /**
+   * Verifies each base64 kernel supported by the CPU against the base64 BIO
+   * of OpenSSL and measures the throughput of encoding and decoding for
+   * several input sizes.
+   *
+   * @param milliseconds the time to repeat each operation
+   * @return 0 on success, otherwise -1
+   */
+  static int runBase64(unsigned int milliseconds);
+  /**
+   * Measures the MB/s of calcSha256File for each HashFileMethod and of
+   * calcSha256TreeFile with one and with the given number of threads, each
+   * with a cold and a warm page cache. The cache of the file is dropped
+   * before each cold operation, which is only supported on Linux.
+   *
+   * @param fileName the file to hash or an empty string to create a file of
+   * HASH_FILE_SIZE bytes in the working directory, which is removed afterwards
+   * @param milliseconds the time to repeat each operation
+   * @param threads the number of tree hash threads, 0 uses one per CPU core
+   * @return 0 on success, otherwise -1
+   */
+  static int runHashFile(const std::string &fileName,
+                         unsigned int milliseconds, unsigned int threads);
+  /**
+   * Verifies each SHA-256 batch kernel supported by the CPU against OpenSSL
+   * and measures the hashes per second of SHA256_BATCH_SIZE random keys of
+   * 16 to 64 bytes. The loop over calcSha256String is the baseline.
+   *
+   * @param milliseconds the time to repeat each operation
+   * @return 0 on success, otherwise -1
+   */
+  static int runSha256Batch(unsigned int milliseconds);
+  /**
+   * Verifies each hex kernel supported by the CPU against the formatting with
+   * std::stringstream and measures the ns per operation of encoding and
+   * decoding for the size of a digest and larger inputs. The stringstream
+   * formatting, which Algorithm used before, is the baseline.
+   *
+   * @param milliseconds the time to repeat each operation
+   * @return 0 on success, otherwise -1
+   */
+  static int runHex(unsigned int milliseconds);
+  /**
+   * Starts a TLS echo server with the given mode and measures the round trip
+   * time of a client which pauses before each message, so the worker is idle
+   * whenever a message arrives. A self signed certificate is created in the
+   * working directory and removed afterwards.
+   *
+   * @param mode how the server serves the connection
+   * @param port the port of the server
+   * @param messages the number of messages to send
+   * @param idleMilliseconds the pause before each message
+   * @return 0 on success, otherwise -1
+   */
+  static int runLatency(Server::Mode mode, unsigned short port,
+                        unsigned int messages, unsigned int idleMilliseconds);
+
+ private:  // helper methods
+  /**
+   * Repeats the operation until the time has elapsed. The operation runs at
+   * least once.
+   *
+   * @return the number of operations per second or -1 if the operation failed
+   */
+  static double measure(const std::function<bool()> &operation,
+                        unsigned int milliseconds);
+  /**
+   * Performs a full handshake between a client and a server object which are
+   * connected by a BIO pair, so the result contains no network latency.
+   */
+  static bool handshake(::SSL_CTX *serverContext, ::SSL_CTX *clientContext);
+  /**
+   * Compares the output of the kernel with the base64 BIO for random data of
+   * each length up to a few hundred bytes and checks that invalid encodings
+   * are rejected.
+   */
+  static bool verifyBase64(Base64::Kernel kernel);
+  /**
+   * Compares the digests of the kernel with EVP_Digest() for random
+   * inputs of each length up to a few hundred bytes and for batches of each
+   * size up to a few times the number of lanes.
+   */
+  static bool verifySha256Batch(Sha256Batch::Kernel kernel);
+  /**
+   * Compares the output of the kernel with std::stringstream for random data
+   * of each length up to a few hundred bytes and checks that uppercase digits
+   * are decoded and other characters are rejected.
+   */
+  static bool verifyHex(Hex::Kernel kernel);
+
+ private:
+  Benchmark() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
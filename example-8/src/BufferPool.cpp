@@ -0,0 +1,245 @@
+#include "BufferPool.h"
+
+#include <algorithm>  // std::min(...)
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * The free buffers shared by all threads.
+ */
+struct SharedFreeLists {
+  std::mutex mutex;
+  std::vector<Buffer *> buffers[BufferPool::SIZE_CLASS_COUNT];
+
+  ~SharedFreeLists() {
+    for (std::vector<Buffer *> &list : this->buffers) {
+      for (Buffer *buffer : list) {
+        delete buffer;
+      }
+    }
+  }
+};
+
+/**
+ * The free buffers of a thread. The lists are reserved on construction, so
+ * pushing a released buffer does not allocate.
+ */
+struct ThreadFreeLists {
+  std::vector<Buffer *> buffers[BufferPool::SIZE_CLASS_COUNT];
+
+  ThreadFreeLists();
+  ~ThreadFreeLists();
+};
+
+static std::atomic<std::size_t> allocationCount{0};
+
+static SharedFreeLists &getSharedFreeLists() {
+  // constructed on first use. Objects with thread storage duration are
+  // destroyed before this object.
+  static SharedFreeLists sharedFreeLists;
+  return sharedFreeLists;
+}
+
+ThreadFreeLists::ThreadFreeLists() {
+  for (std::vector<Buffer *> &list : this->buffers) {
+    list.reserve(BufferPool::THREAD_CACHE_SIZE);
+  }
+}
+
+ThreadFreeLists::~ThreadFreeLists() {
+  // pass the buffers to the other threads
+  SharedFreeLists &shared = getSharedFreeLists();
+  std::unique_lock<std::mutex> lock(shared.mutex);
+  for (unsigned int i = 0; i < BufferPool::SIZE_CLASS_COUNT; i++) {
+    shared.buffers[i].insert(shared.buffers[i].end(), this->buffers[i].begin(),
+                             this->buffers[i].end());
+  }
+}
+
+static thread_local ThreadFreeLists threadFreeLists;
+
+/**
+ * Returns the index of the smallest size class with at least the given size
+ * or SIZE_CLASS_COUNT if the size is larger than MAX_SIZE.
+ */
+static unsigned int getSizeClass(std::size_t size) {
+  std::size_t classSize = BufferPool::MIN_SIZE;
+  for (unsigned int i = 0; i < BufferPool::SIZE_CLASS_COUNT; i++) {
+    if (size <= classSize) {
+      return i;
+    }
+    classSize *= 4;
+  }
+  return BufferPool::SIZE_CLASS_COUNT;
+}
+
+static std::size_t getClassSize(unsigned int sizeClass) {
+  return BufferPool::MIN_SIZE << (2 * sizeClass);
+}
+
+BufferRef BufferPool::acquire(std::size_t size) {
+  unsigned int sizeClass = getSizeClass(size);
+
+  Buffer *buffer = nullptr;
+  if (sizeClass < BufferPool::SIZE_CLASS_COUNT) {
+    std::vector<Buffer *> &cache = threadFreeLists.buffers[sizeClass];
+    if (cache.empty()) {
+      // refill half of the cache from the shared list
+      SharedFreeLists &shared = getSharedFreeLists();
+      std::unique_lock<std::mutex> lock(shared.mutex);
+      std::vector<Buffer *> &list = shared.buffers[sizeClass];
+      while (!list.empty() && cache.size() < BufferPool::THREAD_CACHE_SIZE / 2) {
+        cache.push_back(list.back());
+        list.pop_back();
+      }
+    }
+    if (!cache.empty()) {
+      buffer = cache.back();
+      cache.pop_back();
+    }
+  }
+
+  if (buffer == nullptr) {
+    buffer = new Buffer();
+    buffer->sizeClass = sizeClass;
+    buffer->capacity = sizeClass < BufferPool::SIZE_CLASS_COUNT
+                           ? getClassSize(sizeClass)
+                           : size;
+    buffer->data = std::unique_ptr<char[]>(new char[buffer->capacity]);
+    allocationCount++;
+  }
+
+  buffer->references = 1;
+  return BufferRef(buffer);
+}
+
+void BufferPool::release(Buffer *buffer) {
+  if (buffer->sizeClass >= BufferPool::SIZE_CLASS_COUNT) {
+    delete buffer;
+    return;
+  }
+
+  std::vector<Buffer *> &cache = threadFreeLists.buffers[buffer->sizeClass];
+  if (cache.size() >= BufferPool::THREAD_CACHE_SIZE) {
+    // move half of the cache to the shared list
+    SharedFreeLists &shared = getSharedFreeLists();
+    std::unique_lock<std::mutex> lock(shared.mutex);
+    std::vector<Buffer *> &list = shared.buffers[buffer->sizeClass];
+    while (cache.size() > BufferPool::THREAD_CACHE_SIZE / 2) {
+      list.push_back(cache.back());
+      cache.pop_back();
+    }
+  }
+  cache.push_back(buffer);
+}
+
+std::size_t BufferPool::getNextReadSize(std::size_t capacity,
+                                        std::size_t received) {
+  if (received >= capacity) {
+    return capacity * 4 < BufferPool::MAX_SIZE ? capacity * 4
+                                               : BufferPool::MAX_SIZE;
+  }
+  return getClassSize(
+      std::min(getSizeClass(received), BufferPool::SIZE_CLASS_COUNT - 1));
+}
+
+std::size_t BufferPool::getAllocationCount() { return allocationCount; }
+
+BufferRef::BufferRef(Buffer *buffer) : buffer{buffer} {}
+
+BufferRef::BufferRef(BufferRef &&other) noexcept : buffer{other.buffer} {
+  other.buffer = nullptr;
+}
+
+BufferRef &BufferRef::operator=(BufferRef &&other) noexcept {
+  if (this != &other) {
+    this->reset();
+    this->buffer = other.buffer;
+    other.buffer = nullptr;
+  }
+  return *this;
+}
+
+BufferRef::BufferRef(const BufferRef &other) : buffer{other.buffer} {
+  if (this->buffer != nullptr) {
+    this->buffer->references.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+BufferRef &BufferRef::operator=(const BufferRef &other) {
+  if (this != &other) {
+    if (other.buffer != nullptr) {
+      other.buffer->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    this->reset();
+    this->buffer = other.buffer;
+  }
+  return *this;
+}
+
+BufferRef::~BufferRef() { this->reset(); }
+
+BufferRef::operator bool() const { return this->buffer != nullptr; }
+
+char *BufferRef::data() const {
+  return this->buffer != nullptr ? this->buffer->data.get() : nullptr;
+}
+
+std::size_t BufferRef::capacity() const {
+  return this->buffer != nullptr ? this->buffer->capacity : 0;
+}
+
+void BufferRef::reset() {
+  if (this->buffer != nullptr) {
+    // the last reference returns the buffer to the pool
+    if (this->buffer->references.fetch_sub(1, std::memory_order_acq_rel) ==
+        1) {
+      BufferPool::release(this->buffer);
+    }
+    this->buffer = nullptr;
+  }
+}
+
+BufferView::BufferView(BufferRef buffer, std::size_t offset,
+                       std::size_t length)
+    : buffer{std::move(buffer)}, offset{offset}, length{length} {}
+
+const char *BufferView::data() const {
+  return this->buffer ? this->buffer.data() + this->offset : nullptr;
+}
+
+std::size_t BufferView::size() const { return this->length; }
+
+bool BufferView::empty() const { return this->length == 0; }
+
+BufferView BufferView::subview(std::size_t offset, std::size_t length) const {
+  if (offset > this->length) {
+    offset = this->length;
+  }
+  if (length > this->length - offset) {
+    length = this->length - offset;
+  }
+  return BufferView(this->buffer, this->offset + offset, length);
+}
+
+std::string BufferView::toString() const {
+  if (this->length == 0) {
+    return std::string();
+  }
+  return std::string(this->data(), this->length);
+}
+
+void BufferView::reset() {
+  this->buffer.reset();
+  this->offset = 0;
+  this->length = 0;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A pooled memory block. Owned by the BufferPool and referenced by BufferRef.
+ */
+struct Buffer {
+  std::atomic<unsigned int> references;
+  /**
+   * The index of the size class or BufferPool::SIZE_CLASS_COUNT if the buffer
+   * is larger than the largest size class and therefore not pooled.
+   */
+  unsigned int sizeClass;
+  std::size_t capacity;
+  std::unique_ptr<char[]> data;
+};
+
+/**
+ * A counted reference to a pooled buffer. Copies share the buffer. The buffer
+ * returns to the pool if the last reference is released.
+ */
+class BufferRef {
+ public:  // construction/destruction/operators
+  /**
+   * Creates an empty reference.
+   */
+  BufferRef() = default;
+  /**
+   * Move constructor
+   */
+  BufferRef(BufferRef &&other) noexcept;
+  /**
+   * Move assignment operator
+   */
+  BufferRef &operator=(BufferRef &&other) noexcept;
+  /**
+   * Copy constructor. Adds a reference.
+   */
+  BufferRef(const BufferRef &other);
+  /**
+   * Copy assignment operator. Adds a reference.
+   */
+  BufferRef &operator=(const BufferRef &other);
+  /**
+   * Destructor. Releases the reference.
+   */
+  virtual ~BufferRef();
+  /**
+   * Returns true if the reference points to a buffer.
+   */
+  explicit operator bool() const;
+
+ public:  // methods
+  char *data() const;
+  std::size_t capacity() const;
+  /**
+   * Releases the reference. The reference is empty afterwards.
+   */
+  void reset();
+
+ private:  // construction
+  friend class BufferPool;
+  explicit BufferRef(Buffer *buffer);
+
+ private:  // fields
+  Buffer *buffer = nullptr;
+};
+
+/**
+ * A range of bytes in a pooled buffer. The view keeps the buffer alive, so it
+ * can be passed to the write path without copying the bytes.
+ */
+class BufferView {
+ public:  // construction
+  /**
+   * Creates an empty view.
+   */
+  BufferView() = default;
+  BufferView(BufferRef buffer, std::size_t offset, std::size_t length);
+
+ public:  // methods
+  const char *data() const;
+  std::size_t size() const;
+  bool empty() const;
+  /**
+   * Returns a view of a part of this view which shares the buffer.
+   */
+  BufferView subview(std::size_t offset, std::size_t length) const;
+  /**
+   * Copies the bytes into a string.
+   */
+  std::string toString() const;
+  /**
+   * Releases the buffer. The view is empty afterwards.
+   */
+  void reset();
+
+ private:  // fields
+  BufferRef buffer;
+  std::size_t offset = 0;
+  std::size_t length = 0;
+};
+
+/**
+ * A pool of receive buffers with size classes of 4 KiB, 16 KiB and 64 KiB.
+ *
+ * Released buffers are kept in a cache of the releasing thread and are
+ * returned to a shared list if the cache is full or the thread exits. Once the
+ * pool is warm, acquire() and the release of the last reference do not
+ * allocate.
+ */
+class BufferPool {
+ public:  // const
+  // number of size classes
+  static const unsigned int SIZE_CLASS_COUNT = 3;
+  // size of the smallest size class (4KiByte). Each class is 4 times larger.
+  static const std::size_t MIN_SIZE = 4096;
+  // size of the largest size class (64KiByte)
+  static const std::size_t MAX_SIZE = 65536;
+  // number of buffers per size class in the cache of each thread
+  static const unsigned int THREAD_CACHE_SIZE = 16;
+
+ public:  // methods
+  /**
+   * Returns a buffer of the smallest size class with at least the given size.
+   * Buffers larger than MAX_SIZE are allocated and freed without pooling.
+   */
+  static BufferRef acquire(std::size_t size);
+  /**
+   * Returns the size of the next receive buffer of a connection. A read
+   * which filled its buffer selects the next larger size class, because more
+   * data is likely waiting. Otherwise the smallest class which holds the last
+   * read is selected, so connections with small messages use small buffers.
+   *
+   * @param capacity the capacity of the buffer of the last read
+   * @param received the number of bytes of the last read
+   */
+  static std::size_t getNextReadSize(std::size_t capacity,
+                                     std::size_t received);
+  /**
+   * Returns the number of buffers which have been allocated from the heap.
+   * Stays constant in the steady state.
+   */
+  static std::size_t getAllocationCount();
+
+ private:  // helper methods
+  friend class BufferRef;
+  /**
+   * Called if the last reference to the buffer has been released.
+   */
+  static void release(Buffer *buffer);
+
+ private:
+  BufferPool() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
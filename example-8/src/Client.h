@@ -4,6 +4,10 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Frame.h"
 
 #ifndef _WIN32
 #include "OpenSslWrapper.h"
@@ -62,6 +66,22 @@ class Client {
    * occured.
    */
   int tryReadString(std::string &message);
+  /**
+   * @brief Reads the available data into a pooled buffer without copying.
+   *
+   * @param view The read data if return value is > 0. Empty if the server
+   * closed the connection.
+   * @return the size of the read data, if 0 there was no data, if -1 an error
+   * occured.
+   */
+  int tryRead(BufferView &view);
+  /**
+   * @brief Blocks until data is available or the timeout expires.
+   *
+   * @param timeoutMicroseconds the maximum time to wait
+   * @return true if data is available. The next read does not block.
+   */
+  bool waitForData(long timeoutMicroseconds);
   /**
    * @brief Reads a string from the stream. Blocks until data is available or an
    * error occured.
@@ -78,6 +98,32 @@ class Client {
    * @return true if data has been written. false if an error occured.
    */
   bool write(const byte data[], size_t length);
+  /**
+   * @brief Reads the next length-prefixed frame. Reads until a frame is
+   * complete or the read would block, because a frame may span several TLS
+   * records.
+   *
+   * @param frame The payload of the frame if return value is 1
+   * @return 1 if a frame has been read, if 0 there is no complete frame yet,
+   * if -1 an error occured, the connection has been closed or the server sent
+   * an invalid frame.
+   */
+  int tryReadFrame(BufferView &frame);
+  /**
+   * @brief Reads the next length-prefixed frame. Blocks until a complete frame
+   * is available or an error occured.
+   *
+   * @return true if a frame has been read. false if an error occured.
+   */
+  bool readFrame(BufferView &frame);
+  /**
+   * @brief Writes the data as one length-prefixed frame.
+   */
+  bool writeFrame(const byte data[], size_t length);
+  /**
+   * @brief Writes the payloads as consecutive frames with a single write.
+   */
+  bool writeFrames(const std::vector<BufferView> &payloads);
 
  private:
   bool closeSocket();
@@ -88,9 +134,20 @@ class Client {
   bool enabled;
   std::string serverAddress;
   unsigned short port;
+  /**
+   * The size of the next receive buffer (see BufferPool::getNextReadSize).
+   */
+  std::size_t readSize = BufferPool::MIN_SIZE;
+  FrameParser frameParser;
 
  public:  // TLS methods
+  /**
+   * @brief Returns true if the last open() resumed a TLS session of a previous
+   * connection to the same server instead of a full handshake.
+   */
+  bool isSessionReused();
   int tryReadStringTls(std::string &message);
+  int tryReadTls(BufferView &view);
   // blocks until data is available
   bool readStringTls(std::string &message);
   bool writeTls(const byte data[], size_t length);
@@ -98,6 +155,7 @@ class Client {
  private:  // TLS fields
   std::string keyFileName;
   std::string certFileName;
+  bool sessionReused;
 #ifndef _WIN32
   OpenSslWrapper::TlsContextPtr tlsContextPtr;
   OpenSslWrapper::TlsPtr tlsPtr;
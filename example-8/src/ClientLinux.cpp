@@ -6,6 +6,7 @@
 #include <fcntl.h>       // ::fcntl(...)
 #include <netdb.h>       // ::gethostbyname(...) ; hostent
 #include <netinet/in.h>  // sockaddr_in
+#include <poll.h>        // ::poll(...) ; pollfd ; POLLIN
 #include <openssl/ssl.h>
 #include <sys/socket.h>  // ::socket(...) ; SOCK_STREAM ; AF_INET ; connect(...)
 #include <unistd.h>      // ::close(int), ::read(int, void*, size_t), write(...)
@@ -13,15 +14,20 @@
 #include <cerrno>    // errno
 #include <cstring>   // strerror_r(...) , std::memcpy(...)
 #include <iostream>  // std::cout(...), std::cerr(...)
+#include <utility>   // std::move
 
 #include "Client.h"
+#include "ClientSessionCache.h"
 
 namespace ggolbik {
 namespace cpp {
 namespace tls {
 
 Client::Client(std::string serverAddress, unsigned short port)
-    : enabled{false}, serverAddress{serverAddress}, port{port} {}
+    : enabled{false},
+      serverAddress{serverAddress},
+      port{port},
+      sessionReused{false} {}
 
 Client::~Client() { this->close(); }
 
@@ -329,6 +335,9 @@ bool Client::open() {
   }
 
   this->enabled = true;
+  this->sessionReused = false;
+  // drop partial frames of a previous connection
+  this->frameParser.reset();
 
   // create TLS context
   this->tlsContextPtr =
@@ -338,6 +347,8 @@ bool Client::open() {
     this->enabled = false;
     return false;
   }
+  // store the sessions of the server to resume them on the next open()
+  ClientSessionCache::attach(this->tlsContextPtr.get());
 
   // create a socket address
   sockaddr_in address;
@@ -378,9 +389,11 @@ bool Client::open() {
     return false;
   }
 
-  // check TLS
-  this->tlsPtr = OpenSslWrapper::TlsPtr(
-      OpenSslWrapper::connectTls(this->tlsContextPtr.get(), clientSocket));
+  // check TLS. Offer the session of a previous connection to the server.
+  std::string sessionKey = ClientSessionCache::getKey(this->clientSocket);
+  OpenSslWrapper::TlsSessionPtr session = ClientSessionCache::get(sessionKey);
+  this->tlsPtr = OpenSslWrapper::TlsPtr(OpenSslWrapper::connectTls(
+      this->tlsContextPtr.get(), this->clientSocket, session.get()));
   if (!this->tlsPtr) {
     std::cerr << "Failed to establish TLS connection." << std::endl;
     printError();
@@ -390,11 +403,18 @@ bool Client::open() {
   }
 
   // connection established
+  this->sessionReused = ::SSL_session_reused(this->tlsPtr.get()) == 1;
   OpenSslWrapper::displayCerts(this->tlsPtr.get());
 
   return true;
 }
 
+bool Client::isSessionReused() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  return this->sessionReused;
+}
+
 void Client::close() {
   // lock mutex to set listen socket appropriately
   std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
@@ -426,6 +446,36 @@ bool Client::closeSocket() {
   return true;
 }
 
+/**
+ * Blocks until the socket is readable or the timeout expires. The timeout
+ * allows the caller to check whether the client has been closed.
+ *
+ * The method call
+ *   int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+ * is defined in header <poll.h>
+ */
+static void waitReadable(int socket) {
+  pollfd fd = {};
+  fd.fd = socket;
+  fd.events = POLLIN;
+  // milliseconds
+  int timeout = 100;
+  ::poll(&fd, 1, timeout);
+}
+
+/**
+ * Blocks until the socket is writable or the timeout expires. The timeout
+ * allows the caller to check whether the client has been closed.
+ */
+static void waitWritable(int socket) {
+  pollfd fd = {};
+  fd.fd = socket;
+  fd.events = POLLOUT;
+  // milliseconds
+  int timeout = 100;
+  ::poll(&fd, 1, timeout);
+}
+
 bool Client::write(const byte data[], size_t length) {
   if (this->tlsPtr) {
     return this->writeTls(data, length);
@@ -445,12 +495,10 @@ bool Client::write(const byte data[], size_t length) {
                    remaining);
 
       if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-        std::cout << "Worker read AGAIN" << std::endl;
         // The file descriptor fd refers to a file other than a socket and has
-        // been marked nonblocking (O_NONBLOCK), and the read would block.
-        if (this->enabled) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+        // been marked nonblocking (O_NONBLOCK), and the write would block.
+        // Wait until the peer has taken data from the send buffer.
+        waitWritable(this->clientSocket);
         continue;
       } else if (rc < 0) {
         // an error occurred
@@ -495,8 +543,12 @@ bool Client::writeTls(const byte data[], size_t length) {
         // failed to read data
         int error = ::SSL_get_error(this->tlsPtr.get(), rc);
         if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
-          if (this->enabled) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+          // TLS might have to read during a write. The write is repeated with
+          // the same arguments once the socket is ready.
+          if (error == SSL_ERROR_WANT_READ) {
+            waitReadable(this->clientSocket);
+          } else {
+            waitWritable(this->clientSocket);
           }
           continue;
         } else {
@@ -520,6 +572,32 @@ bool Client::writeTls(const byte data[], size_t length) {
   return false;
 }
 
+/**
+ * ppoll() is like poll() but takes the timeout as timespec, so the timeout is
+ * not rounded to milliseconds.
+ *
+ * The method call
+ *   int ppoll(struct pollfd *fds, nfds_t nfds, const struct timespec
+ * *tmo_p, const sigset_t *sigmask);
+ * is defined in header <poll.h>
+ */
+bool Client::waitForData(long timeoutMicroseconds) {
+  // TLS might have decrypted more data than the last read returned
+  if (this->tlsPtr && ::SSL_pending(this->tlsPtr.get()) > 0) {
+    return true;
+  }
+  pollfd fd = {};
+  fd.fd = this->clientSocket;
+  fd.events = POLLIN;
+  timespec timeout = {};
+  if (timeoutMicroseconds > 0) {
+    timeout.tv_sec = timeoutMicroseconds / 1000000;
+    timeout.tv_nsec = (timeoutMicroseconds % 1000000) * 1000;
+  }
+  // POLLHUP and POLLERR are reported by the next read
+  return ::ppoll(&fd, 1, &timeout, nullptr) > 0;
+}
+
 bool Client::readString(std::string &message) {
   if (this->tlsPtr) {
     return this->readStringTls(message);
@@ -530,23 +608,32 @@ bool Client::readString(std::string &message) {
     if (result > 0) {
       return true;
     } else if (result == 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      waitReadable(this->clientSocket);
     }
   } while (this->enabled && result == 0);
   return false;
 }
 
 int Client::tryReadString(std::string &message) {
+  BufferView view;
+  int rc = this->tryRead(view);
+  message = view.toString();
+  return rc;
+}
+
+int Client::tryRead(BufferView &view) {
   if (this->tlsPtr) {
-    return this->tryReadStringTls(message);
+    return this->tryReadTls(view);
   }
-  byte recvbuf[Client::MAX_BUFFER_SIZE];
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte *recvbuf = buffer.data();
 
-  message = "";
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::read(this->clientSocket, recvbuf, Client::MAX_BUFFER_SIZE);
+    rc = ::read(this->clientSocket, recvbuf, buffer.capacity());
     if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
       return 0;
     } else if (rc < 0) {
@@ -559,7 +646,9 @@ int Client::tryReadString(std::string &message) {
       return 1;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
       return rc;
     }
   }
@@ -574,23 +663,33 @@ bool Client::readStringTls(std::string &message) {
     if (result > 0) {
       return true;
     } else if (result == 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      waitReadable(this->clientSocket);
     }
   } while (this->enabled && result == 0);
   return false;
 }
 
 int Client::tryReadStringTls(std::string &message) {
-  byte recvbuf[Client::MAX_BUFFER_SIZE];
+  BufferView view;
+  int rc = this->tryReadTls(view);
+  message = view.toString();
+  return rc;
+}
+
+int Client::tryReadTls(BufferView &view) {
+  BufferRef buffer = BufferPool::acquire(this->readSize);
 
-  message = "";
+  view.reset();
 
   int rc;
   if (this->enabled) {
-    rc = ::SSL_read(this->tlsPtr.get(), recvbuf, Client::MAX_BUFFER_SIZE);
+    rc = ::SSL_read(this->tlsPtr.get(), buffer.data(),
+                    static_cast<int>(buffer.capacity()));
     if (rc > 0) {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
       return rc;
     }
     int error = ::SSL_get_error(this->tlsPtr.get(), rc);
@@ -605,6 +704,52 @@ int Client::tryReadStringTls(std::string &message) {
   return -1;
 }
 
+int Client::tryReadFrame(BufferView &frame) {
+  // SSL_read returns at most one record. Once the read would block, no
+  // decrypted data is buffered and the caller may wait for the socket.
+  while (!this->frameParser.next(frame)) {
+    BufferView data;
+    int rc = this->tryRead(data);
+    if (rc <= 0) {
+      return rc;
+    } else if (data.empty()) {
+      // the server closed the connection
+      return -1;
+    }
+    if (!this->frameParser.feed(data)) {
+      std::cerr << "Received invalid frame" << std::endl;
+      return -1;
+    }
+  }
+  return 1;
+}
+
+bool Client::readFrame(BufferView &frame) {
+  int result = -1;
+  do {
+    result = this->tryReadFrame(frame);
+    if (result > 0) {
+      return true;
+    } else if (result == 0) {
+      waitReadable(this->clientSocket);
+    }
+  } while (this->enabled && result == 0);
+  return false;
+}
+
+bool Client::writeFrame(const byte data[], size_t length) {
+  BufferView frame = Frame::encode(data, length);
+  return this->write(frame.data(), frame.size());
+}
+
+bool Client::writeFrames(const std::vector<BufferView> &payloads) {
+  if (payloads.empty()) {
+    return true;
+  }
+  BufferView frames = Frame::encode(payloads);
+  return this->write(frames.data(), frames.size());
+}
+
 }  // namespace tls
 }  // namespace cpp
 }  // namespace ggolbik
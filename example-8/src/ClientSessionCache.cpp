@@ -0,0 +1,127 @@
+#include "ClientSessionCache.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>   // ::inet_ntop(...)
+#include <netinet/in.h>  // sockaddr_in
+#include <sys/socket.h>  // ::getpeername(...)
+#endif
+
+#include <algorithm>  // std::find
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * The sessions by server and the servers in the order of their last update.
+ */
+struct Sessions {
+  std::mutex mutex;
+  std::unordered_map<std::string, OpenSslWrapper::TlsSessionPtr> sessions;
+  std::deque<std::string> order;
+};
+
+static Sessions &getSessions() {
+  // initialized on first use and thread safe since C++11
+  static Sessions sessions;
+  return sessions;
+}
+
+/**
+ * SSL_SESS_CACHE_NO_INTERNAL_STORE disables the internal cache of the
+ * context, which is freed after each connection anyway. OpenSSL passes each
+ * new session to the callback instead.
+ *
+ * The method call
+ *   void SSL_CTX_sess_set_new_cb(SSL_CTX *ctx, int (*new_session_cb)(SSL *,
+ * SSL_SESSION *));
+ * is defined in header <openssl/ssl.h>
+ */
+void ClientSessionCache::attach(::SSL_CTX *ctx) {
+  ::SSL_CTX_set_session_cache_mode(
+      ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  ::SSL_CTX_sess_set_new_cb(ctx, &ClientSessionCache::onNewSession);
+}
+
+std::string ClientSessionCache::getKey(int socket) {
+#ifdef _WIN32
+  (void)socket;
+  return "";
+#else
+  sockaddr_in address = {};
+  socklen_t length = sizeof(address);
+  if (::getpeername(socket, reinterpret_cast<sockaddr *>(&address), &length) !=
+          0 ||
+      address.sin_family != AF_INET) {
+    return "";
+  }
+  char host[INET_ADDRSTRLEN];
+  if (::inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host)) == nullptr) {
+    return "";
+  }
+  return std::string(host) + ":" + std::to_string(ntohs(address.sin_port));
+#endif
+}
+
+/**
+ * OpenSSL marks a TLS 1.3 session as not resumable once it has been offered,
+ * because a ticket should not be used twice (RFC 8446, appendix C.4).
+ */
+OpenSslWrapper::TlsSessionPtr ClientSessionCache::get(const std::string &key) {
+  Sessions &cache = getSessions();
+  std::unique_lock<std::mutex> lock(cache.mutex);
+  auto it = cache.sessions.find(key);
+  if (it == cache.sessions.end()) {
+    return OpenSslWrapper::TlsSessionPtr();
+  }
+  if (::SSL_SESSION_get_protocol_version(it->second.get()) >=
+      TLS1_3_VERSION) {
+    OpenSslWrapper::TlsSessionPtr session = std::move(it->second);
+    cache.sessions.erase(it);
+    cache.order.erase(std::find(cache.order.begin(), cache.order.end(), key));
+    return session;
+  }
+  // the connection holds its own reference
+  ::SSL_SESSION_up_ref(it->second.get());
+  return OpenSslWrapper::TlsSessionPtr(it->second.get());
+}
+
+/**
+ * Returns 1 if the cache keeps the reference of the session, otherwise 0 and
+ * OpenSSL frees the session.
+ */
+int ClientSessionCache::onNewSession(::SSL *ssl, ::SSL_SESSION *session) {
+  if (::SSL_SESSION_is_resumable(session) != 1) {
+    return 0;
+  }
+  std::string key = ClientSessionCache::getKey(::SSL_get_fd(ssl));
+  if (key.empty()) {
+    return 0;
+  }
+
+  Sessions &cache = getSessions();
+  std::unique_lock<std::mutex> lock(cache.mutex);
+  auto it = cache.sessions.find(key);
+  if (it != cache.sessions.end()) {
+    // keep only the latest session of the server
+    it->second.reset(session);
+    cache.order.erase(std::find(cache.order.begin(), cache.order.end(), key));
+  } else {
+    cache.sessions.emplace(key, OpenSslWrapper::TlsSessionPtr(session));
+  }
+  cache.order.push_back(key);
+
+  // remove the server which has not been updated for the longest time
+  if (cache.order.size() > ClientSessionCache::MAX_SIZE) {
+    cache.sessions.erase(cache.order.front());
+    cache.order.pop_front();
+  }
+  return 1;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <cstddef>
+#include <string>
+
+#include "OpenSslWrapper.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A process wide cache of the TLS sessions the clients received from the
+ * servers. A client which connects again to the same server resumes the
+ * session and skips the key exchange and the certificate verification of a
+ * full handshake.
+ *
+ * The sessions are stored by the address of the server. The cache keeps the
+ * latest session of each server and removes the oldest server if it is full.
+ * TLS 1.3 sessions are used only once. The server sends a new ticket for the
+ * resumed connection.
+ */
+class ClientSessionCache {
+ public:  // const
+  // max number of servers whose session is cached
+  static const std::size_t MAX_SIZE = 64;
+
+ public:
+  /**
+   * Enables the session cache of the client context. New sessions, e.g. TLS
+   * 1.3 tickets received after the handshake, are stored in this cache.
+   */
+  static void attach(::SSL_CTX *ctx);
+  /**
+   * Returns the key of the server the connected socket belongs to, e.g.
+   * "127.0.0.1:5044". Returns an empty string if the peer is unknown.
+   */
+  static std::string getKey(int socket);
+  /**
+   * Returns the latest session of the server or an empty pointer. A TLS 1.3
+   * session is removed from the cache.
+   */
+  static OpenSslWrapper::TlsSessionPtr get(const std::string &key);
+
+ private:
+  /**
+   * Called by OpenSSL for each new session of a client connection.
+   */
+  static int onNewSession(::SSL *ssl, ::SSL_SESSION *session);
+
+ private:
+  ClientSessionCache() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -11,7 +11,7 @@ namespace cpp {
 namespace tls {
 
 Client::Client(std::string serverAddress, unsigned short port)
-    : serverAddress{serverAddress}, port{port} {}
+    : serverAddress{serverAddress}, port{port}, sessionReused{false} {}
 
 Client::~Client() { this->close(); }
 
@@ -24,6 +24,8 @@ void Client::close() {}
 
 bool Client::closeSocket() { return false; }
 
+bool Client::isSessionReused() { return false; }
+
 /**
  * ssize_t write(int fd, const void *buf, size_t count);
  */
@@ -33,8 +35,24 @@ bool Client::readString(std::string &message) { return false; }
 
 int Client::tryReadString(std::string &message) { return -1; }
 
+int Client::tryRead(BufferView &view) { return -1; }
+
+bool Client::waitForData(long timeoutMicroseconds) { return false; }
+
+int Client::tryReadFrame(BufferView &frame) { return -1; }
+
+bool Client::readFrame(BufferView &frame) { return false; }
+
+bool Client::writeFrame(const byte data[], size_t length) { return false; }
+
+bool Client::writeFrames(const std::vector<BufferView> &payloads) {
+  return false;
+}
+
 int Client::tryReadStringTls(std::string &message) { return -1; }
 
+int Client::tryReadTls(BufferView &view) { return -1; }
+
 bool Client::readStringTls(std::string &message) { return false; }
 
 bool Client::writeTls(const byte data[], size_t length) { return false; }
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+class Worker;
+
+/**
+ * An epoll based event loop which serves many connections with a single
+ * thread. The loop waits for readiness of the sockets of its workers and calls
+ * Worker::onReadable() for each socket with pending data.
+ *
+ * A socket is watched for writability only while its worker has pending
+ * responses, and it is not watched for readability while the worker paused
+ * reading because the peer does not take the responses.
+ */
+class EventLoop {
+ private:  // type definitions
+  struct Connection {
+    std::shared_ptr<Worker> worker;
+    /**
+     * The events for which the socket is registered at the epoll instance.
+     */
+    std::uint32_t events;
+  };
+
+ private:  // const
+  // max number of events returned by a single epoll_wait call
+  static const unsigned int MAX_EVENTS = 64;
+
+ public:  // construction/destruction/operators
+  /**
+   * Default constructor
+   */
+  EventLoop();
+  /**
+   * Move constructor
+   */
+  EventLoop(EventLoop &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  EventLoop &operator=(EventLoop &&) = delete;
+  /**
+   * Copy constructor
+   */
+  EventLoop(const EventLoop &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  EventLoop &operator=(const EventLoop &) = delete;
+  /**
+   * Destructor
+   */
+  virtual ~EventLoop();
+
+ public:  // methods
+  /**
+   * Creates the epoll instance and starts the loop thread. Returns false if
+   * the loop could not be started or is already running.
+   */
+  bool start();
+  /**
+   * Returns true if the loop is enabled or running
+   */
+  bool isRunning();
+  /**
+   * Stops the loop thread and closes all connections owned by the loop.
+   */
+  void stop();
+  /**
+   * Passes the worker to the loop. The worker must have been activated with
+   * Worker::activate(). The loop owns the worker until the connection closes.
+   *
+   * @return false if the loop is not running.
+   */
+  bool add(std::shared_ptr<Worker> worker);
+
+ private:  // helper methods
+  /**
+   * The method executed by the loop thread.
+   */
+  void run();
+  /**
+   * Registers the workers passed with add() at the epoll instance.
+   */
+  void registerPending();
+  /**
+   * Registers the socket for the events the worker waits for, if they have
+   * changed.
+   *
+   * @return false if the registration failed.
+   */
+  bool updateEvents(int socket, Connection &connection);
+  /**
+   * Removes the worker from the epoll instance and closes the connection.
+   */
+  void removeWorker(int socket);
+  /**
+   * Interrupts a blocking epoll_wait call.
+   */
+  bool wakeup();
+
+ private:  // fields
+  std::mutex mutexPublicMethods;
+  std::mutex mutexPending;
+  /**
+   * Workers passed with add() which are not yet registered by the loop thread.
+   */
+  std::vector<std::shared_ptr<Worker>> pending;
+  /**
+   * The workers served by this loop by socket. Only accessed by the loop
+   * thread.
+   */
+  std::unordered_map<int, Connection> workers;
+  /**
+   * The epoll instance.
+   */
+  int epollFd;
+  /**
+   * An eventfd to wake up the loop thread.
+   */
+  int wakeupFd;
+  std::atomic_bool enabled;
+  std::atomic_bool running;
+  std::thread loopThread;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,311 @@
+#ifdef __linux__
+// linux code goes here
+
+#include <sys/epoll.h>   // ::epoll_create1(...) ; ::epoll_ctl(...) ; ::epoll_wait(...)
+#include <sys/eventfd.h>  // ::eventfd(...)
+#include <unistd.h>       // ::close(int), ::read(...), ::write(...)
+
+#include <cerrno>    // errno
+#include <cstdint>   // uint64_t
+#include <cstring>   // ::strerror_r(...)
+#include <iostream>  // std::cout(...) ; std::cerr(...)
+
+#include "EventLoop.h"
+#include "Worker.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+EventLoop::EventLoop()
+    : epollFd{-1}, wakeupFd{-1}, enabled{false}, running{false} {}
+
+EventLoop::~EventLoop() { this->stop(); }
+
+/**
+ * errno is thread safe. On Linux, the global errno variable is thread-specific.
+ * POSIX requires that errno be threadsafe. If the value of errno should be
+ * preserved across a library call, it must be saved.
+ *
+ * strerror_r is thread safe.
+ *
+ * errno is defined in <cerrno> and is an integer value.
+ *
+ * The method call
+ *   char *::strerror_r(int errnum, char *buf, size_t buflen);
+ * is defined in <cstring>
+ */
+static void printError() {
+  size_t length = 1024;
+  char buffer[length];
+  std::cerr << "(" << errno << ") " << ::strerror_r(errno, buffer, length)
+            << std::endl;
+}
+
+/**
+ * epoll monitors multiple file descriptors to see if I/O is possible on any of
+ * them. In contrast to select() and poll() the set of watched descriptors is
+ * kept in the kernel, so the cost of a wait does not grow with the number of
+ * connections.
+ *
+ * The method calls
+ *   int epoll_create1(int flags);
+ *   int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+ * are defined in header <sys/epoll.h>
+ *
+ * An eventfd is a counter in the kernel which can be polled like a socket.
+ * Writing to it makes it readable, which is used to interrupt epoll_wait().
+ *
+ * The method call
+ *   int eventfd(unsigned int initval, int flags);
+ * is defined in header <sys/eventfd.h>
+ */
+bool EventLoop::start() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  if (this->enabled) {
+    std::cerr << "Event loop is already running." << std::endl;
+    return false;
+  }
+
+  this->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (this->epollFd == -1) {
+    std::cerr << "Failed to create epoll instance." << std::endl;
+    printError();
+    return false;
+  }
+
+  this->wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->wakeupFd == -1) {
+    std::cerr << "Failed to create eventfd." << std::endl;
+    printError();
+    ::close(this->epollFd);
+    this->epollFd = -1;
+    return false;
+  }
+
+  // the data field is used to identify the socket. -1 identifies the eventfd.
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = -1;
+  if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->wakeupFd, &event) != 0) {
+    std::cerr << "Failed to register eventfd." << std::endl;
+    printError();
+    ::close(this->wakeupFd);
+    ::close(this->epollFd);
+    this->wakeupFd = -1;
+    this->epollFd = -1;
+    return false;
+  }
+
+  this->enabled = true;
+  this->running = true;
+
+  this->loopThread = std::thread(&EventLoop::run, this);
+
+  std::cout << "Event loop thread ID: " << this->loopThread.get_id()
+            << std::endl;
+
+  return true;
+}
+
+bool EventLoop::isRunning() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  // return whether loop has been stopped or is still running
+  return this->enabled || this->running;
+}
+
+void EventLoop::stop() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  if (this->enabled) {
+    this->enabled = false;
+
+    if (!this->wakeup()) {
+      printError();
+    }
+
+    std::cout << "Join event loop thread" << std::endl;
+
+    if (this->loopThread.joinable()) {
+      this->loopThread.join();
+    }
+
+    // workers which have been added after the loop thread stopped
+    std::unique_lock<std::mutex> lockPending(this->mutexPending);
+    for (std::shared_ptr<Worker> worker : this->pending) {
+      worker->close();
+    }
+    this->pending.clear();
+
+    ::close(this->wakeupFd);
+    ::close(this->epollFd);
+    this->wakeupFd = -1;
+    this->epollFd = -1;
+
+    this->running = false;
+  }
+}
+
+bool EventLoop::add(std::shared_ptr<Worker> worker) {
+  if (!worker || !this->enabled) {
+    return false;
+  }
+  {
+    std::unique_lock<std::mutex> lock(this->mutexPending);
+    this->pending.push_back(worker);
+  }
+  // the loop thread registers the worker, so the workers map needs no lock.
+  return this->wakeup();
+}
+
+bool EventLoop::wakeup() {
+  uint64_t value = 1;
+  // EAGAIN means the counter is already set and the loop will wake up anyway.
+  return ::write(this->wakeupFd, &value, sizeof(value)) == sizeof(value) ||
+         errno == EAGAIN;
+}
+
+void EventLoop::registerPending() {
+  std::vector<std::shared_ptr<Worker>> workers;
+  {
+    std::unique_lock<std::mutex> lock(this->mutexPending);
+    workers.swap(this->pending);
+  }
+
+  for (std::shared_ptr<Worker> worker : workers) {
+    int socket = worker->getSocket();
+
+    // level-triggered: the socket is reported as long as data is pending.
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = socket;
+    if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, socket, &event) != 0) {
+      std::cerr << "Failed to register socket." << std::endl;
+      printError();
+      worker->close();
+      continue;
+    }
+    Connection &connection = this->workers[socket];
+    connection.worker = worker;
+    connection.events = event.events;
+
+    // the client might have sent data before the socket has been registered.
+    // level-triggered epoll reports it, but TLS could have buffered a record
+    // already during the handshake.
+    if (!worker->onReadable() || !this->updateEvents(socket, connection)) {
+      this->removeWorker(socket);
+    }
+  }
+}
+
+bool EventLoop::updateEvents(int socket, Connection &connection) {
+  std::uint32_t events = 0;
+  if (!connection.worker->isReadPaused()) {
+    // EPOLLRDHUP would be reported continuously while reading is paused
+    events |= EPOLLIN | EPOLLRDHUP;
+  }
+  if (connection.worker->isWritePending()) {
+    events |= EPOLLOUT;
+  }
+  if (events == connection.events) {
+    return true;
+  }
+
+  epoll_event event = {};
+  event.events = events;
+  event.data.fd = socket;
+  if (::epoll_ctl(this->epollFd, EPOLL_CTL_MOD, socket, &event) != 0) {
+    std::cerr << "Failed to update socket." << std::endl;
+    printError();
+    return false;
+  }
+  connection.events = events;
+  return true;
+}
+
+void EventLoop::removeWorker(int socket) {
+  auto it = this->workers.find(socket);
+  if (it == this->workers.end()) {
+    return;
+  }
+  // the socket must be removed before it is closed by the worker, because the
+  // file descriptor number could be reused by an accepted connection.
+  ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, socket, nullptr);
+  std::shared_ptr<Worker> worker = it->second.worker;
+  this->workers.erase(it);
+  worker->close();
+}
+
+/**
+ * The method call
+ *   int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int
+ * timeout);
+ * is defined in header <sys/epoll.h>
+ */
+void EventLoop::run() {
+  epoll_event events[EventLoop::MAX_EVENTS];
+
+  while (this->enabled) {
+    // wait without timeout. stop() and add() wake up the thread.
+    int count = ::epoll_wait(this->epollFd, events, EventLoop::MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "epoll_wait failed." << std::endl;
+      printError();
+      break;
+    }
+
+    for (int i = 0; i < count && this->enabled; i++) {
+      int socket = events[i].data.fd;
+      if (socket == -1) {
+        // drain the eventfd counter
+        uint64_t value;
+        while (::read(this->wakeupFd, &value, sizeof(value)) > 0) {
+        }
+        this->registerPending();
+        continue;
+      }
+
+      auto it = this->workers.find(socket);
+      if (it == this->workers.end()) {
+        continue;
+      }
+
+      // EPOLLRDHUP and EPOLLHUP are passed to the worker as well. The read
+      // returns the pending data or end of file.
+      Connection &connection = it->second;
+      bool connected = true;
+      if (events[i].events & EPOLLOUT) {
+        connected = connection.worker->onWritable();
+      }
+      if (connected && (events[i].events & ~EPOLLOUT) != 0) {
+        connected = connection.worker->onReadable();
+      }
+      if (!connected || !this->updateEvents(socket, connection)) {
+        this->removeWorker(socket);
+      }
+    }
+  }
+
+  // close all connections
+  for (auto &entry : this->workers) {
+    ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, entry.first, nullptr);
+    entry.second.worker->close();
+  }
+  this->workers.clear();
+
+  this->running = false;
+  std::cout << "Stopped event loop thread ID: " << std::this_thread::get_id()
+            << std::endl;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+#endif
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "HandshakeStatistics.h"
+#include "OpenSslWrapper.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * An epoll based loop which performs the TLS handshakes of accepted
+ * connections. Each handshake is a state machine which is resumed whenever
+ * the socket is ready for the direction OpenSSL waits for, so many handshakes
+ * progress in parallel and a slow client does not delay the others.
+ *
+ * Established connections are passed to a callback. Handshakes which fail or
+ * do not complete within the timeout are closed.
+ */
+class HandshakeLoop {
+ public:  // type definitions
+  /**
+   * Called by the loop thread for each established connection. The callback
+   * owns the socket and the TLS object.
+   */
+  typedef std::function<void(int socket, OpenSslWrapper::TlsPtr tlsPtr)>
+      EstablishedCallback;
+
+ private:  // type definitions
+  typedef std::chrono::steady_clock Clock;
+
+  struct Handshake {
+    int socket;
+    OpenSslWrapper::TlsPtr tlsPtr;
+    /**
+     * The handshake is aborted if it is not established until the deadline.
+     */
+    Clock::time_point deadline;
+    /**
+     * The events for which the socket is registered at the epoll instance.
+     */
+    std::uint32_t events;
+    /**
+     * The CPU time the loop thread spent in the handshake.
+     */
+    std::uint64_t cpuNanoseconds;
+  };
+
+ private:  // const
+  // max number of events returned by a single epoll_wait call
+  static const unsigned int MAX_EVENTS = 64;
+
+ public:  // construction/destruction/operators
+  /**
+   * @param callback receives the established connections
+   * @param timeoutMilliseconds the time a client has to complete the
+   * handshake after the connection has been accepted
+   */
+  HandshakeLoop(EstablishedCallback callback,
+                unsigned int timeoutMilliseconds);
+  /**
+   * Move constructor
+   */
+  HandshakeLoop(HandshakeLoop &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  HandshakeLoop &operator=(HandshakeLoop &&) = delete;
+  /**
+   * Copy constructor
+   */
+  HandshakeLoop(const HandshakeLoop &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  HandshakeLoop &operator=(const HandshakeLoop &) = delete;
+  /**
+   * Destructor
+   */
+  virtual ~HandshakeLoop();
+
+ public:  // methods
+  /**
+   * Creates the epoll instance and starts the loop thread. Returns false if
+   * the loop could not be started or is already running.
+   */
+  bool start();
+  /**
+   * Returns true if the loop is enabled or running
+   */
+  bool isRunning();
+  /**
+   * Stops the loop thread and closes all connections whose handshake has not
+   * been completed.
+   */
+  void stop();
+  /**
+   * Passes an accepted connection to the loop. The TLS object must be in
+   * accept state. The loop owns the socket and the TLS object until the
+   * connection is passed to the callback.
+   *
+   * @return false if the loop is not running. The connection has been closed
+   * then.
+   */
+  bool add(int socket, OpenSslWrapper::TlsPtr tlsPtr);
+  /**
+   * Returns the number of handshakes which did not complete within the
+   * timeout.
+   */
+  std::size_t getTimeoutCount();
+  /**
+   * Returns the number of handshakes which failed.
+   */
+  std::size_t getFailureCount();
+  /**
+   * Returns the number of full and resumed handshakes and their CPU time.
+   */
+  HandshakeStatistics getStatistics();
+
+ private:  // helper methods
+  /**
+   * The method executed by the loop thread.
+   */
+  void run();
+  /**
+   * Registers the connections passed with add() at the epoll instance.
+   */
+  void registerPending();
+  /**
+   * Continues the handshake until it would block. Updates the events of the
+   * socket to the direction OpenSSL waits for.
+   *
+   * @return 1 if the connection has been established, 0 if the handshake
+   * would block and -1 if it failed.
+   */
+  int resume(Handshake &handshake);
+  /**
+   * Removes the handshake from the epoll instance. An established connection
+   * is passed to the callback, otherwise the connection is closed.
+   */
+  void remove(int socket, bool established);
+  /**
+   * Closes the handshakes whose deadline has passed.
+   *
+   * @return the time until the next deadline in milliseconds, -1 if there is
+   * no handshake.
+   */
+  int expire();
+  /**
+   * Interrupts a blocking epoll_wait call.
+   */
+  bool wakeup();
+
+ private:  // fields
+  std::mutex mutexPublicMethods;
+  std::mutex mutexPending;
+  EstablishedCallback callback;
+  std::chrono::milliseconds timeout;
+  /**
+   * Connections passed with add() which are not yet registered by the loop
+   * thread.
+   */
+  std::vector<Handshake> pending;
+  /**
+   * The handshakes in progress by socket. Only accessed by the loop thread.
+   */
+  std::unordered_map<int, Handshake> handshakes;
+  /**
+   * The epoll instance.
+   */
+  int epollFd;
+  /**
+   * An eventfd to wake up the loop thread.
+   */
+  int wakeupFd;
+  std::atomic_bool enabled;
+  std::atomic_bool running;
+  std::atomic<std::size_t> timeoutCount;
+  std::atomic<std::size_t> failureCount;
+  std::mutex mutexStatistics;
+  HandshakeStatistics statistics;
+  std::thread loopThread;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
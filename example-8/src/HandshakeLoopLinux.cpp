@@ -0,0 +1,412 @@
+#ifdef __linux__
+// linux code goes here
+
+#include <openssl/err.h>
+#include <sys/epoll.h>    // ::epoll_create1(...) ; ::epoll_ctl(...) ; ::epoll_wait(...)
+#include <sys/eventfd.h>  // ::eventfd(...)
+#include <time.h>         // ::clock_gettime(...)
+#include <unistd.h>       // ::close(int), ::read(...), ::write(...)
+
+#include <cerrno>    // errno
+#include <cstdint>   // uint64_t
+#include <cstring>   // ::strerror_r(...)
+#include <iostream>  // std::cout(...) ; std::cerr(...)
+#include <utility>   // std::move
+
+#include "HandshakeLoop.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+HandshakeLoop::HandshakeLoop(EstablishedCallback callback,
+                             unsigned int timeoutMilliseconds)
+    : callback{callback},
+      timeout{timeoutMilliseconds},
+      epollFd{-1},
+      wakeupFd{-1},
+      enabled{false},
+      running{false},
+      timeoutCount{0},
+      failureCount{0} {}
+
+HandshakeLoop::~HandshakeLoop() { this->stop(); }
+
+/**
+ * errno is thread safe. On Linux, the global errno variable is thread-specific.
+ * POSIX requires that errno be threadsafe. If the value of errno should be
+ * preserved across a library call, it must be saved.
+ *
+ * strerror_r is thread safe.
+ *
+ * errno is defined in <cerrno> and is an integer value.
+ *
+ * The method call
+ *   char *::strerror_r(int errnum, char *buf, size_t buflen);
+ * is defined in <cstring>
+ */
+static void printError() {
+  size_t length = 1024;
+  char buffer[length];
+  std::cerr << "(" << errno << ") " << ::strerror_r(errno, buffer, length)
+            << std::endl;
+}
+
+/**
+ * The loop uses epoll and an eventfd like the EventLoop. See
+ * EventLoop::start().
+ */
+bool HandshakeLoop::start() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  if (this->enabled) {
+    std::cerr << "Handshake loop is already running." << std::endl;
+    return false;
+  }
+
+  this->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (this->epollFd == -1) {
+    std::cerr << "Failed to create epoll instance." << std::endl;
+    printError();
+    return false;
+  }
+
+  this->wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->wakeupFd == -1) {
+    std::cerr << "Failed to create eventfd." << std::endl;
+    printError();
+    ::close(this->epollFd);
+    this->epollFd = -1;
+    return false;
+  }
+
+  // the data field is used to identify the socket. -1 identifies the eventfd.
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = -1;
+  if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->wakeupFd, &event) != 0) {
+    std::cerr << "Failed to register eventfd." << std::endl;
+    printError();
+    ::close(this->wakeupFd);
+    ::close(this->epollFd);
+    this->wakeupFd = -1;
+    this->epollFd = -1;
+    return false;
+  }
+
+  this->enabled = true;
+  this->running = true;
+
+  this->loopThread = std::thread(&HandshakeLoop::run, this);
+
+  std::cout << "Handshake loop thread ID: " << this->loopThread.get_id()
+            << std::endl;
+
+  return true;
+}
+
+bool HandshakeLoop::isRunning() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  // return whether loop has been stopped or is still running
+  return this->enabled || this->running;
+}
+
+void HandshakeLoop::stop() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  if (this->enabled) {
+    this->enabled = false;
+
+    if (!this->wakeup()) {
+      printError();
+    }
+
+    std::cout << "Join handshake loop thread" << std::endl;
+
+    if (this->loopThread.joinable()) {
+      this->loopThread.join();
+    }
+
+    // connections which have been added after the loop thread stopped
+    std::unique_lock<std::mutex> lockPending(this->mutexPending);
+    for (Handshake &handshake : this->pending) {
+      handshake.tlsPtr.reset();
+      ::close(handshake.socket);
+    }
+    this->pending.clear();
+
+    ::close(this->wakeupFd);
+    ::close(this->epollFd);
+    this->wakeupFd = -1;
+    this->epollFd = -1;
+
+    this->running = false;
+  }
+}
+
+bool HandshakeLoop::add(int socket, OpenSslWrapper::TlsPtr tlsPtr) {
+  {
+    // stop() takes the lock after it disabled the loop, so a connection
+    // added while the loop is enabled is closed by the loop or by stop().
+    std::unique_lock<std::mutex> lock(this->mutexPending);
+    if (!this->enabled) {
+      tlsPtr.reset();
+      ::close(socket);
+      return false;
+    }
+    Handshake handshake;
+    handshake.socket = socket;
+    handshake.tlsPtr = std::move(tlsPtr);
+    // the time of the accept counts, not the time of the registration
+    handshake.deadline = Clock::now() + this->timeout;
+    handshake.events = 0;
+    handshake.cpuNanoseconds = 0;
+    this->pending.push_back(std::move(handshake));
+  }
+  // the loop thread registers the socket, so the handshakes map needs no lock.
+  return this->wakeup();
+}
+
+std::size_t HandshakeLoop::getTimeoutCount() { return this->timeoutCount; }
+
+std::size_t HandshakeLoop::getFailureCount() { return this->failureCount; }
+
+HandshakeStatistics HandshakeLoop::getStatistics() {
+  std::unique_lock<std::mutex> lock(this->mutexStatistics);
+  return this->statistics;
+}
+
+bool HandshakeLoop::wakeup() {
+  uint64_t value = 1;
+  // EAGAIN means the counter is already set and the loop will wake up anyway.
+  return ::write(this->wakeupFd, &value, sizeof(value)) == sizeof(value) ||
+         errno == EAGAIN;
+}
+
+void HandshakeLoop::registerPending() {
+  std::vector<Handshake> added;
+  {
+    std::unique_lock<std::mutex> lock(this->mutexPending);
+    added.swap(this->pending);
+  }
+
+  for (Handshake &handshake : added) {
+    int socket = handshake.socket;
+
+    // the client sends the first message, so wait for data
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = socket;
+    if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, socket, &event) != 0) {
+      std::cerr << "Failed to register socket." << std::endl;
+      printError();
+      handshake.tlsPtr.reset();
+      ::close(socket);
+      continue;
+    }
+    handshake.events = event.events;
+    Handshake &registered = this->handshakes[socket];
+    registered = std::move(handshake);
+
+    // the client hello might have arrived already
+    int rc = this->resume(registered);
+    if (rc != 0) {
+      this->remove(socket, rc > 0);
+    }
+  }
+}
+
+/**
+ * Returns the CPU time of the calling thread in nanoseconds. All handshakes
+ * run on the loop thread, so the difference of two calls is the CPU time of
+ * the handshake step in between.
+ */
+static std::uint64_t getThreadCpuTime() {
+  timespec time;
+  if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(time.tv_sec) * 1000000000ull +
+         static_cast<std::uint64_t>(time.tv_nsec);
+}
+
+/**
+ * SSL_do_handshake() performs the next steps of the handshake. On a
+ * non-blocking socket it returns with SSL_ERROR_WANT_READ or
+ * SSL_ERROR_WANT_WRITE if it has to wait for the peer and continues where it
+ * stopped when it is called again.
+ *
+ * The method call
+ *   int SSL_do_handshake(SSL *ssl);
+ * is defined in header <openssl/ssl.h>
+ */
+int HandshakeLoop::resume(Handshake &handshake) {
+  // SSL_get_error() requires an empty error queue
+  ::ERR_clear_error();
+  std::uint64_t start = getThreadCpuTime();
+  int rc = ::SSL_do_handshake(handshake.tlsPtr.get());
+  handshake.cpuNanoseconds += getThreadCpuTime() - start;
+  if (rc == 1) {
+    return 1;
+  }
+
+  std::uint32_t events;
+  int error = ::SSL_get_error(handshake.tlsPtr.get(), rc);
+  if (error == SSL_ERROR_WANT_READ) {
+    events = EPOLLIN;
+  } else if (error == SSL_ERROR_WANT_WRITE) {
+    events = EPOLLOUT;
+  } else {
+    ::perror("Unable to accept tls connection.");
+    // prints the error strings for all errors that OpenSSL has recorded to
+    // file, thus emptying the error queue.
+    ::ERR_print_errors_fp(stderr);
+    return -1;
+  }
+
+  if (events != handshake.events) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.fd = handshake.socket;
+    if (::epoll_ctl(this->epollFd, EPOLL_CTL_MOD, handshake.socket, &event) !=
+        0) {
+      std::cerr << "Failed to update socket." << std::endl;
+      printError();
+      return -1;
+    }
+    handshake.events = events;
+  }
+  return 0;
+}
+
+void HandshakeLoop::remove(int socket, bool established) {
+  auto it = this->handshakes.find(socket);
+  if (it == this->handshakes.end()) {
+    return;
+  }
+  // the socket is served by a worker or closed, so the loop must not report it
+  // anymore.
+  ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, socket, nullptr);
+  OpenSslWrapper::TlsPtr tlsPtr = std::move(it->second.tlsPtr);
+  std::uint64_t cpuNanoseconds = it->second.cpuNanoseconds;
+  this->handshakes.erase(it);
+
+  if (established) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutexStatistics);
+      if (::SSL_session_reused(tlsPtr.get()) == 1) {
+        this->statistics.resumedCount++;
+        this->statistics.resumedCpuNanoseconds += cpuNanoseconds;
+      } else {
+        this->statistics.fullCount++;
+        this->statistics.fullCpuNanoseconds += cpuNanoseconds;
+      }
+    }
+    this->callback(socket, std::move(tlsPtr));
+  } else {
+    this->failureCount++;
+    tlsPtr.reset();
+    ::close(socket);
+  }
+}
+
+int HandshakeLoop::expire() {
+  Clock::time_point now = Clock::now();
+  Clock::time_point next = Clock::time_point::max();
+
+  std::vector<int> expired;
+  for (auto &entry : this->handshakes) {
+    if (entry.second.deadline <= now) {
+      expired.push_back(entry.first);
+    } else if (entry.second.deadline < next) {
+      next = entry.second.deadline;
+    }
+  }
+
+  for (int socket : expired) {
+    std::cerr << "TLS handshake timed out." << std::endl;
+    auto it = this->handshakes.find(socket);
+    ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, socket, nullptr);
+    it->second.tlsPtr.reset();
+    this->handshakes.erase(it);
+    ::close(socket);
+    this->timeoutCount++;
+  }
+
+  if (next == Clock::time_point::max()) {
+    return -1;
+  }
+  // round up, so the loop does not wake up before the deadline
+  auto remaining =
+      std::chrono::duration_cast<std::chrono::milliseconds>(next - now) +
+      std::chrono::milliseconds(1);
+  return static_cast<int>(remaining.count());
+}
+
+/**
+ * The method call
+ *   int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int
+ * timeout);
+ * is defined in header <sys/epoll.h>
+ */
+void HandshakeLoop::run() {
+  epoll_event events[HandshakeLoop::MAX_EVENTS];
+
+  while (this->enabled) {
+    // wait until the next deadline. stop() and add() wake up the thread.
+    int timeout = this->expire();
+    int count =
+        ::epoll_wait(this->epollFd, events, HandshakeLoop::MAX_EVENTS, timeout);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "epoll_wait failed." << std::endl;
+      printError();
+      break;
+    }
+
+    for (int i = 0; i < count && this->enabled; i++) {
+      int socket = events[i].data.fd;
+      if (socket == -1) {
+        // drain the eventfd counter
+        uint64_t value;
+        while (::read(this->wakeupFd, &value, sizeof(value)) > 0) {
+        }
+        this->registerPending();
+        continue;
+      }
+
+      auto it = this->handshakes.find(socket);
+      if (it == this->handshakes.end()) {
+        continue;
+      }
+
+      // EPOLLHUP and EPOLLERR are reported by the handshake
+      int rc = this->resume(it->second);
+      if (rc != 0) {
+        this->remove(socket, rc > 0);
+      }
+    }
+  }
+
+  // close all connections which are not established
+  for (auto &entry : this->handshakes) {
+    ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, entry.first, nullptr);
+    entry.second.tlsPtr.reset();
+    ::close(entry.first);
+  }
+  this->handshakes.clear();
+
+  this->running = false;
+  std::cout << "Stopped handshake loop thread ID: "
+            << std::this_thread::get_id() << std::endl;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * The completed TLS handshakes of a server and the CPU time spent in them.
+ */
+struct HandshakeStatistics {
+  /**
+   * The number of handshakes with key exchange and certificate.
+   */
+  std::size_t fullCount = 0;
+  /**
+   * The number of handshakes which resumed a session.
+   */
+  std::size_t resumedCount = 0;
+  std::uint64_t fullCpuNanoseconds = 0;
+  std::uint64_t resumedCpuNanoseconds = 0;
+
+  /**
+   * Returns the share of resumed handshakes in percent.
+   */
+  double getResumptionRate() const {
+    std::size_t count = this->fullCount + this->resumedCount;
+    return count == 0 ? 0.0
+                      : 100.0 * static_cast<double>(this->resumedCount) /
+                            static_cast<double>(count);
+  }
+
+  /**
+   * Returns the CPU time the resumed handshakes would have spent in addition
+   * as full handshakes, estimated from the average of the full handshakes.
+   */
+  std::uint64_t getSavedCpuNanoseconds() const {
+    if (this->fullCount == 0) {
+      return 0;
+    }
+    std::uint64_t full =
+        this->fullCpuNanoseconds / this->fullCount * this->resumedCount;
+    return full > this->resumedCpuNanoseconds
+               ? full - this->resumedCpuNanoseconds
+               : 0;
+  }
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,141 @@
+#include "Hex.h"
+
+#include <cstring>  // std::memcpy(...)
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+static const char DIGITS[] = "0123456789abcdef";
+// marks a character which is not a digit
+static const unsigned char INVALID = 0xFF;
+
+/**
+ * The two digits of each byte, so a byte is encoded with one lookup.
+ */
+struct EncodeTable {
+  char pairs[256][2];
+
+  EncodeTable() {
+    for (unsigned int i = 0; i < 256; i++) {
+      this->pairs[i][0] = DIGITS[i >> 4];
+      this->pairs[i][1] = DIGITS[i & 0x0F];
+    }
+  }
+};
+
+/**
+ * The value of each character or INVALID.
+ */
+struct DecodeTable {
+  unsigned char values[256];
+
+  DecodeTable() {
+    for (unsigned int i = 0; i < 256; i++) {
+      this->values[i] = INVALID;
+    }
+    for (unsigned int i = 0; i < 16; i++) {
+      this->values[static_cast<unsigned char>(DIGITS[i])] =
+          static_cast<unsigned char>(i);
+      this->values[static_cast<unsigned char>("0123456789ABCDEF"[i])] =
+          static_cast<unsigned char>(i);
+    }
+  }
+};
+
+static void encodeScalar(const unsigned char *data, std::size_t size,
+                         char *encoded) {
+  // initialized on first use and thread safe since C++11
+  static const EncodeTable table;
+  for (std::size_t i = 0; i < size; i++) {
+    std::memcpy(encoded + 2 * i, table.pairs[data[i]], 2);
+  }
+}
+
+static bool decodeScalar(const char *encoded, std::size_t size,
+                         unsigned char *decoded) {
+  // initialized on first use and thread safe since C++11
+  static const DecodeTable table;
+  const unsigned char *in = reinterpret_cast<const unsigned char *>(encoded);
+  for (std::size_t i = 0; i + 2 <= size; i += 2) {
+    unsigned int high = table.values[in[i]];
+    unsigned int low = table.values[in[i + 1]];
+    // INVALID is the only value with the high bit
+    if (((high | low) & 0x80) != 0) {
+      return false;
+    }
+    decoded[i / 2] = static_cast<unsigned char>((high << 4) | low);
+  }
+  return true;
+}
+
+Hex::Kernel Hex::getDefaultKernel() {
+  // initialized on first use and thread safe since C++11
+  static const Kernel kernel =
+      Hex::isSupported(Kernel::Ssse3) ? Kernel::Ssse3 : Kernel::Scalar;
+  return kernel;
+}
+
+bool Hex::isSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Scalar:
+      return true;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    case Kernel::Ssse3:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("ssse3");
+#endif
+    default:
+      return false;
+  }
+}
+
+std::string Hex::getKernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Scalar:
+      return "scalar";
+    case Kernel::Ssse3:
+      return "ssse3";
+  }
+  return "";
+}
+
+std::size_t Hex::getEncodedSize(std::size_t size) { return 2 * size; }
+
+std::size_t Hex::getDecodedSize(std::size_t size) { return size / 2; }
+
+void Hex::encode(const unsigned char *data, std::size_t size, char *encoded) {
+  Hex::encode(data, size, encoded, Hex::getDefaultKernel());
+}
+
+void Hex::encode(const unsigned char *data, std::size_t size, char *encoded,
+                 Kernel kernel) {
+  std::size_t consumed = 0;
+  if (kernel == Kernel::Ssse3) {
+    consumed = Hex::encodeSsse3(data, size, encoded);
+  }
+  encodeScalar(data + consumed, size - consumed, encoded + 2 * consumed);
+}
+
+bool Hex::decode(const char *encoded, std::size_t size,
+                 unsigned char *decoded) {
+  return Hex::decode(encoded, size, decoded, Hex::getDefaultKernel());
+}
+
+bool Hex::decode(const char *encoded, std::size_t size,
+                 unsigned char *decoded, Kernel kernel) {
+  if (size % 2 != 0) {
+    return false;
+  }
+  std::size_t consumed = 0;
+  if (kernel == Kernel::Ssse3 &&
+      !Hex::decodeSsse3(encoded, size, decoded, consumed)) {
+    return false;
+  }
+  return decodeScalar(encoded + consumed, size - consumed,
+                      decoded + consumed / 2);
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
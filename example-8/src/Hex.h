@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A hex codec (RFC 4648 base16) without allocations. The data is processed
+ * by a kernel which is selected at runtime by the features of the CPU: the
+ * SSSE3 kernel processes 16 bytes per step, the scalar kernel looks up the
+ * two digits of a byte in a table. All kernels produce the same output.
+ *
+ * The encoder writes lowercase digits. The decoder accepts lowercase and
+ * uppercase digits and rejects any other character.
+ */
+class Hex {
+ public:  // type definitions
+  enum class Kernel { Scalar, Ssse3 };
+
+ public:  // methods
+  /**
+   * Returns the fastest kernel supported by the CPU. The CPU is queried once.
+   */
+  static Kernel getDefaultKernel();
+  static bool isSupported(Kernel kernel);
+  static std::string getKernelName(Kernel kernel);
+
+  /**
+   * Returns the number of digits of the encoded data.
+   */
+  static std::size_t getEncodedSize(std::size_t size);
+  /**
+   * Returns the number of bytes of the decoded digits.
+   */
+  static std::size_t getDecodedSize(std::size_t size);
+
+  /**
+   * Encodes the data with the default kernel.
+   *
+   * @param encoded receives getEncodedSize(size) characters
+   */
+  static void encode(const unsigned char *data, std::size_t size,
+                     char *encoded);
+  static void encode(const unsigned char *data, std::size_t size,
+                     char *encoded, Kernel kernel);
+
+  /**
+   * Decodes the digits with the default kernel.
+   *
+   * @param decoded receives getDecodedSize(size) bytes
+   * @return false if the number of digits is odd or a character is not a
+   * digit. The content of decoded is undefined then.
+   */
+  static bool decode(const char *encoded, std::size_t size,
+                     unsigned char *decoded);
+  static bool decode(const char *encoded, std::size_t size,
+                     unsigned char *decoded, Kernel kernel);
+
+ private:  // kernels
+  /**
+   * The SIMD kernels process a prefix of whole blocks and leave the rest to
+   * the scalar kernel.
+   *
+   * @return the number of bytes consumed
+   */
+  static std::size_t encodeSsse3(const unsigned char *data, std::size_t size,
+                                 char *encoded);
+  /**
+   * @param consumed the number of digits consumed
+   * @return false if an invalid character has been found
+   */
+  static bool decodeSsse3(const char *encoded, std::size_t size,
+                          unsigned char *decoded, std::size_t &consumed);
+
+ private:
+  Hex() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
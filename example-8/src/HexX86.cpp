@@ -0,0 +1,126 @@
+#include "Hex.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+/**
+ * The kernels are compiled for their instruction set with the target
+ * attribute, so the binary runs on CPUs without them. Hex::isSupported()
+ * must be checked before a kernel is called.
+ */
+#define HEX_SSSE3 __attribute__((target("ssse3")))
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// encode
+
+/**
+ * Splits 16 bytes into their nibbles and translates each nibble with a
+ * shuffle of the 16 digits. The two halves of the digits are interleaved, so
+ * the high digit of a byte comes first.
+ */
+HEX_SSSE3 std::size_t Hex::encodeSsse3(const unsigned char *data,
+                                       std::size_t size, char *encoded) {
+  const __m128i digits =
+      _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
+                    'b', 'c', 'd', 'e', 'f');
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i high = _mm_shuffle_epi8(
+        digits, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+    __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(in, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(encoded + 2 * i),
+                     _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(encoded + 2 * i + 16),
+                     _mm_unpackhi_epi8(high, low));
+  }
+  return i;
+}
+
+// decode
+
+/**
+ * Returns 0xFF for each byte in [low, high]. Bytes >= 0x80 are negative and
+ * never in range.
+ */
+HEX_SSSE3 static inline __m128i inRangeSsse3(__m128i in, char low,
+                                             char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(low - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), in));
+}
+
+/**
+ * Translates digits to their values. Setting bit 5 maps 'A'-'F' to 'a'-'f'
+ * and no other character into this range. Returns false if a character is
+ * not a digit.
+ */
+HEX_SSSE3 static inline bool toValuesSsse3(__m128i in, __m128i &values) {
+  const __m128i digit = inRangeSsse3(in, '0', '9');
+  const __m128i lower = _mm_or_si128(in, _mm_set1_epi8(0x20));
+  const __m128i letter = inRangeSsse3(lower, 'a', 'f');
+  if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xFFFF) {
+    return false;
+  }
+  values = _mm_or_si128(
+      _mm_and_si128(digit, _mm_sub_epi8(in, _mm_set1_epi8('0'))),
+      _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  return true;
+}
+
+/**
+ * Joins 32 digits to 16 bytes. Each pair of values is multiplied with 16 and
+ * 1 and added to a 16-bit word, which is packed to a byte.
+ */
+HEX_SSSE3 bool Hex::decodeSsse3(const char *encoded, std::size_t size,
+                                unsigned char *decoded,
+                                std::size_t &consumed) {
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m128i first;
+    __m128i second;
+    const __m128i *in = reinterpret_cast<const __m128i *>(encoded + i);
+    if (!toValuesSsse3(_mm_loadu_si128(in), first) ||
+        !toValuesSsse3(_mm_loadu_si128(in + 1), second)) {
+      return false;
+    }
+    __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                                     _mm_maddubs_epi16(second, weights));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(decoded + i / 2), bytes);
+  }
+  consumed = i;
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#else
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// The SIMD kernels are only available on x86. Hex::isSupported() returns
+// false for them.
+std::size_t Hex::encodeSsse3(const unsigned char *, std::size_t, char *) {
+  return 0;
+}
+
+bool Hex::decodeSsse3(const char *, std::size_t, unsigned char *,
+                      std::size_t &consumed) {
+  consumed = 0;
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#endif
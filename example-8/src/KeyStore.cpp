@@ -0,0 +1,180 @@
+#include "KeyStore.h"
+
+#include <openssl/crypto.h>  // ::OPENSSL_cleanse(...) ; ::CRYPTO_memcmp(...)
+#include <openssl/evp.h>     // ::EVP_sha256()
+#include <openssl/hmac.h>    // ::HMAC(...)
+#include <openssl/rand.h>    // ::RAND_bytes(...)
+#include <sys/stat.h>        // ::stat(...)
+
+#include <utility>  // std::move
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Returns a new handle which holds a reference of the cached key.
+ *
+ * The method call
+ *   int EVP_PKEY_up_ref(EVP_PKEY *key);
+ * is defined in header <openssl/evp.h>
+ */
+static OpenSslWrapper::TlsKey share(const OpenSslWrapper::TlsKey &key) {
+  ::EVP_PKEY_up_ref(key.get());
+  return OpenSslWrapper::TlsKey(key.get());
+}
+
+static OpenSslWrapper::TlsX509Cert share(
+    const OpenSslWrapper::TlsX509Cert &cert) {
+  ::X509_up_ref(cert.get());
+  return OpenSslWrapper::TlsX509Cert(cert.get());
+}
+
+KeyStore::KeyStore() : secret{}, hasSecret{false}, loadCount{0}, hitCount{0} {
+  this->hasSecret = ::RAND_bytes(this->secret.data(),
+                                 static_cast<int>(this->secret.size())) == 1;
+}
+
+KeyStore::~KeyStore() {
+  this->clear();
+  ::OPENSSL_cleanse(this->secret.data(), this->secret.size());
+}
+
+bool KeyStore::getFileVersion(const std::string &fileName,
+                              FileVersion &version) {
+  struct stat fileStatus;
+  if (::stat(fileName.c_str(), &fileStatus) != 0) {
+    return false;
+  }
+#ifdef __linux__
+  version.modified =
+      static_cast<long long>(fileStatus.st_mtim.tv_sec) * 1000000000LL +
+      fileStatus.st_mtim.tv_nsec;
+#else
+  version.modified = static_cast<long long>(fileStatus.st_mtime);
+#endif
+  version.size = static_cast<long long>(fileStatus.st_size);
+  return true;
+}
+
+bool KeyStore::hashPassword(const std::string &password,
+                            PasswordDigest &digest) const {
+  unsigned int size = 0;
+  return this->hasSecret &&
+         ::HMAC(::EVP_sha256(), this->secret.data(),
+                static_cast<int>(this->secret.size()),
+                reinterpret_cast<const unsigned char *>(password.data()),
+                password.size(), digest.data(), &size) != nullptr &&
+         size == digest.size();
+}
+
+/**
+ * The file is parsed without the lock, so a slow file does not block the
+ * callers of other entries. If two threads parse the same file, the last one
+ * replaces the entry.
+ */
+bool KeyStore::getKey(const std::string &fileName, const std::string &password,
+                      OpenSslWrapper::TlsKey &key) {
+  FileVersion version;
+  if (!KeyStore::getFileVersion(fileName, version)) {
+    return false;
+  }
+  KeyEntry entry;
+  entry.version = version;
+  if (!this->hashPassword(password, entry.password)) {
+    // without a digest the key can not be matched to its password
+    return OpenSslWrapper::readKeyFile(fileName, key, password);
+  }
+  {
+    std::unique_lock<std::mutex> lock(this->mutexEntries);
+    auto it = this->keys.find(fileName);
+    if (it != this->keys.end() && it->second.version == version &&
+        ::CRYPTO_memcmp(it->second.password.data(), entry.password.data(),
+                        entry.password.size()) == 0) {
+      this->hitCount++;
+      key = share(it->second.key);
+      return true;
+    }
+  }
+
+  if (!OpenSslWrapper::readKeyFile(fileName, entry.key, password)) {
+    return false;
+  }
+  key = share(entry.key);
+
+  std::unique_lock<std::mutex> lock(this->mutexEntries);
+  this->loadCount++;
+  this->keys[fileName] = std::move(entry);
+  return true;
+}
+
+bool KeyStore::getCert(const std::string &fileName,
+                       OpenSslWrapper::TlsX509Cert &cert) {
+  return this->loadCert(fileName, &cert, nullptr);
+}
+
+bool KeyStore::getCertKey(const std::string &fileName,
+                          OpenSslWrapper::TlsKey &key) {
+  return this->loadCert(fileName, nullptr, &key);
+}
+
+bool KeyStore::loadCert(const std::string &fileName,
+                        OpenSslWrapper::TlsX509Cert *cert,
+                        OpenSslWrapper::TlsKey *publicKey) {
+  FileVersion version;
+  if (!KeyStore::getFileVersion(fileName, version)) {
+    return false;
+  }
+  {
+    std::unique_lock<std::mutex> lock(this->mutexEntries);
+    auto it = this->certs.find(fileName);
+    if (it != this->certs.end() && it->second.version == version) {
+      this->hitCount++;
+      if (cert != nullptr) {
+        *cert = share(it->second.cert);
+      }
+      if (publicKey != nullptr) {
+        *publicKey = share(it->second.publicKey);
+      }
+      return true;
+    }
+  }
+
+  CertEntry entry;
+  entry.version = version;
+  if (!OpenSslWrapper::readCertFile(fileName, entry.cert, "") ||
+      !OpenSslWrapper::readCertKey(entry.cert, entry.publicKey)) {
+    return false;
+  }
+  if (cert != nullptr) {
+    *cert = share(entry.cert);
+  }
+  if (publicKey != nullptr) {
+    *publicKey = share(entry.publicKey);
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutexEntries);
+  this->loadCount++;
+  this->certs[fileName] = std::move(entry);
+  return true;
+}
+
+void KeyStore::clear() {
+  std::unique_lock<std::mutex> lock(this->mutexEntries);
+  this->keys.clear();
+  this->certs.clear();
+}
+
+std::size_t KeyStore::getLoadCount() {
+  std::unique_lock<std::mutex> lock(this->mutexEntries);
+  return this->loadCount;
+}
+
+std::size_t KeyStore::getHitCount() {
+  std::unique_lock<std::mutex> lock(this->mutexEntries);
+  return this->hitCount;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
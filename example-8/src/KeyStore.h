@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "OpenSslWrapper.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A cache of the keys and certificates read from PEM files. Each file is
+ * parsed once and the parsed object is shared by all callers, so repeated
+ * sign and verify operations do not read and parse the file again.
+ *
+ * The returned handles hold a reference of the cached EVP_PKEY or X509
+ * object. The objects are shared between threads and must not be modified.
+ * An entry is read again if the modification time or the size of its file
+ * has changed.
+ */
+class KeyStore {
+ private:  // type definitions
+  /**
+   * The state of a file when it has been parsed.
+   */
+  struct FileVersion {
+    long long modified;
+    long long size;
+
+    bool operator==(const FileVersion &other) const {
+      return this->modified == other.modified && this->size == other.size;
+    }
+  };
+
+  /**
+   * An HMAC-SHA256 of a password.
+   */
+  typedef std::array<unsigned char, 32> PasswordDigest;
+
+  struct KeyEntry {
+    FileVersion version;
+    /**
+     * The digest of the password which decrypted the key. A key is not
+     * returned for another password. The password itself is not kept.
+     */
+    PasswordDigest password;
+    OpenSslWrapper::TlsKey key;
+  };
+
+  struct CertEntry {
+    FileVersion version;
+    OpenSslWrapper::TlsX509Cert cert;
+    /**
+     * The public key of the certificate.
+     */
+    OpenSslWrapper::TlsKey publicKey;
+  };
+
+ public:  // construction/destruction/operators
+  KeyStore();
+  /**
+   * Move constructor
+   */
+  KeyStore(KeyStore &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  KeyStore &operator=(KeyStore &&) = delete;
+  /**
+   * Copy constructor
+   */
+  KeyStore(const KeyStore &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  KeyStore &operator=(const KeyStore &) = delete;
+  /**
+   * Destructor
+   */
+  virtual ~KeyStore();
+
+ public:  // methods
+  /**
+   * Returns the private key of the file.
+   *
+   * @param password the password of an encrypted key or an empty string
+   * @return false if the file could not be read or parsed
+   */
+  bool getKey(const std::string &fileName, const std::string &password,
+              OpenSslWrapper::TlsKey &key);
+  /**
+   * Returns the certificate of the file.
+   */
+  bool getCert(const std::string &fileName, OpenSslWrapper::TlsX509Cert &cert);
+  /**
+   * Returns the public key of the certificate of the file.
+   */
+  bool getCertKey(const std::string &fileName, OpenSslWrapper::TlsKey &key);
+  /**
+   * Removes all entries. Handles which have been returned stay valid.
+   */
+  void clear();
+  /**
+   * Returns the number of files which have been parsed.
+   */
+  std::size_t getLoadCount();
+  /**
+   * Returns the number of calls which have been served from the cache.
+   */
+  std::size_t getHitCount();
+
+ private:  // helper methods
+  /**
+   * Returns false if the file does not exist.
+   */
+  static bool getFileVersion(const std::string &fileName,
+                             FileVersion &version);
+  /**
+   * Computes the HMAC of the password with the secret of the store.
+   *
+   * @return false if the store has no secret or OpenSSL failed
+   */
+  bool hashPassword(const std::string &password, PasswordDigest &digest) const;
+  /**
+   * Returns the entry of the certificate file. The file is parsed if it is
+   * not cached or has changed. The mutex must not be locked.
+   */
+  bool loadCert(const std::string &fileName,
+                OpenSslWrapper::TlsX509Cert *cert,
+                OpenSslWrapper::TlsKey *publicKey);
+
+ private:  // fields
+  std::mutex mutexEntries;
+  /**
+   * A random key of the HMAC of the passwords, so the digests can only be
+   * compared within this store.
+   */
+  std::array<unsigned char, 32> secret;
+  bool hasSecret;
+  std::unordered_map<std::string, KeyEntry> keys;
+  std::unordered_map<std::string, CertEntry> certs;
+  std::size_t loadCount;
+  std::size_t hitCount;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A histogram of latencies in the style of HdrHistogram. The values are
+ * counted in buckets with a constant relative precision: values below
+ * 2 * SUB_BUCKET_COUNT are counted exactly, larger values in buckets whose
+ * width is less than 1% of the value. Recording is a constant time
+ * operation without allocations, so it can be done on the measured path.
+ */
+class LatencyHistogram {
+ private:  // const
+  // number of linear buckets of each power of two (2^7). Defines the
+  // precision of the recorded values.
+  static const unsigned int SUB_BUCKET_BITS = 7;
+  static const std::uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+ public:  // construction/destruction/operators
+  /**
+   * Default constructor
+   */
+  LatencyHistogram();
+
+ public:  // methods
+  /**
+   * Counts the value, e.g. a latency in nanoseconds.
+   */
+  void record(std::uint64_t value);
+  /**
+   * Adds all values counted by the other histogram.
+   */
+  void merge(const LatencyHistogram &other);
+  /**
+   * Returns the number of recorded values.
+   */
+  std::uint64_t getCount() const;
+  std::uint64_t getMin() const;
+  std::uint64_t getMax() const;
+  double getMean() const;
+  /**
+   * Returns the value below which the given percentage of the recorded values
+   * fall, e.g. 99.9 for the 99.9th percentile. The value is the upper bound of
+   * its bucket.
+   */
+  std::uint64_t getValueAtPercentile(double percentile) const;
+
+ private:  // helper methods
+  static std::size_t getIndex(std::uint64_t value);
+  static std::uint64_t getHighestValue(std::size_t index);
+
+ private:  // fields
+  std::vector<std::uint64_t> counts;
+  std::uint64_t count;
+  std::uint64_t min;
+  std::uint64_t max;
+  double sum;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,211 @@
+#include "LoadGenerator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Client.h"
+#include "LatencyHistogram.h"
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * The measurements of a single connection.
+ */
+struct ConnectionResult {
+  LatencyHistogram histogram;
+  std::uint64_t sent = 0;
+  bool failed = false;
+};
+
+/**
+ * Sends a message at each scheduled time until the end of the measurement and
+ * records the latency of each echo. The echoes arrive in the order of the
+ * messages, so the scheduled times are kept in a queue. With framing each
+ * message is sent as a frame and each echoed frame completes one message.
+ */
+static void runConnection(Client &client, Clock::time_point next,
+                          Clock::duration interval, Clock::time_point end,
+                          Clock::time_point deadline, std::size_t size,
+                          bool framing, ConnectionResult &result) {
+  std::string message(size, 'x');
+  std::deque<Clock::time_point> scheduled;
+  std::size_t received = 0;
+
+  while (true) {
+    Clock::time_point now = Clock::now();
+    // a late sender catches up. The delay is part of the latency.
+    while (next < end && next <= now) {
+      if (!(framing ? client.writeFrame(message.c_str(), message.size())
+                    : client.write(message.c_str(), message.size()))) {
+        result.failed = true;
+        return;
+      }
+      scheduled.push_back(next);
+      result.sent++;
+      next += interval;
+    }
+
+    // take all available echoes
+    while (true) {
+      BufferView response;
+      int rc =
+          framing ? client.tryReadFrame(response) : client.tryRead(response);
+      if (rc < 0 || (rc > 0 && response.empty())) {
+        // an error occured or the server closed the connection
+        result.failed = true;
+        return;
+      } else if (rc == 0) {
+        break;
+      } else if (framing && response.size() != size) {
+        // the echo of a frame must be the same frame
+        result.failed = true;
+        return;
+      }
+      received += response.size();
+      Clock::time_point time = Clock::now();
+      while (received >= size && !scheduled.empty()) {
+        received -= size;
+        result.histogram.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                time - scheduled.front())
+                .count()));
+        scheduled.pop_front();
+      }
+    }
+
+    now = Clock::now();
+    if ((next >= end && scheduled.empty()) || now >= deadline) {
+      break;
+    }
+    // wait for echoes until the next message is due
+    Clock::time_point wakeup = next < end ? next : deadline;
+    long timeout = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(wakeup - now)
+            .count());
+    if (timeout > 0) {
+      client.waitForData(timeout);
+    }
+  }
+}
+
+static double toMicroseconds(std::uint64_t nanoseconds) {
+  return static_cast<double>(nanoseconds) / 1000.0;
+}
+
+int LoadGenerator::run(const std::string &host, unsigned short port,
+                       unsigned int connections, unsigned int rate,
+                       std::size_t size, unsigned int seconds,
+                       bool framing) {
+  if (connections == 0 || rate == 0 || size == 0) {
+    std::cerr << "Connections, rate and size must be greater than 0."
+              << std::endl;
+    return -1;
+  }
+
+  // connect before the measurement starts
+  std::vector<std::unique_ptr<Client>> clients;
+  unsigned int failedConnections = 0;
+  for (unsigned int i = 0; i < connections; i++) {
+    std::unique_ptr<Client> client(new Client(host, port));
+    if (client->open()) {
+      clients.push_back(std::move(client));
+    } else {
+      failedConnections++;
+    }
+  }
+  if (clients.empty()) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    return -1;
+  }
+
+  // each connection sends every interval. The connections are staggered, so
+  // the messages are spread evenly over the interval.
+  Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::nanoseconds(1000000000ull * clients.size() / rate));
+  if (interval <= Clock::duration::zero()) {
+    interval = Clock::duration(1);
+  }
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::seconds(seconds);
+  Clock::time_point deadline =
+      end + std::chrono::milliseconds(
+                static_cast<std::chrono::milliseconds::rep>(
+                    LoadGenerator::DRAIN_TIMEOUT_MILLISECONDS));
+
+  std::vector<ConnectionResult> results(clients.size());
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < clients.size(); i++) {
+    Clock::time_point first = start + interval * i / clients.size();
+    Client *client = clients[i].get();
+    ConnectionResult *result = &results[i];
+    threads.emplace_back([client, first, interval, end, deadline, size,
+                          framing, result]() {
+      runConnection(*client, first, interval, end, deadline, size, framing,
+                    *result);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  Clock::time_point stop = Clock::now();
+
+  for (std::unique_ptr<Client> &client : clients) {
+    client->close();
+  }
+
+  LatencyHistogram histogram;
+  std::uint64_t sent = 0;
+  for (ConnectionResult &result : results) {
+    histogram.merge(result.histogram);
+    sent += result.sent;
+    if (result.failed) {
+      failedConnections++;
+    }
+  }
+
+  double elapsed = std::chrono::duration<double>(stop - start).count();
+  double completed = static_cast<double>(histogram.getCount());
+
+  std::cout << "Connections: " << connections << std::endl;
+  std::cout << "Failed connections: " << failedConnections << std::endl;
+  std::cout << "Target rate: " << rate << " requests/s" << std::endl;
+  std::cout << "Message size: " << size << " bytes" << std::endl;
+  std::cout << "Framing: " << (framing ? "on" : "off") << std::endl;
+  std::cout << "Duration: " << elapsed << " s" << std::endl;
+  std::cout << "Sent requests: " << sent << std::endl;
+  std::cout << "Completed requests: " << histogram.getCount() << std::endl;
+  std::cout << "Throughput: " << completed / elapsed << " requests/s, "
+            << completed * size / elapsed / (1024 * 1024) << " MiB/s"
+            << std::endl;
+  std::cout << "Min latency: " << toMicroseconds(histogram.getMin()) << " us"
+            << std::endl;
+  std::cout << "Avg latency: " << histogram.getMean() / 1000.0 << " us"
+            << std::endl;
+  std::cout << "p50 latency: "
+            << toMicroseconds(histogram.getValueAtPercentile(50.0)) << " us"
+            << std::endl;
+  std::cout << "p99 latency: "
+            << toMicroseconds(histogram.getValueAtPercentile(99.0)) << " us"
+            << std::endl;
+  std::cout << "p99.9 latency: "
+            << toMicroseconds(histogram.getValueAtPercentile(99.9)) << " us"
+            << std::endl;
+  std::cout << "Max latency: " << toMicroseconds(histogram.getMax()) << " us"
+            << std::endl;
+
+  return failedConnections == 0 && histogram.getCount() == sent ? 0 : -1;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Generates load on a running TLS echo server and measures its latency.
+ *
+ * The generator is open loop: each connection sends its messages on a fixed
+ * schedule, whether or not the previous echoes have arrived. The latency of a
+ * request is measured from the time it was scheduled, so a server which falls
+ * behind is not hidden by a client which waits for it (coordinated omission).
+ */
+class LoadGenerator {
+ private:  // const
+  // time to wait for outstanding echoes after the last message (5s)
+  static const unsigned int DRAIN_TIMEOUT_MILLISECONDS = 5000;
+
+ public:
+  /**
+   * Opens the connections, sends messages at the given total rate for the
+   * given duration and prints the throughput and the latency percentiles.
+   *
+   * @param host the address of the server
+   * @param port the port of the server
+   * @param connections the number of concurrent connections
+   * @param rate the number of messages per second of all connections
+   * @param size the size of each message in bytes
+   * @param seconds the duration of the measurement
+   * @param framing true to send each message as a length-prefixed frame to a
+   * server with framing
+   * @return 0 on success, otherwise -1
+   */
+  static int run(const std::string &host, unsigned short port,
+                 unsigned int connections, unsigned int rate,
+                 std::size_t size, unsigned int seconds,
+                 bool framing = false);
+
+ private:
+  LoadGenerator() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,295 @@
+#include "MerkleHash.h"
+
+#include <openssl/evp.h>
+#ifdef __linux__
+#include <fcntl.h>   // ::open(...)
+#include <unistd.h>  // ::pread(...) ; ::close(...)
+
+#include <cerrno>  // errno
+#endif
+
+#include <algorithm>  // std::min(...) ; std::max(...)
+#include <atomic>
+#include <fstream>
+#include <memory>  // std::unique_ptr
+#include <thread>
+#include <utility>  // std::move
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// the prefixes of RFC 6962, so a leaf can not be taken for a node
+static const unsigned char LEAF_PREFIX = 0x00;
+static const unsigned char NODE_PREFIX = 0x01;
+
+/**
+ * Returns the size of the file or -1 if it can not be opened.
+ */
+static long long readFileSize(const std::string &fileName) {
+  std::ifstream file(fileName.c_str(),
+                     std::ifstream::binary | std::ifstream::ate);
+  if (!file.is_open()) {
+    return -1;
+  }
+  return static_cast<long long>(file.tellg());
+}
+
+/**
+ * Each thread opens the file itself. On Linux the leaves are read with
+ * pread(), which does not use the file position, elsewhere with a stream.
+ */
+class MerkleHash::File {
+ public:  // construction/destruction/operators
+  explicit File(const std::string &fileName) {
+#ifdef __linux__
+    this->fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+    this->stream.open(fileName.c_str(), std::ifstream::binary);
+#endif
+  }
+  File(const File &) = delete;
+  File &operator=(const File &) = delete;
+  ~File() {
+#ifdef __linux__
+    if (this->fd >= 0) {
+      ::close(this->fd);
+    }
+#endif
+  }
+
+ public:  // methods
+  bool isOpen() const {
+#ifdef __linux__
+    return this->fd >= 0;
+#else
+    return this->stream.is_open();
+#endif
+  }
+
+  /**
+   * Reads exactly size bytes at the offset.
+   *
+   * @return false on an error or if the file ends before
+   */
+  bool read(unsigned long long offset, unsigned char *data,
+            std::size_t size) {
+#ifdef __linux__
+    while (size > 0) {
+      ssize_t count =
+          ::pread(this->fd, data, size, static_cast<off_t>(offset));
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        return false;
+      }
+      data += count;
+      size -= static_cast<std::size_t>(count);
+      offset += static_cast<unsigned long long>(count);
+    }
+    return true;
+#else
+    this->stream.clear();
+    this->stream.seekg(static_cast<std::streamoff>(offset));
+    this->stream.read(reinterpret_cast<char *>(data),
+                      static_cast<std::streamsize>(size));
+    return static_cast<std::size_t>(this->stream.gcount()) == size;
+#endif
+  }
+
+ private:  // fields
+#ifdef __linux__
+  int fd;
+#else
+  std::ifstream stream;
+#endif
+};
+
+MerkleHash::MerkleHash(std::size_t leafSize)
+    : leafSize{std::max<std::size_t>(1, leafSize)}, fileSize{0} {}
+
+bool MerkleHash::hashLeaf(const unsigned char *data, std::size_t size,
+                          Digest &digest) {
+  std::unique_ptr<::EVP_MD_CTX, decltype(&::EVP_MD_CTX_free)> context(
+      ::EVP_MD_CTX_new(), &::EVP_MD_CTX_free);
+  return context &&
+         ::EVP_DigestInit_ex(context.get(), ::EVP_sha256(), nullptr) == 1 &&
+         ::EVP_DigestUpdate(context.get(), &LEAF_PREFIX, 1) == 1 &&
+         ::EVP_DigestUpdate(context.get(), data, size) == 1 &&
+         ::EVP_DigestFinal_ex(context.get(), digest.data(), nullptr) == 1;
+}
+
+bool MerkleHash::hashNode(const Digest &left, const Digest &right,
+                          Digest &digest) {
+  unsigned char node[1 + 2 * SHA256_DIGEST_LENGTH];
+  node[0] = NODE_PREFIX;
+  std::copy(left.begin(), left.end(), node + 1);
+  std::copy(right.begin(), right.end(), node + 1 + left.size());
+  return ::EVP_Digest(node, sizeof(node), digest.data(), nullptr,
+                      ::EVP_sha256(), nullptr) == 1;
+}
+
+bool MerkleHash::readLeaf(File &file, std::size_t index,
+                          std::vector<unsigned char> &buffer,
+                          Digest &digest) const {
+  unsigned long long begin =
+      static_cast<unsigned long long>(index) * this->leafSize;
+  std::size_t size = static_cast<std::size_t>(
+      std::min<unsigned long long>(this->leafSize, this->fileSize - begin));
+  buffer.resize(size);
+  return file.read(begin, buffer.data(), size) &&
+         MerkleHash::hashLeaf(buffer.data(), size, digest);
+}
+
+/**
+ * The leaves are large, so each thread takes one leaf at once.
+ */
+bool MerkleHash::hashFile(const std::string &fileName, unsigned int threads) {
+  this->levels.clear();
+  long long size = readFileSize(fileName);
+  if (size < 0) {
+    return false;
+  }
+  this->fileSize = static_cast<unsigned long long>(size);
+  std::size_t count = static_cast<std::size_t>(
+      (this->fileSize + this->leafSize - 1) / this->leafSize);
+  std::vector<Digest> leaves(count);
+  if (count == 0) {
+    // RFC 6962 defines the hash of an empty list as SHA-256 of nothing
+    Digest root = {};
+    if (::EVP_Digest(nullptr, 0, root.data(), nullptr, ::EVP_sha256(),
+                     nullptr) != 1) {
+      return false;
+    }
+    this->levels.push_back(std::move(leaves));
+    this->levels.push_back(std::vector<Digest>(1, root));
+    return true;
+  }
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = static_cast<unsigned int>(std::min<std::size_t>(threads, count));
+  std::atomic<std::size_t> next{0};
+  std::atomic_bool failed{false};
+  auto work = [&]() {
+    File file(fileName);
+    if (!file.isOpen()) {
+      failed = true;
+      return;
+    }
+    std::vector<unsigned char> buffer;
+    for (std::size_t i = next++; i < count && !failed; i = next++) {
+      if (!this->readLeaf(file, i, buffer, leaves[i])) {
+        failed = true;
+      }
+    }
+  };
+  // the calling thread is one of the workers
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; i++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  if (failed) {
+    return false;
+  }
+  this->levels.push_back(std::move(leaves));
+  if (!this->buildTree()) {
+    this->levels.clear();
+    return false;
+  }
+  return true;
+}
+
+bool MerkleHash::buildTree() {
+  while (this->levels.back().size() > 1) {
+    const std::vector<Digest> &lower = this->levels.back();
+    std::vector<Digest> upper((lower.size() + 1) / 2);
+    for (std::size_t i = 0; i < upper.size(); i++) {
+      if (2 * i + 1 >= lower.size()) {
+        upper[i] = lower[2 * i];
+      } else if (!MerkleHash::hashNode(lower[2 * i], lower[2 * i + 1],
+                                       upper[i])) {
+        return false;
+      }
+    }
+    this->levels.push_back(std::move(upper));
+  }
+  return true;
+}
+
+/**
+ * Only the nodes on the path of the leaf change, so the update hashes one
+ * leaf and log2(leaves) nodes.
+ */
+bool MerkleHash::updateLeaf(const std::string &fileName, std::size_t index) {
+  if (index >= this->getLeafCount() ||
+      readFileSize(fileName) != static_cast<long long>(this->fileSize)) {
+    return false;
+  }
+  File file(fileName);
+  std::vector<unsigned char> buffer;
+  Digest digest;
+  if (!file.isOpen() || !this->readLeaf(file, index, buffer, digest)) {
+    return false;
+  }
+  // the path is hashed before it is stored, so a failure keeps the tree
+  std::vector<Digest> path(1, digest);
+  for (std::size_t level = 0, i = index; level + 1 < this->levels.size();
+       level++, i /= 2) {
+    const std::vector<Digest> &lower = this->levels[level];
+    std::size_t sibling = i ^ 1;
+    if (sibling >= lower.size()) {
+      path.push_back(path.back());
+    } else if (!MerkleHash::hashNode(i & 1 ? lower[sibling] : path.back(),
+                                     i & 1 ? path.back() : lower[sibling],
+                                     digest)) {
+      return false;
+    } else {
+      path.push_back(digest);
+    }
+  }
+  for (std::size_t level = 0; level < path.size(); level++, index /= 2) {
+    this->levels[level][index] = path[level];
+  }
+  return true;
+}
+
+bool MerkleHash::verifyLeaf(const std::string &fileName,
+                            std::size_t index) const {
+  if (index >= this->getLeafCount() ||
+      readFileSize(fileName) != static_cast<long long>(this->fileSize)) {
+    return false;
+  }
+  File file(fileName);
+  std::vector<unsigned char> buffer;
+  Digest digest;
+  return file.isOpen() && this->readLeaf(file, index, buffer, digest) &&
+         digest == this->levels[0][index];
+}
+
+const MerkleHash::Digest &MerkleHash::getRoot() const {
+  static const Digest empty = {};
+  return this->levels.empty() ? empty : this->levels.back()[0];
+}
+
+const MerkleHash::Digest &MerkleHash::getLeaf(std::size_t index) const {
+  return this->levels[0][index];
+}
+
+std::size_t MerkleHash::getLeafCount() const {
+  return this->levels.empty() ? 0 : this->levels[0].size();
+}
+
+std::size_t MerkleHash::getLeafSize() const { return this->leafSize; }
+
+unsigned long long MerkleHash::getFileSize() const { return this->fileSize; }
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
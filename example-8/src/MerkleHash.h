@@ -0,0 +1,140 @@
+#pragma once
+
+#include <openssl/sha.h>  // SHA256_DIGEST_LENGTH
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * A SHA-256 tree hash of a file. The file is split into leaves of a fixed
+ * size, which are hashed concurrently, so the throughput scales with the
+ * number of cores. The tree is kept, so a single leaf can be verified or
+ * updated without hashing the whole file again.
+ *
+ * The root is the Merkle Tree Hash of RFC 6962 over the leaves:
+ *   leaf i = SHA-256(0x00 || bytes [i * leafSize, (i + 1) * leafSize))
+ *   node   = SHA-256(0x01 || left || right)
+ * The nodes of a level are paired from left to right. An odd last node is
+ * moved to the next level unchanged. An empty file has no leaves and its root
+ * is SHA-256 of the empty string. The root depends on the leaf size, so
+ * roots are only comparable for the same leaf size, and it differs from the
+ * SHA-256 of the file.
+ */
+class MerkleHash {
+ public:  // type definitions
+  typedef std::array<unsigned char, SHA256_DIGEST_LENGTH> Digest;
+
+ public:  // const
+  // default size of a leaf (4 MiB)
+  static const std::size_t DEFAULT_LEAF_SIZE = 4 * 1024 * 1024;
+
+ public:  // construction/destruction/operators
+  /**
+   * @param leafSize the number of bytes of each leaf, at least 1
+   */
+  explicit MerkleHash(std::size_t leafSize = DEFAULT_LEAF_SIZE);
+  /**
+   * Move constructor
+   */
+  MerkleHash(MerkleHash &&) = default;
+  /**
+   * Move assignment operator
+   */
+  MerkleHash &operator=(MerkleHash &&) = default;
+  /**
+   * Copy constructor
+   */
+  MerkleHash(const MerkleHash &) = default;
+  /**
+   * Copy assignment operator
+   */
+  MerkleHash &operator=(const MerkleHash &) = default;
+  /**
+   * Destructor
+   */
+  ~MerkleHash() = default;
+
+ public:  // methods
+  /**
+   * Hashes all leaves of the file and builds the tree.
+   *
+   * @param threads the number of threads, 0 uses one per CPU core
+   * @return false if the file could not be read or hashed
+   */
+  bool hashFile(const std::string &fileName, unsigned int threads = 0);
+  /**
+   * Hashes the leaf of the file again and updates the nodes from the leaf to
+   * the root. The size of the file must not have changed.
+   *
+   * @return false if the file could not be read or hashed or its size has
+   * changed, the tree is unchanged then
+   */
+  bool updateLeaf(const std::string &fileName, std::size_t index);
+  /**
+   * Returns true if the leaf of the file matches the hash of the tree.
+   */
+  bool verifyLeaf(const std::string &fileName, std::size_t index) const;
+
+  /**
+   * Returns the root of the tree. The root is only valid after hashFile()
+   * returned true.
+   */
+  const Digest &getRoot() const;
+  const Digest &getLeaf(std::size_t index) const;
+  std::size_t getLeafCount() const;
+  std::size_t getLeafSize() const;
+  unsigned long long getFileSize() const;
+
+  /**
+   * Hashes the bytes of a leaf.
+   *
+   * @return false if OpenSSL failed, the digest is undefined then
+   */
+  static bool hashLeaf(const unsigned char *data, std::size_t size,
+                       Digest &digest);
+  /**
+   * Hashes two child nodes.
+   *
+   * @return false if OpenSSL failed, the digest is undefined then
+   */
+  static bool hashNode(const Digest &left, const Digest &right,
+                       Digest &digest);
+
+ private:  // type definitions
+  /**
+   * A file opened for reading leaves at their offset.
+   */
+  class File;
+
+ private:  // helper methods
+  /**
+   * Reads the leaf of the file and hashes it.
+   */
+  bool readLeaf(File &file, std::size_t index,
+                std::vector<unsigned char> &buffer, Digest &digest) const;
+  /**
+   * Builds the levels above the leaves.
+   *
+   * @return false if a node could not be hashed
+   */
+  bool buildTree();
+
+ private:  // fields
+  std::size_t leafSize;
+  unsigned long long fileSize;
+  /**
+   * The leaves are the first level and the root is the only node of the
+   * last level. For an empty file the first level is empty.
+   */
+  std::vector<std::vector<Digest>> levels;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -1,11 +1,20 @@
 #include "OpenSslWrapper.h"
 
+#include <openssl/ec.h>   // EVP_PKEY_CTX_set_ec_paramgen_curve_nid(...)
 #include <openssl/err.h>
-
+#include <openssl/evp.h>
+#include <openssl/rsa.h>  // EVP_PKEY_CTX_set_rsa_keygen_bits(...)
+#ifndef _WIN32
+#include <poll.h>  // ::poll(...) ; pollfd ; POLLIN ; POLLOUT
+#endif
+
+#include <algorithm>  // std::min ; std::max
+#include <atomic>
 #include <cstdio>  // fopen fclose
 #include <functional>
 #include <iostream>
-#include <thread>  // std::this_thread
+#include <thread>   // std::this_thread
+#include <utility>  // std::move
 #include <vector>
 namespace ggolbik {
 namespace cpp {
@@ -100,6 +109,14 @@ bool OpenSslWrapper::configureTlsContext(::SSL_CTX *ctx,
     return false;
   }
 
+  // OpenSSL drops a key which does not match the certificate. A reloaded pair
+  // might be written only partially.
+  if (::SSL_CTX_check_private_key(ctx) != 1) {
+    std::cerr << "Private key does not match the certificate." << std::endl;
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
+
   return true;
 }
 
@@ -135,8 +152,54 @@ bool OpenSslWrapper::configureTlsContext(::SSL_CTX *ctx,
   return ssl;
 }
 
+::SSL *OpenSslWrapper::createTlsServer(::SSL_CTX *ctx, int socket) {
+  ::SSL *ssl = ::SSL_new(ctx);
+  if (ssl == nullptr) {
+    ::ERR_print_errors_fp(stderr);
+    return nullptr;
+  }
+  if (::SSL_set_fd(ssl, socket) != 1) {
+    ::SSL_free(ssl);
+    return nullptr;
+  }
+  // SSL_do_handshake() acts as server
+  ::SSL_set_accept_state(ssl);
+  return ssl;
+}
+
 ::SSL *OpenSslWrapper::connectTls(::SSL_CTX *ctx, int socket) {
+  return OpenSslWrapper::connectTls(ctx, socket, nullptr);
+}
+
+/**
+ * Waits until the socket is ready for the direction the handshake waits for.
+ * The wait is limited to 100ms.
+ */
+static void waitForHandshake(int socket, int error) {
+#ifdef _WIN32
+  (void)socket;
+  (void)error;
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+#else
+  pollfd pollFd = {};
+  pollFd.fd = socket;
+  pollFd.events = error == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN;
+  ::poll(&pollFd, 1, 100);
+#endif
+}
+
+/**
+ * SSL_set_session() sets the session to be used when the TLS connection is
+ * established. The session must have been established by a context with the
+ * same method. SSL_session_reused() tells whether the server accepted it.
+ */
+::SSL *OpenSslWrapper::connectTls(::SSL_CTX *ctx, int socket,
+                                  ::SSL_SESSION *session) {
   ::SSL *ssl = ::SSL_new(ctx);
+  if (ssl == nullptr) {
+    ::ERR_print_errors_fp(stderr);
+    return nullptr;
+  }
   // SSL_set_fd() sets the file descriptor fd as the input/output facility for
   // the TLS/SSL (encrypted) side of ssl. fd will typically be the socket file
   // descriptor of a network connection.
@@ -144,6 +207,10 @@ bool OpenSslWrapper::configureTlsContext(::SSL_CTX *ctx,
     ::SSL_free(ssl);
     return nullptr;
   }
+  if (session != nullptr && ::SSL_set_session(ssl, session) != 1) {
+    // continue with a full handshake
+    ::ERR_clear_error();
+  }
   int rc = 0;
   do {
     rc = ::SSL_connect(ssl);
@@ -152,7 +219,7 @@ bool OpenSslWrapper::configureTlsContext(::SSL_CTX *ctx,
       switch (error) {
         case SSL_ERROR_WANT_READ:
         case SSL_ERROR_WANT_WRITE:
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+          waitForHandshake(socket, error);
           break;
         default:
           ::perror("Unable to establish tls connection.");
@@ -167,6 +234,70 @@ bool OpenSslWrapper::configureTlsContext(::SSL_CTX *ctx,
   return ssl;
 }
 
+/**
+ * The server keeps the sessions in an internal cache. Clients which do not
+ * support tickets resume with the session ID. TLS 1.3 tickets are stateless
+ * and do not use the cache.
+ *
+ * The method calls
+ *   long SSL_CTX_set_session_cache_mode(SSL_CTX ctx, long mode);
+ *   long SSL_CTX_sess_set_cache_size(SSL_CTX *ctx, long t);
+ *   int SSL_CTX_set_session_id_context(SSL_CTX *ctx, const unsigned char
+ * *sid_ctx, unsigned int sid_ctx_len);
+ * are defined in header <openssl/ssl.h>
+ */
+bool OpenSslWrapper::configureSessionCache(::SSL_CTX *ctx, long size) {
+  static const unsigned char sessionIdContext[] = "ggolbik-tls-server";
+  if (::SSL_CTX_set_session_id_context(ctx, sessionIdContext,
+                                       sizeof(sessionIdContext) - 1) != 1) {
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+  // OpenSSL removes the session of a connection which fails from the cache.
+  // Many clients close the socket without a close_notify alert, which is not
+  // an error for the echo protocol.
+  ::SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+  if (size <= 0) {
+    ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    return true;
+  }
+  ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+  // the oldest sessions are removed if the cache is full
+  ::SSL_CTX_sess_set_cache_size(ctx, size);
+  return true;
+}
+
+/**
+ * With SSL_OP_ENABLE_KTLS OpenSSL tries to configure kTLS on the socket at the
+ * end of the handshake and silently falls back to user-space TLS if this
+ * fails.
+ */
+bool OpenSslWrapper::enableKtls(::SSL_CTX *ctx) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  ::SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+  return true;
+#else
+  (void)ctx;
+  return false;
+#endif
+}
+
+/**
+ * The method call
+ *   int BIO_get_ktls_send(BIO *b);
+ * is defined in header <openssl/bio.h>
+ */
+bool OpenSslWrapper::isKtlsSendActive(::SSL *ssl) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  return BIO_get_ktls_send(::SSL_get_wbio(ssl)) == 1;
+#else
+  (void)ssl;
+  return false;
+#endif
+}
+
 void OpenSslWrapper::displayCert(const TlsX509Cert &cert) {
   if (cert) {
     ::BIO *bio_out = ::BIO_new_fp(stdout, BIO_NOCLOSE);
@@ -216,53 +347,125 @@ void OpenSslWrapper::displayCertsSimple(::SSL *ssl) {
   }
 }
 
-bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
-                                          const std::string &certFileName,
-                                          const std::string &password) {
-  // Before we can actually create a certificate, we need to create a private
-  // key. OpenSSL provides the EVP_PKEY structure for storing an
-  // algorithm-independent private key in memory.
-  // In order to allocate an EVP_PKEY structure, we use EVP_PKEY_new
-  // There is also a corresponding function for freeing the structure -
-  // EVP_PKEY_free
-  ::EVP_PKEY *pkey = ::EVP_PKEY_new();
-  if (pkey == nullptr) {
+bool OpenSslWrapper::parseKeyAlgorithm(const std::string &name,
+                                       KeyAlgorithm &algorithm) {
+  if (name == "rsa2048") {
+    algorithm = KeyAlgorithm::Rsa2048;
+  } else if (name == "rsa3072") {
+    algorithm = KeyAlgorithm::Rsa3072;
+  } else if (name == "rsa4096") {
+    algorithm = KeyAlgorithm::Rsa4096;
+  } else if (name == "p256") {
+    algorithm = KeyAlgorithm::EcdsaP256;
+  } else if (name == "p384") {
+    algorithm = KeyAlgorithm::EcdsaP384;
+  } else if (name == "ed25519") {
+    algorithm = KeyAlgorithm::Ed25519;
+  } else {
     return false;
   }
+  return true;
+}
+
+std::string OpenSslWrapper::getKeyAlgorithmName(KeyAlgorithm algorithm) {
+  switch (algorithm) {
+    case KeyAlgorithm::Rsa2048:
+      return "rsa2048";
+    case KeyAlgorithm::Rsa3072:
+      return "rsa3072";
+    case KeyAlgorithm::Rsa4096:
+      return "rsa4096";
+    case KeyAlgorithm::EcdsaP256:
+      return "p256";
+    case KeyAlgorithm::EcdsaP384:
+      return "p384";
+    case KeyAlgorithm::Ed25519:
+      return "ed25519";
+  }
+  return "";
+}
+
+/**
+ * The key is generated with an EVP_PKEY_CTX of the key type. The parameters of
+ * the type (RSA modulus size, EC curve) are set on the context before
+ * EVP_PKEY_keygen() is called.
+ */
+bool OpenSslWrapper::generateKey(KeyAlgorithm algorithm, TlsKey &key) {
+  int type = EVP_PKEY_RSA;
+  if (algorithm == KeyAlgorithm::EcdsaP256 ||
+      algorithm == KeyAlgorithm::EcdsaP384) {
+    type = EVP_PKEY_EC;
+  } else if (algorithm == KeyAlgorithm::Ed25519) {
+    type = EVP_PKEY_ED25519;
+  }
 
-  // An exponent for the key is also needed, which will require allocating a
-  // BIGNUM with BN_new and then assigning with BN_set_word:
-  ::BIGNUM *bn;
-  bn = ::BN_new();
-  ::BN_set_word(bn, RSA_F4);
+  TlsKeyContext ctx = TlsKeyContext(::EVP_PKEY_CTX_new_id(type, NULL));
+  if (!ctx || ::EVP_PKEY_keygen_init(ctx.get()) != 1) {
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
 
-  // Now we need to generate a key.
-  // This is done with the RSA_generate_key
-  ::RSA *rsa = RSA_new();
-  if (rsa == nullptr) {
-    ::EVP_PKEY_free(pkey);
+  int rc = 1;
+  switch (algorithm) {
+    case KeyAlgorithm::Rsa2048:
+      rc = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), 2048);
+      break;
+    case KeyAlgorithm::Rsa3072:
+      rc = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), 3072);
+      break;
+    case KeyAlgorithm::Rsa4096:
+      rc = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), 4096);
+      break;
+    case KeyAlgorithm::EcdsaP256:
+      rc = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(),
+                                                  NID_X9_62_prime256v1);
+      break;
+    case KeyAlgorithm::EcdsaP384:
+      rc = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(), NID_secp384r1);
+      break;
+    case KeyAlgorithm::Ed25519:
+      break;
+  }
+  if (rc > 0 && type == EVP_PKEY_EC) {
+    // the certificate names the curve instead of containing its parameters
+    rc = EVP_PKEY_CTX_set_ec_param_enc(ctx.get(), OPENSSL_EC_NAMED_CURVE);
+  }
+  if (rc <= 0) {
+    ::ERR_print_errors_fp(stderr);
     return false;
   }
-  if (::RSA_generate_key_ex(
-          rsa,  /* pointer to the RSA structure */
-          2048, /* number of bits for the key - 2048 is a good value */
-          bn,   /* exponent allocated earlier */
-          NULL  /* callback - can be NULL if progress isn't needed */
-          ) != 1) {
-    ::RSA_free(rsa);
-    ::EVP_PKEY_free(pkey);
+
+  ::EVP_PKEY *pkey = nullptr;
+  if (::EVP_PKEY_keygen(ctx.get(), &pkey) != 1) {
+    ::ERR_print_errors_fp(stderr);
     return false;
   }
+  key.reset(pkey);
+  return true;
+}
 
-  // now we have an RSA key, and we can assign it to our EVP_PKEY structure from
-  // earlier The RSA structure will be automatically freed when the EVP_PKEY
-  // structure is freed.
-  EVP_PKEY_assign_RSA(pkey, rsa);
+const ::EVP_MD *OpenSslWrapper::getSignatureDigest(const TlsKey &key) {
+  switch (::EVP_PKEY_base_id(key.get())) {
+    case EVP_PKEY_ED25519:
+      return nullptr;
+    case EVP_PKEY_EC:
+      if (::EVP_PKEY_bits(key.get()) > 256) {
+        return ::EVP_sha384();
+      }
+      return ::EVP_sha256();
+    default:
+      return ::EVP_sha256();
+  }
+}
 
-  // Now for the certificate itself.
+bool OpenSslWrapper::createSelfSignedCert(const TlsKey &key,
+                                          TlsX509Cert &cert) {
   // OpenSSL uses the X509 structure to represent an x509 certificate in memory.
   // there is a corresponding function for freeing the structure - X509_free.
-  X509 *x509 = ::X509_new();
+  TlsX509Cert x509 = TlsX509Cert(::X509_new());
+  if (!x509) {
+    return false;
+  }
 
   // Now we need to set a few properties of the certificate using some X509_*
   // functions:
@@ -270,25 +473,25 @@ bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
   // This sets the serial number of our certificate to '1'.
   // Some open-source HTTP servers refuse to accept a certificate with a serial
   // number of '0', which is the default
-  ::ASN1_INTEGER_set(::X509_get_serialNumber(x509), 1);
+  ::ASN1_INTEGER_set(::X509_get_serialNumber(x509.get()), 1);
 
   // The next step is to specify the span of time during which the certificate
   // is actually valid. sets the certificate's notBefore property to the current
   // time. (The X509_gmtime_adj function adds the specified number of seconds to
   // the current time - in this case none.)
-  ::X509_gmtime_adj(X509_get_notBefore(x509), 0);
+  ::X509_gmtime_adj(X509_get_notBefore(x509.get()), 0);
   // sets the certificate's notAfter property to 365 days from now (60 seconds *
   // 60 minutes * 24 hours * 365 days).
-  ::X509_gmtime_adj(X509_get_notAfter(x509), 31536000L);
+  ::X509_gmtime_adj(X509_get_notAfter(x509.get()), 31536000L);
 
   // Now we need to set the public key for our certificate using the key we
   // generated earlier
-  ::X509_set_pubkey(x509, pkey);
+  ::X509_set_pubkey(x509.get(), key.get());
 
   // Since this is a self-signed certificate, we set the name of the issuer to
   // the name of the subject. The first step in that process is to get the
   // subject name:
-  X509_NAME *name = ::X509_get_subject_name(x509);
+  X509_NAME *name = ::X509_get_subject_name(x509.get());
   // country code
   ::X509_NAME_add_entry_by_txt(name, "C", MBSTRING_ASC, (unsigned char *)"CA",
                                -1, -1, 0);
@@ -299,11 +502,36 @@ bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
   ::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
                                (unsigned char *)"localhost", -1, -1, 0);
   // Now we can actually set the issuer name:
-  ::X509_set_issuer_name(x509, name);
+  ::X509_set_issuer_name(x509.get(), name);
 
   // And finally we are ready to perform the signing process.
-  // We call X509_sign with the key we generated earlier.
-  ::X509_sign(x509, pkey, EVP_sha256());
+  // We call X509_sign with the key. Ed25519 signs without a separate digest.
+  if (::X509_sign(x509.get(), key.get(),
+                  OpenSslWrapper::getSignatureDigest(key)) <= 0) {
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
+
+  cert = std::move(x509);
+  return true;
+}
+
+bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
+                                          const std::string &certFileName,
+                                          const std::string &password,
+                                          KeyAlgorithm algorithm) {
+  // Before we can actually create a certificate, we need to create a private
+  // key. OpenSSL provides the EVP_PKEY structure for storing an
+  // algorithm-independent private key in memory.
+  TlsKey pkey = {};
+  if (!OpenSslWrapper::generateKey(algorithm, pkey)) {
+    return false;
+  }
+
+  TlsX509Cert x509 = {};
+  if (!OpenSslWrapper::createSelfSignedCert(pkey, x509)) {
+    return false;
+  }
 
   // We now have a self-signed certificate! But we're not done yet - we need to
   // write these files out to disk.
@@ -312,8 +540,6 @@ bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
   //  key.
   ::FILE *keyFile = ::fopen(keyFileName.c_str(), "wb");
   if (keyFile == nullptr) {
-    ::X509_free(x509);
-    ::EVP_PKEY_free(pkey);
     return false;
   }
 
@@ -323,14 +549,13 @@ bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
   int passphraseLen = -1;
   const EVP_CIPHER *cipher = NULL;
   if (!password.empty()) {
-    passphrase = new unsigned char[password.size()];
-    password.empty() ? NULL : password.c_str();
+    passphrase = (unsigned char *)password.c_str();
     passphraseLen = password.size();
     cipher = EVP_des_ede3_cbc();
   }
   if (::PEM_write_PrivateKey(
           keyFile,    /* write the key to the file we've opened */
-          pkey,       /* our key from earlier */
+          pkey.get(), /* our key from earlier */
           cipher,     /* default cipher for encrypting the key on disk */
           passphrase, /* passphrase required for decrypting the key on disk */
           passphraseLen, /* length of the passphrase string */
@@ -339,39 +564,28 @@ bool OpenSslWrapper::createSelfSignedCert(const std::string &keyFileName,
           ) != 1) {
     ::fclose(keyFile);
     std::remove(keyFileName.c_str());
-    ::X509_free(x509);
-    ::EVP_PKEY_free(pkey);
     return false;
   }
   ::fclose(keyFile);
   keyFile = NULL;
-  if (passphrase != NULL) {
-    delete[] passphrase;
-  }
 
   // we need to write the certificate out to disk. The function we need for this
   // is PEM_write_X509:
   FILE *certFile = ::fopen(certFileName.c_str(), "wb");
   if (certFile == nullptr) {
-    ::X509_free(x509);
-    ::EVP_PKEY_free(pkey);
     return false;
   }
   if (::PEM_write_X509(
-          certFile, /* write the certificate to the file we've opened */
-          x509      /* our certificate */
+          certFile,  /* write the certificate to the file we've opened */
+          x509.get() /* our certificate */
           ) != 1) {
     ::fclose(certFile);
     std::remove(keyFileName.c_str());
     std::remove(certFileName.c_str());
-    ::X509_free(x509);
-    ::EVP_PKEY_free(pkey);
     return false;
   }
   ::fclose(certFile);
 
-  ::X509_free(x509);
-  ::EVP_PKEY_free(pkey);
   return true;
 }
 
@@ -444,29 +658,26 @@ bool OpenSslWrapper::signData(TlsKey &key, const std::string &msg,
     return false;
   }
 
-  /* Initialise the DigestSign operation - SHA-256 has been selected
-   * as the message digest function in this example */
-  if (1 != ::EVP_DigestSignInit(mdctx.get(), NULL, ::EVP_sha256(), NULL,
+  /* Initialise the DigestSign operation with the digest of the key type.
+   * Ed25519 uses no separate digest. */
+  if (1 != ::EVP_DigestSignInit(mdctx.get(), NULL,
+                                OpenSslWrapper::getSignatureDigest(key), NULL,
                                 key.get())) {
     return false;
   }
 
-  /* Call update with the message */
-  if (1 != ::EVP_DigestUpdate(mdctx.get(), msg.c_str(), msg.size())) {
-    return false;
-  }
-
-  /* Finalise the DigestSign operation */
-  /* First call EVP_DigestSignFinal with a NULL sig parameter to
-   * obtain the length of the signature. Length is returned in slen */
-  if (1 != ::EVP_DigestSignFinal(mdctx.get(), NULL, &slen)) {
+  /* Ed25519 does not support EVP_DigestUpdate, so the message is signed with
+   * the one-shot EVP_DigestSign. First call it with a NULL sig parameter to
+   * obtain the max length of the signature. Length is returned in slen */
+  if (1 != ::EVP_DigestSign(mdctx.get(), NULL, &slen,
+                            (const unsigned char *)msg.c_str(), msg.size())) {
     return false;
   }
   /* Allocate memory for the signature based on size in slen */
   std::vector<char> sig(slen);
   /* Obtain the signature */
-  if (1 !=
-      ::EVP_DigestSignFinal(mdctx.get(), (unsigned char *)sig.data(), &slen)) {
+  if (1 != ::EVP_DigestSign(mdctx.get(), (unsigned char *)sig.data(), &slen,
+                            (const unsigned char *)msg.c_str(), msg.size())) {
     return false;
   }
   // copy data
@@ -476,23 +687,22 @@ bool OpenSslWrapper::signData(TlsKey &key, const std::string &msg,
 }
 
 /**
- * @brief
+ * Resolves the message digest of a signature algorithm.
  *
- * @param key the public key
- * @param msg input data
- * @param signature signed data
- * @param algorithm the used algorithm e.g. RS256, RS512, HS256, HS512
- * @return
+ * @param algorithm the used algorithm e.g. RS256, RS512, HS256, HS512, ES256,
+ * ES384, EdDSA. If empty, the digest of the key type is used like in signData.
+ * @param messageDigest NULL for EdDSA
+ * @return false if the algorithm is unknown
  */
-bool OpenSslWrapper::verifySignedData(TlsKey &key, const std::string &msg,
-                                      const std::string &signature,
-                                      const std::string &algorithm) {
+static bool getVerifyDigest(const OpenSslWrapper::TlsKey &key,
+                            const std::string &algorithm,
+                            const ::EVP_MD *&messageDigest) {
   // Get openssl impl
   // EVP_MD see https://www.openssl.org/docs/manmaster/man3/EVP_DigestInit.html
   // EVP_get_digestbyname see
   // https://www.openssl.org/docs/man1.0.2/man3/EVP_md5.html
-  const ::EVP_MD *messageDigest = ::EVP_sha256();
-  if (algorithm == "RS256" || algorithm == "HS256") {
+  messageDigest = OpenSslWrapper::getSignatureDigest(key);
+  if (algorithm == "RS256" || algorithm == "HS256" || algorithm == "ES256") {
     // RS256 (RSA Signature with SHA-256)
     // HS256 (HMAC with SHA-256)
     messageDigest = ::EVP_get_digestbyname("SHA256");
@@ -500,10 +710,36 @@ bool OpenSslWrapper::verifySignedData(TlsKey &key, const std::string &msg,
     // RS512 (RSA Signature with SHA-512)
     // HS512 (HMAC with SHA-512)
     messageDigest = ::EVP_get_digestbyname("SHA512");
+  } else if (algorithm == "ES384") {
+    // ES384 (ECDSA with P-384 and SHA-384)
+    messageDigest = ::EVP_get_digestbyname("SHA384");
+  } else if (algorithm == "EdDSA") {
+    // EdDSA (Ed25519 hashes the message itself)
+    messageDigest = nullptr;
   } else if (!algorithm.empty()) {
     messageDigest = EVP_get_digestbyname(algorithm.c_str());
+    if (messageDigest == nullptr) {
+      return false;
+    }
   }
-  if (messageDigest == nullptr) {
+  return true;
+}
+
+/**
+ * @brief
+ *
+ * @param key the public key
+ * @param msg input data
+ * @param signature signed data
+ * @param algorithm the used algorithm e.g. RS256, RS512, HS256, HS512, ES256,
+ * ES384, EdDSA. If empty, the digest of the key type is used like in signData.
+ * @return
+ */
+bool OpenSslWrapper::verifySignedData(TlsKey &key, const std::string &msg,
+                                      const std::string &signature,
+                                      const std::string &algorithm) {
+  const ::EVP_MD *messageDigest = nullptr;
+  if (!getVerifyDigest(key, algorithm, messageDigest)) {
     return false;
   }
 
@@ -513,31 +749,164 @@ bool OpenSslWrapper::verifySignedData(TlsKey &key, const std::string &msg,
     return false;
   }
 
-  // Initialise the DigestVerify operation - SHA-256 has been selected as the
-  // message digest function in this example
+  // Initialise the DigestVerify operation with the selected message digest
   if (1 != ::EVP_DigestVerifyInit(mdctx.get(), NULL, messageDigest, NULL,
                                   key.get())) {
     return false;
   }
 
-  /* Call update with the message */
-  if (1 != ::EVP_DigestVerifyUpdate(mdctx.get(), msg.c_str(), msg.size())) {
+  /* Ed25519 does not support EVP_DigestVerifyUpdate, so the signature is
+   * verified with the one-shot EVP_DigestVerify */
+  if (1 != ::EVP_DigestVerify(mdctx.get(),
+                              (const unsigned char *)signature.c_str(),
+                              signature.size(),
+                              (const unsigned char *)msg.c_str(), msg.size())) {
     return false;
   }
 
-  /* Finalise the _DigestVerify operation */
-  if (1 != ::EVP_DigestVerifyFinal(mdctx.get(),
-                                   (unsigned char *)signature.c_str(),
-                                   signature.size())) {
-    return false;
+  // ::EVP_DigestVerifyInit
+  // ::EVP_DigestVerify
+  return true;
+}
+
+// the number of messages a thread takes at once in a batch
+static const std::size_t BATCH_CHUNK_SIZE = 32;
+
+/**
+ * Runs the work function with the given number of threads. Each thread
+ * creates its own contexts and takes chunks of items with takeBatchChunk(),
+ * so a slow thread does not delay the others.
+ */
+static void runBatch(std::size_t count, unsigned int threads,
+                     const std::function<void()> &work) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::size_t chunks = (count + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+  if (threads > chunks) {
+    threads = static_cast<unsigned int>(std::max<std::size_t>(1, chunks));
+  }
+  // the calling thread is one of the workers
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; i++) {
+    workers.emplace_back(work);
   }
+  work();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
 
-  // ::EVP_DigestVerifyInit
-  // ::EVP_DigestVerifyUpdate
-  // ::EVP_DigestVerifyFinal
+static bool takeBatchChunk(std::atomic<std::size_t> &next, std::size_t count,
+                           std::size_t &begin, std::size_t &end) {
+  begin = next.fetch_add(BATCH_CHUNK_SIZE);
+  if (begin >= count) {
+    return false;
+  }
+  end = std::min(begin + BATCH_CHUNK_SIZE, count);
   return true;
 }
 
+/**
+ * EVP_DigestSign and EVP_DigestVerify finalise the context, so each message
+ * uses a copy of the initialised context. Copying is cheaper than
+ * initialising, which fetches the algorithms and prepares the key.
+ */
+bool OpenSslWrapper::signDataBatch(TlsKey &key,
+                                   const std::vector<std::string> &messages,
+                                   std::vector<std::string> &signatures,
+                                   std::vector<bool> &results,
+                                   unsigned int threads) {
+  if (!key) {
+    return false;
+  }
+  const ::EVP_MD *messageDigest = OpenSslWrapper::getSignatureDigest(key);
+  std::size_t maxSize = static_cast<std::size_t>(::EVP_PKEY_size(key.get()));
+
+  signatures.assign(messages.size(), std::string());
+  // std::vector<bool> can not be written by several threads
+  std::vector<char> signedItems(messages.size(), 0);
+  std::atomic<std::size_t> next{0};
+  std::atomic_bool failed{false};
+
+  runBatch(messages.size(), threads, [&]() {
+    TlsMessageDigestContext initialised(::EVP_MD_CTX_new());
+    TlsMessageDigestContext mdctx(::EVP_MD_CTX_new());
+    if (!initialised || !mdctx ||
+        ::EVP_DigestSignInit(initialised.get(), NULL, messageDigest, NULL,
+                             key.get()) != 1) {
+      failed = true;
+      return;
+    }
+    std::vector<unsigned char> buffer(maxSize);
+    std::size_t begin;
+    std::size_t end;
+    while (takeBatchChunk(next, messages.size(), begin, end)) {
+      for (std::size_t i = begin; i < end; i++) {
+        const std::string &msg = messages[i];
+        std::size_t slen = buffer.size();
+        if (::EVP_MD_CTX_copy_ex(mdctx.get(), initialised.get()) == 1 &&
+            ::EVP_DigestSign(mdctx.get(), buffer.data(), &slen,
+                             (const unsigned char *)msg.c_str(),
+                             msg.size()) == 1) {
+          signatures[i].assign((const char *)buffer.data(), slen);
+          signedItems[i] = 1;
+        }
+      }
+    }
+  });
+
+  results.assign(signedItems.begin(), signedItems.end());
+  return !failed;
+}
+
+bool OpenSslWrapper::verifySignedDataBatch(
+    TlsKey &key, const std::vector<std::string> &messages,
+    const std::vector<std::string> &signatures, const std::string &algorithm,
+    std::vector<bool> &results, unsigned int threads) {
+  const ::EVP_MD *messageDigest = nullptr;
+  if (!key || messages.size() != signatures.size() ||
+      !getVerifyDigest(key, algorithm, messageDigest)) {
+    return false;
+  }
+
+  // std::vector<bool> can not be written by several threads
+  std::vector<char> valid(messages.size(), 0);
+  std::atomic<std::size_t> next{0};
+  std::atomic_bool failed{false};
+
+  runBatch(messages.size(), threads, [&]() {
+    TlsMessageDigestContext initialised(::EVP_MD_CTX_new());
+    TlsMessageDigestContext mdctx(::EVP_MD_CTX_new());
+    if (!initialised || !mdctx ||
+        ::EVP_DigestVerifyInit(initialised.get(), NULL, messageDigest, NULL,
+                               key.get()) != 1) {
+      failed = true;
+      return;
+    }
+    std::size_t begin;
+    std::size_t end;
+    while (takeBatchChunk(next, messages.size(), begin, end)) {
+      for (std::size_t i = begin; i < end; i++) {
+        const std::string &msg = messages[i];
+        const std::string &signature = signatures[i];
+        valid[i] =
+            ::EVP_MD_CTX_copy_ex(mdctx.get(), initialised.get()) == 1 &&
+            ::EVP_DigestVerify(mdctx.get(),
+                               (const unsigned char *)signature.c_str(),
+                               signature.size(),
+                               (const unsigned char *)msg.c_str(),
+                               msg.size()) == 1;
+      }
+    }
+    // an invalid signature leaves an error in the queue of this thread
+    ::ERR_clear_error();
+  });
+
+  results.assign(valid.begin(), valid.end());
+  return !failed;
+}
+
 }  // namespace tls
 }  // namespace cpp
 }  // namespace ggolbik
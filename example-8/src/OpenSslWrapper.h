@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace ggolbik {
 namespace cpp {
@@ -32,6 +33,15 @@ struct TlsDeleterFunctor {
   }
 };
 
+// A stateless functor
+struct TlsSessionDeleterFunctor {
+  void operator()(::SSL_SESSION *p) const {
+    if (p != nullptr) {
+      ::SSL_SESSION_free(p);
+    }
+  }
+};
+
 // A stateless functor
 struct TlsX509CertDeleterFunctor
 {
@@ -56,6 +66,18 @@ struct TlsKeyDeleterFunctor
   }
 };
 
+// A stateless functor
+struct TlsKeyContextDeleterFunctor
+{
+  void operator()(::EVP_PKEY_CTX* p) const
+  {
+    if(p != nullptr)
+    {
+      ::EVP_PKEY_CTX_free(p);
+    }
+  }
+};
+
 // A stateless functor
 struct TlsMessageDigestContextDeleterFunctor
 {
@@ -72,6 +94,7 @@ class OpenSslWrapper {
  public:
   using TlsX509Cert = std::unique_ptr<::X509, TlsX509CertDeleterFunctor>;
   using TlsKey = std::unique_ptr<::EVP_PKEY, TlsKeyDeleterFunctor>;
+  using TlsKeyContext = std::unique_ptr<::EVP_PKEY_CTX, TlsKeyContextDeleterFunctor>;
   using TlsMessageDigestContext = std::unique_ptr<::EVP_MD_CTX, TlsMessageDigestContextDeleterFunctor>;
 
  public:
@@ -83,6 +106,26 @@ class OpenSslWrapper {
    * @brief Using custom deleter with unique_ptr
    */
   using TlsPtr = std::unique_ptr<::SSL, TlsDeleterFunctor>;
+  /**
+   * @brief Using custom deleter with unique_ptr
+   */
+  using TlsSessionPtr = std::unique_ptr<::SSL_SESSION, TlsSessionDeleterFunctor>;
+
+  /**
+   * @brief The algorithm of a generated key. ECDSA and Ed25519 keys are
+   * generated in microseconds and sign much faster than RSA keys of the same
+   * strength. RSA verifies faster.
+   */
+  enum class KeyAlgorithm {
+    Rsa2048,
+    Rsa3072,
+    Rsa4096,
+    EcdsaP256,
+    EcdsaP384,
+    Ed25519
+  };
+  // the algorithm of generated keys. P-256 is supported by all TLS clients.
+  static const KeyAlgorithm DEFAULT_KEY_ALGORITHM = KeyAlgorithm::EcdsaP256;
 
   /**
    * @brief Create a Tls Context object
@@ -108,15 +151,74 @@ class OpenSslWrapper {
 
   static ::SSL *acceptTls(::SSL_CTX *ctx, int socket);
 
+  /**
+   * @brief Create a TLS object in accept state without performing the
+   * handshake. The handshake is performed by SSL_do_handshake().
+   *
+   * @return new SSL object or NULL if the creation failed.
+   */
+  static ::SSL *createTlsServer(::SSL_CTX *ctx, int socket);
+
   static ::SSL *connectTls(::SSL_CTX *ctx, int socket);
+  /**
+   * @brief Connect and try to resume the given session. A full handshake is
+   * performed if the server does not accept the session.
+   */
+  static ::SSL *connectTls(::SSL_CTX *ctx, int socket, ::SSL_SESSION *session);
+
+  /**
+   * @brief Enable the server side session cache with the given number of
+   * sessions. The session ID context must be set, so sessions are only
+   * resumed by contexts of this server.
+   */
+  static bool configureSessionCache(::SSL_CTX *ctx, long size);
+
+  /**
+   * @brief Let OpenSSL pass the keys of new connections to the kernel (kTLS),
+   * so the kernel encrypts the data written to the socket.
+   *
+   * @return false if OpenSSL has been built without kTLS support.
+   */
+  static bool enableKtls(::SSL_CTX *ctx);
+  /**
+   * @brief Returns true if the kernel encrypts the data sent on the
+   * established connection. kTLS is not used if the kernel lacks the tls
+   * module or does not support the negotiated cipher.
+   */
+  static bool isKtlsSendActive(::SSL *ssl);
 
   static void displayCerts(::SSL *ssl);
   static void displayCert(const TlsX509Cert& cert);
   static void displayCertsSimple(::SSL *ssl);
 
-  static bool createSelfSignedCert(const std::string &keyFileName,
-                                   const std::string &certFileName,
-                                   const std::string &password);
+  /**
+   * @brief Parses a key algorithm name like "rsa2048", "p256" or "ed25519".
+   */
+  static bool parseKeyAlgorithm(const std::string &name,
+                                KeyAlgorithm &algorithm);
+  static std::string getKeyAlgorithmName(KeyAlgorithm algorithm);
+
+  /**
+   * @brief Generates a new private key.
+   */
+  static bool generateKey(KeyAlgorithm algorithm, TlsKey &key);
+
+  /**
+   * @brief Returns the digest used to sign with the key: SHA-384 for P-384,
+   * SHA-256 for other RSA and ECDSA keys and NULL for Ed25519, which hashes
+   * the message itself.
+   */
+  static const ::EVP_MD *getSignatureDigest(const TlsKey &key);
+
+  /**
+   * @brief Creates a certificate for the key which is signed by the key.
+   */
+  static bool createSelfSignedCert(const TlsKey &key, TlsX509Cert &cert);
+
+  static bool createSelfSignedCert(
+      const std::string &keyFileName, const std::string &certFileName,
+      const std::string &password,
+      KeyAlgorithm algorithm = OpenSslWrapper::DEFAULT_KEY_ALGORITHM);
 
   static bool readKeyFile(const std::string& fileName, TlsKey& key, const std::string& password);
 
@@ -128,6 +230,38 @@ class OpenSslWrapper {
   static bool signData(TlsKey& key, const std::string& msg, std::string& signature);
 
   static bool verifySignedData(TlsKey& key, const std::string& msg, const std::string& signature, const std::string& algorithm);
+
+  /**
+   * @brief Signs many messages with the key. The messages are distributed on
+   * the threads in chunks. Each thread initialises a digest context with the
+   * key once and copies it for each message.
+   *
+   * @param signatures receives the signature of each message
+   * @param results receives true for each message which has been signed
+   * @param threads the number of threads, 0 uses one thread per CPU core
+   * @return false if the contexts could not be created. No message has been
+   * signed then.
+   */
+  static bool signDataBatch(TlsKey &key, const std::vector<std::string> &messages,
+                            std::vector<std::string> &signatures,
+                            std::vector<bool> &results, unsigned int threads = 0);
+
+  /**
+   * @brief Verifies many signatures with the key. The digest is resolved once
+   * and each thread reuses its contexts like signDataBatch.
+   *
+   * @param signatures the signature of the message with the same index
+   * @param results receives true for each valid signature
+   * @param threads the number of threads, 0 uses one thread per CPU core
+   * @return false if the algorithm is unknown, the number of messages and
+   * signatures differ or the contexts could not be created.
+   */
+  static bool verifySignedDataBatch(TlsKey &key,
+                                    const std::vector<std::string> &messages,
+                                    const std::vector<std::string> &signatures,
+                                    const std::string &algorithm,
+                                    std::vector<bool> &results,
+                                    unsigned int threads = 0);
 };
 }  // namespace tls
 }  // namespace cpp
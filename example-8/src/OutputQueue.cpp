@@ -0,0 +1,196 @@
+#include "OutputQueue.h"
+
+#ifndef _WIN32
+#include <openssl/err.h>
+#include <sys/uio.h>  // ::writev(...) ; iovec
+
+#include <cerrno>   // errno
+#include <cstring>  // std::memcpy(...)
+#endif
+
+#include <utility>  // std::move
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+void OutputQueue::push(BufferView view) {
+  if (view.empty()) {
+    return;
+  }
+  this->pending += view.size();
+  this->buffers.push_back(std::move(view));
+  if (this->pending >= OutputQueue::HIGH_WATERMARK) {
+    this->full = true;
+  }
+}
+
+bool OutputQueue::empty() const { return this->pending == 0; }
+
+std::size_t OutputQueue::size() const { return this->pending; }
+
+bool OutputQueue::isFull() const { return this->full; }
+
+void OutputQueue::consume(std::size_t count) {
+  while (count > 0 && this->head < this->buffers.size()) {
+    std::size_t available = this->buffers[this->head].size() - this->offset;
+    if (count < available) {
+      this->offset += count;
+      this->pending -= count;
+      break;
+    }
+    // the view has been sent completely. Release the buffer.
+    count -= available;
+    this->pending -= available;
+    this->buffers[this->head].reset();
+    this->head++;
+    this->offset = 0;
+  }
+
+  if (this->head == this->buffers.size()) {
+    this->buffers.clear();
+    this->head = 0;
+  } else if (this->head >= OutputQueue::MAX_WRITE_BUFFERS &&
+             this->head * 2 >= this->buffers.size()) {
+    // the queue is never drained completely. Drop the sent views.
+    this->buffers.erase(this->buffers.begin(),
+                        this->buffers.begin() + this->head);
+    this->head = 0;
+  }
+
+  if (this->full && this->pending <= OutputQueue::LOW_WATERMARK) {
+    this->full = false;
+  }
+}
+
+void OutputQueue::clear() {
+  this->buffers.clear();
+  this->head = 0;
+  this->offset = 0;
+  this->pending = 0;
+  this->full = false;
+#ifndef _WIN32
+  this->writeData = nullptr;
+  this->writeLength = 0;
+  this->record.reset();
+  this->blockedOnRead = false;
+#endif
+}
+
+#ifndef _WIN32
+/**
+ * writev() writes several buffers with a single system call. The data is
+ * written in the order of the array as if the buffers were concatenated.
+ *
+ * The method call
+ *   ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
+ * is defined in header <sys/uio.h>
+ */
+int OutputQueue::flush(int socket) {
+  while (!this->empty()) {
+    iovec vectors[OutputQueue::MAX_WRITE_BUFFERS];
+    unsigned int count = 0;
+    std::size_t skip = this->offset;
+    for (std::size_t i = this->head;
+         i < this->buffers.size() && count < OutputQueue::MAX_WRITE_BUFFERS;
+         i++) {
+      const BufferView &view = this->buffers[i];
+      vectors[count].iov_base = const_cast<char *>(view.data() + skip);
+      vectors[count].iov_len = view.size() - skip;
+      count++;
+      skip = 0;
+    }
+
+    ssize_t rc = ::writev(socket, vectors, static_cast<int>(count));
+    if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // the send buffer is full. Wait until the socket is writable.
+      return 0;
+    } else if (rc < 0 && errno == EINTR) {
+      // interrupted by a signal
+      continue;
+    } else if (rc < 0) {
+      return -1;
+    }
+    this->consume(static_cast<std::size_t>(rc));
+  }
+  return 1;
+}
+
+/**
+ * Each SSL_write() creates at least one TLS record, which adds a header, a MAC
+ * and padding and is encrypted separately. Views smaller than a record are
+ * copied into a single record buffer instead of being written one by one.
+ * Larger views are written directly.
+ *
+ * If SSL_write() would block it must be repeated with the same buffer and
+ * length, so the pending write is kept until it completes.
+ *
+ * The method call
+ *   int SSL_write(SSL *ssl, const void *buf, int num);
+ * is defined in header <openssl/ssl.h>
+ */
+int OutputQueue::flushTls(::SSL *ssl) {
+  this->blockedOnRead = false;
+  while (!this->empty()) {
+    if (this->writeLength == 0) {
+      const BufferView &view = this->buffers[this->head];
+      std::size_t available = view.size() - this->offset;
+      if (available >= OutputQueue::MAX_RECORD_SIZE ||
+          this->head + 1 == this->buffers.size()) {
+        // write the view without copying it
+        this->writeData = view.data() + this->offset;
+        this->writeLength = available;
+      } else {
+        // coalesce the next views into one record
+        if (!this->record) {
+          this->record = BufferPool::acquire(OutputQueue::MAX_RECORD_SIZE);
+        }
+        std::size_t length = 0;
+        std::size_t skip = this->offset;
+        for (std::size_t i = this->head; i < this->buffers.size() &&
+                                         length < OutputQueue::MAX_RECORD_SIZE;
+             i++) {
+          const BufferView &next = this->buffers[i];
+          std::size_t count = next.size() - skip;
+          if (count > OutputQueue::MAX_RECORD_SIZE - length) {
+            count = OutputQueue::MAX_RECORD_SIZE - length;
+          }
+          std::memcpy(this->record.data() + length, next.data() + skip, count);
+          length += count;
+          skip = 0;
+        }
+        this->writeData = this->record.data();
+        this->writeLength = length;
+      }
+    }
+
+    // SSL_get_error() requires an empty error queue
+    ::ERR_clear_error();
+    int rc = ::SSL_write(ssl, this->writeData,
+                         static_cast<int>(this->writeLength));
+    if (rc <= 0) {
+      int error = ::SSL_get_error(ssl, rc);
+      if (error == SSL_ERROR_WANT_WRITE) {
+        return 0;
+      } else if (error == SSL_ERROR_WANT_READ) {
+        // TLS might have to read during a write
+        this->blockedOnRead = true;
+        return 0;
+      }
+      return -1;
+    }
+
+    // the write completed. The record buffer has been copied by OpenSSL.
+    this->consume(static_cast<std::size_t>(rc));
+    this->writeData += rc;
+    this->writeLength -= static_cast<std::size_t>(rc);
+  }
+  return 1;
+}
+
+bool OutputQueue::wantsRead() const { return this->blockedOnRead; }
+#endif
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
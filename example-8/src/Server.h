@@ -9,9 +9,17 @@
 #ifdef _WIN32
 #include <winsock2.h>
 #else
+#include <vector>
+
+#include "EventLoop.h"
+#include "HandshakeLoop.h"
 #include "OpenSslWrapper.h"
+#include "SessionTicketKeys.h"
 #endif
 
+#include "ConnectionRegistry.h"
+#include "HandshakeStatistics.h"
+
 namespace ggolbik {
 namespace cpp {
 namespace tls {
@@ -23,6 +31,29 @@ class Server {
  private:  // type definitions
   typedef char byte;
 
+ private:  // const
+  // default time a client has to complete the TLS handshake (10s)
+  static const unsigned int DEFAULT_HANDSHAKE_TIMEOUT_MILLISECONDS = 10000;
+  // default max number of sessions in the server side session cache
+  static const unsigned int DEFAULT_SESSION_CACHE_SIZE = 20480;
+  // default time a session ticket key encrypts new tickets (1h)
+  static const unsigned int DEFAULT_TICKET_KEY_ROTATION_SECONDS = 3600;
+
+ public:  // type definitions
+  /**
+   * Defines how accepted connections are served.
+   */
+  enum class Mode {
+    /**
+     * Each connection is served by its own worker thread.
+     */
+    ThreadPerConnection,
+    /**
+     * All connections are served by a fixed set of epoll event loop threads.
+     */
+    EventLoop
+  };
+
  public:  // construction/destruction/operators
   /**
    * @param port define port of server
@@ -33,6 +64,15 @@ class Server {
    * @param interfaceAddress the interface
    */
   Server(unsigned short port, std::string interfaceAddress);
+  /**
+   * @param port define port of server
+   * @param interfaceAddress the interface
+   * @param mode how the connections are served
+   * @param loopCount the number of event loop threads if mode is
+   * Mode::EventLoop. 0 uses one loop per CPU core.
+   */
+  Server(unsigned short port, std::string interfaceAddress, Mode mode,
+         unsigned int loopCount = 0);
   /**
    * Move constructor
    */
@@ -68,6 +108,27 @@ class Server {
    * Close the server socket.
    */
   void close();
+  /**
+   * Returns how the connections are served.
+   */
+  Mode getMode();
+  /**
+   * Enables length-prefixed framing. The workers reassemble the frames from
+   * the decrypted stream and echo all frames of one read with a single write.
+   * Returns false if the server is open.
+   */
+  bool setFraming(bool framing);
+  bool isFraming();
+  /**
+   * Returns the number of open connections. Finished workers are reaped by the
+   * server thread within one select() timeout.
+   */
+  std::size_t getConnectionCount();
+  /**
+   * Returns the number of connections which have been passed to workers since
+   * the server has been created.
+   */
+  std::size_t getTotalConnectionCount();
 
  private:  // helper methods
   /**
@@ -80,6 +141,24 @@ class Server {
    * The method executed by the server thread.
    */
   void run();
+#ifndef _WIN32
+  /**
+   * Passes a connection whose TLS handshake has been completed to a worker.
+   * Called by the handshake loop.
+   */
+  void serve(int clientSocket, OpenSslWrapper::TlsPtr tlsPtr);
+  /**
+   * Creates a TLS context with the key and the certificate and the session
+   * settings of the server.
+   */
+  OpenSslWrapper::TlsContextPtr createTlsContext(const std::string &keyFileName,
+                                                 const std::string &certFileName);
+  /**
+   * Takes over a reloaded TLS context. Called by the server thread before a
+   * connection is accepted.
+   */
+  void updateTlsContext();
+#endif
 
  private:  // fields
   std::mutex mutexPublicMethods;
@@ -104,6 +183,37 @@ class Server {
    * The thread used to listen for connections.
    */
   std::thread serverThread;
+  /**
+   * How the connections are served.
+   */
+  Mode mode;
+  /**
+   * The number of event loop threads.
+   */
+  unsigned int loopCount;
+  /**
+   * Whether the workers echo length-prefixed frames.
+   */
+  bool framing;
+  /**
+   * The workers of the accepted connections. Declared before the event loops,
+   * because the workers of the loops report to the registry when they close.
+   */
+  ConnectionRegistry connections;
+#ifndef _WIN32
+  /**
+   * The event loops if mode is Mode::EventLoop.
+   */
+  std::vector<std::unique_ptr<EventLoop>> eventLoops;
+  /**
+   * The event loop which gets the next connection.
+   */
+  std::size_t nextEventLoop;
+  /**
+   * Performs the TLS handshakes of the accepted connections.
+   */
+  std::unique_ptr<HandshakeLoop> handshakeLoop;
+#endif
 /**
  * The current listen socket.
  */
@@ -113,16 +223,123 @@ class Server {
   int listenSocket;
 #endif
  public:  // TLS methods
+  /**
+   * Sets the key file. The file is loaded by open() and by
+   * reloadCertificate(), so it can be changed while the server is open.
+   */
   bool setKeyFileName(const std::string &fileName);
-  const std::string &getKeyFileName();
+  std::string getKeyFileName();
+  /**
+   * Sets the certificate file. The file is loaded by open() and by
+   * reloadCertificate(), so it can be changed while the server is open.
+   */
   bool setCertFileName(const std::string &fileName);
-  const std::string &getCertFileName();
+  std::string getCertFileName();
+  /**
+   * Loads the key and certificate files into a new TLS context. New
+   * connections use the new context, established connections keep the
+   * context of their handshake. The session ticket keys are shared, so the
+   * clients still resume their sessions.
+   *
+   * @return false if the server is not open or the files could not be loaded.
+   * The current context is used further then.
+   */
+  bool reloadCertificate();
+  /**
+   * Sets the interval in which the server thread checks the modification
+   * time of the key and certificate files and reloads them if they changed.
+   * 0 disables the check. Returns false if the server is open.
+   */
+  bool setCertificateWatchInterval(unsigned int milliseconds);
+  unsigned int getCertificateWatchInterval();
+  /**
+   * Returns the number of contexts which have been taken over by the server
+   * thread since the server has been opened.
+   */
+  std::size_t getCertificateReloadCount();
+  /**
+   * Sets the time a client has to complete the TLS handshake after its
+   * connection has been accepted. Returns false if the server is open.
+   */
+  bool setHandshakeTimeout(unsigned int milliseconds);
+  unsigned int getHandshakeTimeout();
+  /**
+   * Returns the number of TLS handshakes which did not complete within the
+   * timeout.
+   */
+  std::size_t getHandshakeTimeoutCount();
+  /**
+   * Sets the max number of sessions the server keeps to resume sessions of
+   * clients without tickets. 0 disables the cache. Returns false if the
+   * server is open.
+   */
+  bool setSessionCacheSize(unsigned int size);
+  unsigned int getSessionCacheSize();
+  /**
+   * Sets the time a session ticket key encrypts new tickets before it is
+   * replaced. Tickets are accepted for up to two rotations. 0 disables
+   * session tickets. Returns false if the server is open.
+   */
+  bool setTicketKeyRotation(unsigned int seconds);
+  unsigned int getTicketKeyRotation();
+  /**
+   * Returns the number of full and resumed handshakes since the server has
+   * been opened and the CPU time spent in them.
+   */
+  HandshakeStatistics getHandshakeStatistics();
+  /**
+   * Enables kernel TLS. The kernel encrypts the data sent on the connections,
+   * so the workers write to the socket directly and send files with
+   * sendfile(). Connections for which the kernel does not support kTLS use
+   * user-space TLS. Returns false if the server is open.
+   */
+  bool setKtls(bool enabled);
+  bool isKtls();
+  /**
+   * Returns the number of connections whose sent data has been encrypted by
+   * the kernel.
+   */
+  std::size_t getKtlsConnectionCount();
+  /**
+   * Sets a file which is sent to each client once the connection has been
+   * established. An empty name sends no file. Returns false if the server is
+   * open.
+   */
+  bool setGreetingFileName(const std::string &fileName);
+  const std::string &getGreetingFileName();
 
  private:  // TLS fields
+  std::mutex mutexTlsFiles;
   std::string keyFileName;
   std::string certFileName;
+  unsigned int handshakeTimeout;
+  unsigned int sessionCacheSize;
+  unsigned int ticketKeyRotation;
+  bool ktls;
+  std::atomic<std::size_t> ktlsConnectionCount;
+  std::string greetingFileName;
 #ifndef _WIN32
+  /**
+   * The keys of the session tickets. Declared before the context, which uses
+   * them.
+   */
+  std::unique_ptr<SessionTicketKeys> ticketKeys;
+  /**
+   * The context of new connections. Only used by the server thread while the
+   * server is open.
+   */
   OpenSslWrapper::TlsContextPtr tlsContextPtr;
+  /**
+   * A reloaded context which has not been taken over by the server thread
+   * yet. The server thread exchanges it, so the accept path needs no lock.
+   */
+  std::atomic<::SSL_CTX *> nextTlsContext;
+  /**
+   * Serializes reloadCertificate() and close().
+   */
+  std::mutex mutexReload;
+  unsigned int certificateWatchInterval;
+  std::atomic<std::size_t> certificateReloadCount;
 #endif
 };
 
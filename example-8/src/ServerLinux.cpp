@@ -5,16 +5,20 @@
 #include <arpa/inet.h>  // ::htons(...) ; ::htonl(...), ::inet_addr(...)
 #include <fcntl.h>      // ::fcntl(...)
 #include <netinet/in.h>  // INADDR_ANY ; INADDR_NONE ; sockaddr_in ; IPPROTO_TCP ;
+#include <netinet/tcp.h>  // TCP_NODELAY
 #include <sys/select.h>  // ::select(...)
 #include <sys/socket.h>  // ::socket(...) ; AF_INET ; SOCK_STREAM
+#include <sys/stat.h>    // ::fstat(...) ; ::stat(...)
 #include <sys/time.h>    // struct timeval
 #include <unistd.h>      // ::close(int), ::read(int, void*, size_t)
 
-#include <cerrno>    // errno
-#include <cstring>   // ::strerror_r(...)
-#include <iostream>  // std::cout(...) ; std::cerr(...)
-#include <string>    // std::string
-#include <vector>    // std::vector
+#include <algorithm>  // std::max
+#include <chrono>     // std::chrono::steady_clock
+#include <cerrno>     // errno
+#include <cstring>    // ::strerror_r(...)
+#include <iostream>   // std::cout(...) ; std::cerr(...)
+#include <string>     // std::string
+#include <vector>     // std::vector
 
 #include "Server.h"
 #include "Worker.h"
@@ -26,13 +30,29 @@ namespace tls {
 Server::Server(unsigned short port) : Server(port, "") {}
 
 Server::Server(unsigned short port, std::string interfaceAddress)
+    : Server(port, interfaceAddress, Mode::ThreadPerConnection) {}
+
+Server::Server(unsigned short port, std::string interfaceAddress, Mode mode,
+               unsigned int loopCount)
     : port{port},
       interfaceAddress{interfaceAddress},
       enabled{false},
       running{false},
+      mode{mode},
+      loopCount{loopCount},
+      framing{false},
+      nextEventLoop{0},
       listenSocket{-1},
       keyFileName{"key.pem"},
-      certFileName{"cert.pem"} {}
+      certFileName{"cert.pem"},
+      handshakeTimeout{Server::DEFAULT_HANDSHAKE_TIMEOUT_MILLISECONDS},
+      sessionCacheSize{Server::DEFAULT_SESSION_CACHE_SIZE},
+      ticketKeyRotation{Server::DEFAULT_TICKET_KEY_ROTATION_SECONDS},
+      ktls{false},
+      ktlsConnectionCount{0},
+      nextTlsContext{nullptr},
+      certificateWatchInterval{0},
+      certificateReloadCount{0} {}
 
 Server::~Server() { this->close(); }
 
@@ -300,8 +320,14 @@ static bool setSocketOptions(int socket) {
   int enable = 1;
   // On success, zero is returned. On error, -1 is returned, and errno is set
   // appropriately.
-  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &enable,
-                   sizeof(int)) != 0) {
+  // optname is a single option and not a bit mask, so each option requires its
+  // own call.
+  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) !=
+      0) {
+    return false;
+  }
+  if (::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) !=
+      0) {
     return false;
   }
   return true;
@@ -371,6 +397,26 @@ static bool setSocketModeNonBlocking(int socket) {
   return true;
 }
 
+/**
+ * Disables the Nagle algorithm on the socket. A response which is written in
+ * more than one segment, e.g. a TLS record after a previous one, is otherwise
+ * held back until the peer acknowledges the previous segment. The peer delays
+ * its ACK until it sends the next request, so the latency of each echo grows
+ * to the interval between the requests.
+ *
+ * The method call
+ *   int setsockopt(int sockfd, int level, int optname, const void *optval,
+ *                  socklen_t optlen);
+ * is defined in header <sys/socket.h> and TCP_NODELAY in <netinet/tcp.h>
+ *
+ * @return true if the option could be set.
+ */
+static bool setSocketNoDelay(int socket) {
+  int enable = 1;
+  return ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable,
+                      sizeof(enable)) == 0;
+}
+
 /**
  * Enables connection requests on the socket.
  *
@@ -587,19 +633,18 @@ bool Server::open(const std::string& password) {
     return false;
   }
 
-  // create TLS context
-  this->tlsContextPtr =
-      OpenSslWrapper::TlsContextPtr(OpenSslWrapper::createTlsContextServer());
-  if (!tlsContextPtr) {
-    std::cerr << "Failed to create TLS context." << std::endl;
-    return false;
+  // create TLS context. The ticket keys are shared by all contexts, so the
+  // tickets stay valid if the certificate is reloaded.
+  if (this->ticketKeyRotation > 0) {
+    this->ticketKeys.reset(new SessionTicketKeys(this->ticketKeyRotation));
   }
-  // configure TLS context
-  if (!OpenSslWrapper::configureTlsContext(
-          this->tlsContextPtr.get(), this->keyFileName, this->certFileName)) {
-    std::cerr << "Failed to configure TLS context." << std::endl;
+  this->tlsContextPtr =
+      this->createTlsContext(this->getKeyFileName(), this->getCertFileName());
+  if (!this->tlsContextPtr) {
+    this->ticketKeys.reset();
     return false;
   }
+  this->certificateReloadCount = 0;
 
   // create a socket address
   sockaddr_in address;
@@ -659,6 +704,45 @@ bool Server::open(const std::string& password) {
     return false;
   }
 
+  // start event loops
+  if (this->mode == Mode::EventLoop) {
+    unsigned int count = this->loopCount;
+    if (count == 0) {
+      // hardware_concurrency returns 0 if the value is not computable.
+      count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < count; i++) {
+      std::unique_ptr<EventLoop> eventLoop(new EventLoop());
+      if (!eventLoop->start()) {
+        std::cerr << "Failed to start event loop." << std::endl;
+        this->eventLoops.clear();
+        if (!this->closeSocket()) {
+          printError();
+        }
+        return false;
+      }
+      this->eventLoops.push_back(std::move(eventLoop));
+    }
+  }
+  this->nextEventLoop = 0;
+
+  // start handshake loop. The accept thread only creates the TLS objects, so
+  // a slow client does not block the other connections.
+  this->handshakeLoop.reset(new HandshakeLoop(
+      [this](int clientSocket, OpenSslWrapper::TlsPtr tlsPtr) {
+        this->serve(clientSocket, std::move(tlsPtr));
+      },
+      this->handshakeTimeout));
+  if (!this->handshakeLoop->start()) {
+    std::cerr << "Failed to start handshake loop." << std::endl;
+    this->handshakeLoop.reset();
+    this->eventLoops.clear();
+    if (!this->closeSocket()) {
+      printError();
+    }
+    return false;
+  }
+
   // Update status
   this->enabled = true;
   this->running = true;
@@ -699,13 +783,44 @@ void Server::close() {
       printError();
     }
 
-    // dispose TLS context
+    // stop handshake loop. Established connections are not passed to the
+    // workers anymore.
+    this->handshakeLoop.reset();
+
+    // stop event loops and close their connections
+    this->eventLoops.clear();
+    // release the workers which have been closed by the event loops
+    this->connections.closeAll();
+
+    // dispose TLS context. A context which has been reloaded after the server
+    // thread stopped has not been taken over.
+    {
+      std::unique_lock<std::mutex> reloadLock(this->mutexReload);
+      ::SSL_CTX *next = this->nextTlsContext.exchange(nullptr);
+      if (next != nullptr) {
+        ::SSL_CTX_free(next);
+      }
+    }
     this->tlsContextPtr.reset();
+    this->ticketKeys.reset();
 
     this->running = false;
   }
 }
 
+/**
+ * Returns the modification time of the file in nanoseconds or -1 if the file
+ * does not exist.
+ */
+static long long getModificationTime(const std::string& fileName) {
+  struct stat fileStatus;
+  if (::stat(fileName.c_str(), &fileStatus) != 0) {
+    return -1;
+  }
+  return static_cast<long long>(fileStatus.st_mtim.tv_sec) * 1000000000LL +
+         fileStatus.st_mtim.tv_nsec;
+}
+
 /**
  * requires includes
  * #include <sys/socket.h> for accept
@@ -714,9 +829,40 @@ void Server::close() {
 void Server::run() {
   std::cout << "Listening on port " << this->port << std::endl;
 
-  std::vector<std::shared_ptr<Worker>> workers = {};
+  // the modification times of the key and certificate files
+  std::chrono::steady_clock::duration watchInterval =
+      std::chrono::milliseconds(this->certificateWatchInterval);
+  std::chrono::steady_clock::time_point nextWatch =
+      std::chrono::steady_clock::now() + watchInterval;
+  std::string keyFileName = this->getKeyFileName();
+  std::string certFileName = this->getCertFileName();
+  long long keyModified = getModificationTime(keyFileName);
+  long long certModified = getModificationTime(certFileName);
 
   while (this->enabled) {
+    // close the workers of finished connections. The select timeout limits the
+    // delay if no connections arrive.
+    this->connections.reap();
+
+    // reload the certificate if the files have been replaced
+    if (this->certificateWatchInterval > 0 &&
+        std::chrono::steady_clock::now() >= nextWatch) {
+      nextWatch = std::chrono::steady_clock::now() + watchInterval;
+      std::string key = this->getKeyFileName();
+      std::string cert = this->getCertFileName();
+      long long keyTime = getModificationTime(key);
+      long long certTime = getModificationTime(cert);
+      if (key != keyFileName || cert != certFileName ||
+          keyTime != keyModified || certTime != certModified) {
+        // a failed reload is retried when the files change again
+        keyFileName = key;
+        certFileName = cert;
+        keyModified = keyTime;
+        certModified = certTime;
+        this->reloadCertificate();
+      }
+    }
+
     // select returns 0 if timeout or -1 if error
     int rc = select(this->listenSocket);
     if (rc < 0) {
@@ -761,28 +907,28 @@ void Server::run() {
       continue;
     }
 
-    // check TLS
+    // send each response immediately. A failure only costs latency.
+    if (!setSocketNoDelay(clientSocket)) {
+      std::cerr << "Failed to disable the Nagle algorithm." << std::endl;
+      printError();
+    }
+
+    // create the TLS object. The handshake is performed by the handshake loop.
+    this->updateTlsContext();
     OpenSslWrapper::TlsPtr tlsPtr = OpenSslWrapper::TlsPtr(
-        OpenSslWrapper::acceptTls(this->tlsContextPtr.get(), clientSocket));
+        OpenSslWrapper::createTlsServer(this->tlsContextPtr.get(), clientSocket));
     if (!tlsPtr) {
-      // failed to accept connection
       closeClientSocket(clientSocket);
       continue;
     }
 
-    // pass the accepted client socket to a worker thread
-    std::shared_ptr<Worker> worker(new Worker(clientSocket, tlsPtr.release()));
-    // put worker in list to be able to stop all workers
-    workers.push_back(worker);
-    // start worker to read
-    worker->start();
+    // the handshake loop closes the connection if it is stopped
+    this->handshakeLoop->add(clientSocket, std::move(tlsPtr));
   }
 
-  // stop all workers
-  for (std::shared_ptr<Worker> worker : workers) {
-    if (worker) {
-      worker->close();
-    }
+  // stop all workers. The workers of the event loops are closed by the loops.
+  if (this->mode == Mode::ThreadPerConnection) {
+    this->connections.closeAll();
   }
 
   // close socket
@@ -795,25 +941,252 @@ void Server::run() {
   std::cout << "Stopped listening on port " << this->port << std::endl;
 }
 
-bool Server::setKeyFileName(const std::string& fileName) {
-  if (this->isOpen()) {
+/**
+ * Called by the handshake loop thread. The accept thread does not touch the
+ * workers, so nextEventLoop needs no lock.
+ */
+void Server::serve(int clientSocket, OpenSslWrapper::TlsPtr tlsPtr) {
+  std::shared_ptr<Worker> worker(new Worker(clientSocket, tlsPtr.release()));
+  if (worker->isKtlsActive()) {
+    this->ktlsConnectionCount++;
+  }
+  worker->setFraming(this->framing);
+  if (!this->greetingFileName.empty()) {
+    // each worker reads the file with its own descriptor
+    int fd = ::open(this->greetingFileName.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat fileStatus;
+    if (fd == -1 || ::fstat(fd, &fileStatus) != 0) {
+      std::cerr << "Failed to open greeting file." << std::endl;
+      printError();
+      if (fd != -1) {
+        ::close(fd);
+      }
+    } else {
+      worker->sendFile(fd, static_cast<std::size_t>(fileStatus.st_size));
+    }
+  }
+  // put worker in the registry to be able to stop all workers
+  ConnectionRegistry::Handle handle = this->connections.insert(worker);
+
+  if (this->mode == Mode::EventLoop) {
+    // pass the accepted client socket to the event loops in turn
+    if (!worker->activate()) {
+      this->connections.remove(handle);
+      return;
+    }
+    if (!this->eventLoops[this->nextEventLoop]->add(worker)) {
+      std::cerr << "Failed to pass connection to event loop." << std::endl;
+      this->connections.remove(handle);
+    }
+    this->nextEventLoop = (this->nextEventLoop + 1) % this->eventLoops.size();
+    return;
+  }
+
+  // pass the accepted client socket to a worker thread
+  // start worker to read
+  worker->start();
+}
+
+OpenSslWrapper::TlsContextPtr Server::createTlsContext(
+    const std::string& keyFileName, const std::string& certFileName) {
+  OpenSslWrapper::TlsContextPtr ctx =
+      OpenSslWrapper::TlsContextPtr(OpenSslWrapper::createTlsContextServer());
+  if (!ctx) {
+    std::cerr << "Failed to create TLS context." << std::endl;
+    return nullptr;
+  }
+  // configure TLS context
+  if (!OpenSslWrapper::configureTlsContext(ctx.get(), keyFileName,
+                                           certFileName)) {
+    std::cerr << "Failed to configure TLS context." << std::endl;
+    return nullptr;
+  }
+  // resume the sessions of returning clients
+  if (!OpenSslWrapper::configureSessionCache(
+          ctx.get(), static_cast<long>(this->sessionCacheSize))) {
+    std::cerr << "Failed to configure TLS session cache." << std::endl;
+    return nullptr;
+  }
+  if (this->ticketKeys) {
+    if (!this->ticketKeys->attach(ctx.get())) {
+      std::cerr << "Failed to configure TLS session tickets." << std::endl;
+      return nullptr;
+    }
+  } else {
+    ::SSL_CTX_set_options(ctx.get(), SSL_OP_NO_TICKET);
+  }
+  // the kernel encrypts the sent data if it supports the negotiated cipher
+  if (this->ktls && !OpenSslWrapper::enableKtls(ctx.get())) {
+    std::cerr << "OpenSSL does not support kTLS. Using user-space TLS."
+              << std::endl;
+  }
+  return ctx;
+}
+
+/**
+ * An SSL object holds a reference to its context, so the previous context is
+ * freed when its last connection is closed.
+ */
+void Server::updateTlsContext() {
+  if (this->nextTlsContext.load(std::memory_order_acquire) == nullptr) {
+    return;
+  }
+  ::SSL_CTX* next = this->nextTlsContext.exchange(nullptr);
+  if (next != nullptr) {
+    this->tlsContextPtr.reset(next);
+    this->certificateReloadCount++;
+    std::cout << "Reloaded certificate" << std::endl;
+  }
+}
+
+/**
+ * The new context is published to the server thread and replaces a context
+ * which has not been taken over yet.
+ */
+bool Server::reloadCertificate() {
+  std::unique_lock<std::mutex> lock(this->mutexReload);
+  if (!this->enabled) {
+    return false;
+  }
+  OpenSslWrapper::TlsContextPtr ctx =
+      this->createTlsContext(this->getKeyFileName(), this->getCertFileName());
+  if (!ctx) {
+    std::cerr << "Failed to reload certificate." << std::endl;
     return false;
   }
+  ::SSL_CTX* previous = this->nextTlsContext.exchange(ctx.release());
+  if (previous != nullptr) {
+    ::SSL_CTX_free(previous);
+  }
+  return true;
+}
+
+bool Server::setKeyFileName(const std::string& fileName) {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
   this->keyFileName = fileName;
   return true;
 }
 
-const std::string& Server::getKeyFileName() { return this->keyFileName; }
+std::string Server::getKeyFileName() {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  return this->keyFileName;
+}
 
 bool Server::setCertFileName(const std::string& fileName) {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  this->certFileName = fileName;
+  return true;
+}
+
+std::string Server::getCertFileName() {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  return this->certFileName;
+}
+
+bool Server::setCertificateWatchInterval(unsigned int milliseconds) {
   if (this->isOpen()) {
     return false;
   }
-  this->certFileName = fileName;
+  this->certificateWatchInterval = milliseconds;
+  return true;
+}
+
+unsigned int Server::getCertificateWatchInterval() {
+  return this->certificateWatchInterval;
+}
+
+std::size_t Server::getCertificateReloadCount() {
+  return this->certificateReloadCount;
+}
+
+bool Server::setHandshakeTimeout(unsigned int milliseconds) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->handshakeTimeout = milliseconds;
   return true;
 }
 
-const std::string& Server::getCertFileName() { return this->certFileName; }
+unsigned int Server::getHandshakeTimeout() { return this->handshakeTimeout; }
+
+bool Server::setSessionCacheSize(unsigned int size) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->sessionCacheSize = size;
+  return true;
+}
+
+unsigned int Server::getSessionCacheSize() { return this->sessionCacheSize; }
+
+bool Server::setTicketKeyRotation(unsigned int seconds) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->ticketKeyRotation = seconds;
+  return true;
+}
+
+unsigned int Server::getTicketKeyRotation() { return this->ticketKeyRotation; }
+
+HandshakeStatistics Server::getHandshakeStatistics() {
+  // lock mutex, the handshake loop is created by open()
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  return this->handshakeLoop ? this->handshakeLoop->getStatistics()
+                             : HandshakeStatistics();
+}
+
+bool Server::setKtls(bool enabled) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->ktls = enabled;
+  return true;
+}
+
+bool Server::isKtls() { return this->ktls; }
+
+std::size_t Server::getKtlsConnectionCount() {
+  return this->ktlsConnectionCount;
+}
+
+bool Server::setGreetingFileName(const std::string& fileName) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->greetingFileName = fileName;
+  return true;
+}
+
+const std::string& Server::getGreetingFileName() {
+  return this->greetingFileName;
+}
+
+std::size_t Server::getHandshakeTimeoutCount() {
+  // lock mutex, the handshake loop is created by open()
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+  return this->handshakeLoop ? this->handshakeLoop->getTimeoutCount() : 0;
+}
+
+Server::Mode Server::getMode() { return this->mode; }
+
+bool Server::setFraming(bool framing) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->framing = framing;
+  return true;
+}
+
+bool Server::isFraming() { return this->framing; }
+
+std::size_t Server::getConnectionCount() {
+  return this->connections.getLiveCount();
+}
+
+std::size_t Server::getTotalConnectionCount() {
+  return this->connections.getTotalCount();
+}
 
 }  // namespace tls
 }  // namespace cpp
@@ -22,11 +22,28 @@ namespace tls {
 Server::Server(unsigned short port) : Server(port, "") {}
 
 Server::Server(unsigned short port, std::string interfaceAddress)
+    : Server(port, interfaceAddress, Mode::ThreadPerConnection) {}
+
+// The event loop mode requires epoll and is not supported on Windows. The
+// connections are always served by worker threads.
+Server::Server(unsigned short port, std::string interfaceAddress, Mode mode,
+               unsigned int loopCount)
     : port{port},
       interfaceAddress{interfaceAddress},
       enabled{false},
       running{false},
-      listenSocket{INVALID_SOCKET} {}
+      mode{Mode::ThreadPerConnection},
+      loopCount{loopCount},
+      framing{false},
+      listenSocket{INVALID_SOCKET},
+      handshakeTimeout{Server::DEFAULT_HANDSHAKE_TIMEOUT_MILLISECONDS},
+      sessionCacheSize{Server::DEFAULT_SESSION_CACHE_SIZE},
+      ticketKeyRotation{Server::DEFAULT_TICKET_KEY_ROTATION_SECONDS},
+      ktls{false},
+      ktlsConnectionCount{0},
+      nextTlsContext{nullptr},
+      certificateWatchInterval{0},
+      certificateReloadCount{0} {}
 
 Server::~Server() { this->close(); }
 
@@ -375,9 +392,11 @@ void Server::close() {
 void Server::run() {
   std::cout << "Listening on port " << this->port << std::endl;
 
-  std::vector<std::shared_ptr<Worker>> workers = {};
-
   while (this->enabled) {
+    // close the workers of finished connections. The select timeout limits the
+    // delay if no connections arrive.
+    this->connections.reap();
+
     // select returns 0 if timeout or -1 if error
     int rc = select(this->listenSocket);
     if (rc < 0) {
@@ -421,18 +440,15 @@ void Server::run() {
 
     // pass the accepted client socket to a worker thread
     std::shared_ptr<Worker> worker(new Worker(clientSocket));
-    // put worker in list to be able to stop all workers
-    workers.push_back(worker);
+    worker->setFraming(this->framing);
+    // put worker in the registry to be able to stop all workers
+    this->connections.insert(worker);
     // start worker to read
     worker->start();
   }
 
   // stop all workers
-  for (std::shared_ptr<Worker> worker : workers) {
-    if (worker) {
-      worker->close();
-    }
-  }
+  this->connections.closeAll();
 
   // close socket
   if (!this->closeSocket()) {
@@ -445,24 +461,128 @@ void Server::run() {
 }
 
 bool Server::setKeyFileName(const std::string &fileName) {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  this->keyFileName = fileName;
+  return true;
+}
+
+std::string Server::getKeyFileName() {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  return this->keyFileName;
+}
+
+bool Server::setCertFileName(const std::string &fileName) {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  this->certFileName = fileName;
+  return true;
+}
+
+std::string Server::getCertFileName() {
+  std::unique_lock<std::mutex> lock(this->mutexTlsFiles);
+  return this->certFileName;
+}
+
+// TLS is not implemented on Windows, so there is no context to reload.
+bool Server::reloadCertificate() { return false; }
+
+bool Server::setCertificateWatchInterval(unsigned int milliseconds) {
   if (this->isOpen()) {
     return false;
   }
-  this->keyFileName = fileName;
+  this->certificateWatchInterval = milliseconds;
   return true;
 }
 
-const std::string &Server::getKeyFileName() { return this->keyFileName; }
+unsigned int Server::getCertificateWatchInterval() {
+  return this->certificateWatchInterval;
+}
 
-bool Server::setCertFileName(const std::string &fileName) {
+std::size_t Server::getCertificateReloadCount() {
+  return this->certificateReloadCount;
+}
+
+bool Server::setHandshakeTimeout(unsigned int milliseconds) {
   if (this->isOpen()) {
     return false;
   }
-  this->certFileName = fileName;
+  this->handshakeTimeout = milliseconds;
+  return true;
+}
+
+unsigned int Server::getHandshakeTimeout() { return this->handshakeTimeout; }
+
+// TLS is not implemented on Windows, so no handshake times out.
+std::size_t Server::getHandshakeTimeoutCount() { return 0; }
+
+bool Server::setSessionCacheSize(unsigned int size) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->sessionCacheSize = size;
   return true;
 }
 
-const std::string &Server::getCertFileName() { return this->certFileName; }
+unsigned int Server::getSessionCacheSize() { return this->sessionCacheSize; }
+
+bool Server::setTicketKeyRotation(unsigned int seconds) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->ticketKeyRotation = seconds;
+  return true;
+}
+
+unsigned int Server::getTicketKeyRotation() { return this->ticketKeyRotation; }
+
+HandshakeStatistics Server::getHandshakeStatistics() {
+  return HandshakeStatistics();
+}
+
+bool Server::setKtls(bool enabled) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->ktls = enabled;
+  return true;
+}
+
+bool Server::isKtls() { return this->ktls; }
+
+std::size_t Server::getKtlsConnectionCount() {
+  return this->ktlsConnectionCount;
+}
+
+bool Server::setGreetingFileName(const std::string &fileName) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->greetingFileName = fileName;
+  return true;
+}
+
+const std::string &Server::getGreetingFileName() {
+  return this->greetingFileName;
+}
+
+Server::Mode Server::getMode() { return this->mode; }
+
+bool Server::setFraming(bool framing) {
+  if (this->isOpen()) {
+    return false;
+  }
+  this->framing = framing;
+  return true;
+}
+
+bool Server::isFraming() { return this->framing; }
+
+std::size_t Server::getConnectionCount() {
+  return this->connections.getLiveCount();
+}
+
+std::size_t Server::getTotalConnectionCount() {
+  return this->connections.getTotalCount();
+}
 
 }  // namespace tls
 }  // namespace cpp
@@ -0,0 +1,200 @@
+#include "SessionTicketKeys.h"
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#else
+#include <openssl/hmac.h>
+#endif
+
+#include <cstring>   // std::memcmp(...) ; std::memcpy(...)
+#include <iostream>  // std::cerr(...)
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+SessionTicketKeys::SessionTicketKeys(unsigned int rotationSeconds)
+    : rotation{rotationSeconds}, rotationCount{0} {}
+
+SessionTicketKeys::~SessionTicketKeys() {
+  // remove the keys from memory
+  for (Key &key : this->keys) {
+    ::OPENSSL_cleanse(&key, sizeof(key));
+  }
+}
+
+/**
+ * SSL_CTX_set_timeout() sets the lifetime of the sessions. It is sent to the
+ * client as the lifetime hint of the ticket.
+ *
+ * The method call
+ *   long SSL_CTX_set_timeout(SSL_CTX *ctx, long t);
+ * is defined in header <openssl/ssl.h>
+ */
+bool SessionTicketKeys::attach(::SSL_CTX *ctx) {
+  {
+    std::unique_lock<std::mutex> lock(this->mutexKeys);
+    if (!this->rotate()) {
+      return false;
+    }
+  }
+  // the callback gets the keys from the context
+  if (SSL_CTX_set_app_data(ctx, this) != 1) {
+    return false;
+  }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (::SSL_CTX_set_tlsext_ticket_key_evp_cb(
+          ctx, &SessionTicketKeys::onTicketKey) != 1) {
+#else
+  if (SSL_CTX_set_tlsext_ticket_key_cb(ctx, &SessionTicketKeys::onTicketKey) !=
+      1) {
+#endif
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
+  ::SSL_CTX_set_timeout(ctx, static_cast<long>(this->rotation.count()));
+  return true;
+}
+
+std::size_t SessionTicketKeys::getRotationCount() {
+  std::unique_lock<std::mutex> lock(this->mutexKeys);
+  return this->rotationCount;
+}
+
+bool SessionTicketKeys::rotate() {
+  Clock::time_point now = Clock::now();
+  if (!this->keys.empty() && now - this->keys.back().created < this->rotation) {
+    return true;
+  }
+
+  Key key;
+  if (::RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+      ::RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1 ||
+      ::RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1) {
+    std::cerr << "Failed to create session ticket key." << std::endl;
+    ::ERR_print_errors_fp(stderr);
+    return false;
+  }
+  key.created = now;
+  if (!this->keys.empty()) {
+    this->rotationCount++;
+  }
+  this->keys.push_back(key);
+  ::OPENSSL_cleanse(&key, sizeof(key));
+
+  // a ticket of the previous key is still valid for one interval
+  while (now - this->keys.front().created >= 2 * this->rotation) {
+    ::OPENSSL_cleanse(&this->keys.front(), sizeof(Key));
+    this->keys.erase(this->keys.begin());
+  }
+  return true;
+}
+
+bool SessionTicketKeys::getEncryptionKey(Key &key) {
+  std::unique_lock<std::mutex> lock(this->mutexKeys);
+  if (!this->rotate()) {
+    return false;
+  }
+  key = this->keys.back();
+  return true;
+}
+
+int SessionTicketKeys::getDecryptionKey(const unsigned char name[16],
+                                        Key &key) {
+  std::unique_lock<std::mutex> lock(this->mutexKeys);
+  if (!this->rotate()) {
+    return 0;
+  }
+  for (std::size_t i = 0; i < this->keys.size(); i++) {
+    if (std::memcmp(this->keys[i].name, name, sizeof(key.name)) == 0) {
+      key = this->keys[i];
+      return i + 1 == this->keys.size() ? 1 : 2;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Called by OpenSSL to encrypt a new ticket (encrypt is 1) or to decrypt a
+ * ticket of a client (encrypt is 0). The ticket is encrypted with AES-256-CBC
+ * and authenticated with HMAC-SHA256.
+ *
+ * For a new ticket the callback returns 1 on success. For a received ticket it
+ * returns 0 if the key is unknown, so a full handshake is performed, 1 if the
+ * ticket is valid and 2 if the ticket is valid but should be renewed. A
+ * negative value aborts the handshake.
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int SessionTicketKeys::onTicketKey(::SSL *ssl, unsigned char keyName[16],
+                                   unsigned char *iv,
+                                   ::EVP_CIPHER_CTX *cipherContext,
+                                   ::EVP_MAC_CTX *macContext, int encrypt) {
+#else
+int SessionTicketKeys::onTicketKey(::SSL *ssl, unsigned char keyName[16],
+                                   unsigned char *iv,
+                                   ::EVP_CIPHER_CTX *cipherContext,
+                                   ::HMAC_CTX *macContext, int encrypt) {
+#endif
+  SessionTicketKeys *self = static_cast<SessionTicketKeys *>(
+      SSL_CTX_get_app_data(::SSL_get_SSL_CTX(ssl)));
+  if (self == nullptr) {
+    return -1;
+  }
+
+  Key key;
+  int rc = 1;
+  if (encrypt == 1) {
+    if (!self->getEncryptionKey(key)) {
+      return -1;
+    }
+    if (::RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+      ::OPENSSL_cleanse(&key, sizeof(key));
+      return -1;
+    }
+    std::memcpy(keyName, key.name, sizeof(key.name));
+  } else {
+    rc = self->getDecryptionKey(keyName, key);
+    if (rc == 0) {
+      return 0;
+    }
+    // TLS 1.3 clients use a ticket only once, so a resumed connection needs a
+    // new ticket
+    if (::SSL_version(ssl) >= TLS1_3_VERSION) {
+      rc = 2;
+    }
+  }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  char digest[] = "SHA256";
+  ::OSSL_PARAM params[3];
+  params[0] = ::OSSL_PARAM_construct_octet_string(
+      OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof(key.hmacKey));
+  params[1] =
+      ::OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0);
+  params[2] = ::OSSL_PARAM_construct_end();
+  bool initialized = ::EVP_MAC_CTX_set_params(macContext, params) == 1;
+#else
+  bool initialized = ::HMAC_Init_ex(macContext, key.hmacKey,
+                                    sizeof(key.hmacKey), ::EVP_sha256(),
+                                    nullptr) == 1;
+#endif
+  if (encrypt == 1) {
+    initialized = initialized &&
+                  ::EVP_EncryptInit_ex(cipherContext, ::EVP_aes_256_cbc(),
+                                       nullptr, key.aesKey, iv) == 1;
+  } else {
+    initialized = initialized &&
+                  ::EVP_DecryptInit_ex(cipherContext, ::EVP_aes_256_cbc(),
+                                       nullptr, key.aesKey, iv) == 1;
+  }
+  ::OPENSSL_cleanse(&key, sizeof(key));
+  return initialized ? rc : -1;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * The keys which encrypt the session tickets of a server. A client which
+ * presents a ticket resumes its session without the key exchange and the
+ * signature of a full handshake.
+ *
+ * A new key is created after each rotation interval. Tickets are encrypted
+ * with the newest key and are accepted as long as their key is not older than
+ * two intervals, so a ticket is valid for at least one interval. A ticket of
+ * the previous key is replaced by a ticket of the current key.
+ */
+class SessionTicketKeys {
+ private:  // type definitions
+  typedef std::chrono::steady_clock Clock;
+
+  struct Key {
+    unsigned char name[16];
+    unsigned char aesKey[32];
+    unsigned char hmacKey[32];
+    Clock::time_point created;
+  };
+
+ public:  // const
+  // default time a key encrypts new tickets (1h)
+  static const unsigned int DEFAULT_ROTATION_SECONDS = 3600;
+
+ public:  // construction/destruction/operators
+  /**
+   * @param rotationSeconds the time a key encrypts new tickets
+   */
+  SessionTicketKeys(unsigned int rotationSeconds);
+  /**
+   * Move constructor
+   */
+  SessionTicketKeys(SessionTicketKeys &&) = delete;
+  /**
+   * Move assignment operator
+   */
+  SessionTicketKeys &operator=(SessionTicketKeys &&) = delete;
+  /**
+   * Copy constructor
+   */
+  SessionTicketKeys(const SessionTicketKeys &) = delete;
+  /**
+   * Copy assignment operator
+   */
+  SessionTicketKeys &operator=(const SessionTicketKeys &) = delete;
+  /**
+   * Destructor
+   */
+  virtual ~SessionTicketKeys();
+
+ public:  // methods
+  /**
+   * Registers the keys at the context. The keys must outlive the context. The
+   * session timeout of the context is set to the rotation interval.
+   */
+  bool attach(::SSL_CTX *ctx);
+  /**
+   * Returns the number of key rotations since the keys have been created.
+   */
+  std::size_t getRotationCount();
+
+ private:  // helper methods
+  /**
+   * Creates a new current key if the current key is older than the rotation
+   * interval and removes the keys which are older than two intervals. The
+   * mutex must be locked.
+   */
+  bool rotate();
+  /**
+   * Copies the key to encrypt a new ticket. Returns false if no key could be
+   * created.
+   */
+  bool getEncryptionKey(Key &key);
+  /**
+   * Copies the key with the given name. Returns 0 if the key is unknown or
+   * expired, 1 if it is the current key and 2 if the ticket should be renewed.
+   */
+  int getDecryptionKey(const unsigned char name[16], Key &key);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  static int onTicketKey(::SSL *ssl, unsigned char keyName[16],
+                         unsigned char *iv, ::EVP_CIPHER_CTX *cipherContext,
+                         ::EVP_MAC_CTX *macContext, int encrypt);
+#else
+  static int onTicketKey(::SSL *ssl, unsigned char keyName[16],
+                         unsigned char *iv, ::EVP_CIPHER_CTX *cipherContext,
+                         ::HMAC_CTX *macContext, int encrypt);
+#endif
+
+ private:  // fields
+  std::mutex mutexKeys;
+  std::chrono::seconds rotation;
+  /**
+   * The current key is the last one.
+   */
+  std::vector<Key> keys;
+  std::size_t rotationCount;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
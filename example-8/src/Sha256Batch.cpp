@@ -0,0 +1,109 @@
+#include "Sha256Batch.h"
+
+#include "Sha256Hasher.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <cpuid.h>  // __get_cpuid_count(...) ; bit_SHA
+#endif
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * OpenSSL uses the SHA extensions itself and its assembly is faster than the
+ * SHA-NI kernel, so the AVX2 kernel is only preferred without them.
+ */
+Sha256Batch::Kernel Sha256Batch::getDefaultKernel() {
+  // initialized on first use and thread safe since C++11
+  static const Kernel kernel =
+      !Sha256Batch::isSupported(Kernel::ShaNi) &&
+              Sha256Batch::isSupported(Kernel::Avx2)
+          ? Kernel::Avx2
+          : Kernel::OpenSsl;
+  return kernel;
+}
+
+/**
+ * __builtin_cpu_supports() does not know the SHA extensions in all GCC
+ * versions, so their bit is read with CPUID (leaf 7, EBX bit 29).
+ */
+bool Sha256Batch::isSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::OpenSsl:
+      return true;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    case Kernel::Avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    case Kernel::ShaNi: {
+      unsigned int eax = 0;
+      unsigned int ebx = 0;
+      unsigned int ecx = 0;
+      unsigned int edx = 0;
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse4.1") &&
+             __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) != 0 &&
+             (ebx & bit_SHA) != 0;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+std::string Sha256Batch::getKernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::OpenSsl:
+      return "openssl";
+    case Kernel::Avx2:
+      return "avx2";
+    case Kernel::ShaNi:
+      return "sha-ni";
+  }
+  return "";
+}
+
+bool Sha256Batch::hash(const std::string_view *inputs, std::size_t count,
+                       unsigned char *digests) {
+  return Sha256Batch::hash(inputs, count, digests,
+                           Sha256Batch::getDefaultKernel());
+}
+
+bool Sha256Batch::hash(const std::string_view *inputs, std::size_t count,
+                       unsigned char *digests, Kernel kernel) {
+  if (!Sha256Batch::isSupported(kernel)) {
+    return false;
+  }
+  switch (kernel) {
+    case Kernel::ShaNi:
+      Sha256Batch::hashShaNi(inputs, count, digests);
+      return true;
+    case Kernel::Avx2:
+      Sha256Batch::hashAvx2(inputs, count, digests);
+      return true;
+    default:
+      return Sha256Batch::hashOpenSsl(inputs, count, digests);
+  }
+}
+
+/**
+ * EVP_DigestInit_ex() with EVP_sha256() fetches the implementation from the
+ * provider for every input, which costs more than hashing a short key. The
+ * hasher drives the SHA-256 of OpenSSL directly and is reused for all inputs.
+ */
+bool Sha256Batch::hashOpenSsl(const std::string_view *inputs,
+                              std::size_t count, unsigned char *digests) {
+  Sha256Hasher hasher;
+  for (std::size_t i = 0; i < count; i++) {
+    if (!hasher.update(inputs[i]) ||
+        !hasher.finish(digests + i * DIGEST_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
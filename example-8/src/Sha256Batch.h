@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Hashes many short inputs with SHA-256. The inputs are processed by a kernel
+ * which is selected at runtime by the features of the CPU: the SHA-NI kernel
+ * hashes one input after the other with the SHA extensions, the AVX2 kernel
+ * hashes 8 inputs at once in the lanes of the vector registers and the
+ * OpenSSL kernel reuses one Sha256Hasher for all inputs. No kernel allocates
+ * memory per input and all produce the same digests.
+ */
+class Sha256Batch {
+ public:  // type definitions
+  enum class Kernel { OpenSsl, Avx2, ShaNi };
+
+ public:  // const
+  // number of bytes of a digest
+  static const std::size_t DIGEST_SIZE = 32;
+
+ public:  // methods
+  /**
+   * Returns the fastest kernel supported by the CPU. The CPU is queried once.
+   */
+  static Kernel getDefaultKernel();
+  static bool isSupported(Kernel kernel);
+  static std::string getKernelName(Kernel kernel);
+
+  /**
+   * Hashes the inputs with the default kernel.
+   *
+   * @param inputs the array of count inputs
+   * @param digests receives count * DIGEST_SIZE bytes. The digest of input i
+   * starts at i * DIGEST_SIZE.
+   * @return false if the kernel failed
+   */
+  static bool hash(const std::string_view *inputs, std::size_t count,
+                   unsigned char *digests);
+  /**
+   * Hashes the inputs with the kernel.
+   *
+   * @return false if the CPU does not support the kernel or the kernel failed
+   */
+  static bool hash(const std::string_view *inputs, std::size_t count,
+                   unsigned char *digests, Kernel kernel);
+
+ private:  // kernels
+  static void hashShaNi(const std::string_view *inputs, std::size_t count,
+                        unsigned char *digests);
+  static void hashAvx2(const std::string_view *inputs, std::size_t count,
+                       unsigned char *digests);
+  static bool hashOpenSsl(const std::string_view *inputs, std::size_t count,
+                          unsigned char *digests);
+
+ private:
+  Sha256Batch() = delete;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,333 @@
+#include "Sha256Batch.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>  // std::memcpy(...) ; std::memset(...)
+
+/**
+ * The kernels are compiled for their instruction set with the target
+ * attribute, so the binary runs on CPUs without them.
+ * Sha256Batch::isSupported() must be checked before a kernel is called.
+ */
+#define SHA256_SHANI __attribute__((target("sha,sse4.1,ssse3")))
+#define SHA256_AVX2 __attribute__((target("avx2")))
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// number of bytes of a block
+static const std::size_t BLOCK_SIZE = 64;
+// number of inputs hashed at once by the AVX2 kernel
+static const std::size_t AVX2_LANES = 8;
+
+static const std::uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static const std::uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+/**
+ * Copies the bytes after the complete blocks of the input into tail and
+ * appends the padding: 0x80, zeros and the length in bits as a big endian
+ * 64 bit number.
+ *
+ * @param tail receives up to 2 blocks
+ * @return the number of blocks of the tail, 1 or 2
+ */
+static std::size_t padTail(const unsigned char *data, std::size_t size,
+                           unsigned char *tail) {
+  std::size_t rest = size % BLOCK_SIZE;
+  std::size_t blocks = rest < BLOCK_SIZE - 8 ? 1 : 2;
+  if (rest > 0) {
+    std::memcpy(tail, data + size - rest, rest);
+  }
+  tail[rest] = 0x80;
+  std::memset(tail + rest + 1, 0, blocks * BLOCK_SIZE - rest - 1 - 8);
+  std::uint64_t bits = static_cast<std::uint64_t>(size) * 8;
+  for (std::size_t i = 0; i < 8; i++) {
+    tail[blocks * BLOCK_SIZE - 1 - i] =
+        static_cast<unsigned char>(bits >> (8 * i));
+  }
+  return blocks;
+}
+
+static void storeDigest(const std::uint32_t *state, unsigned char *digest) {
+  for (std::size_t i = 0; i < 8; i++) {
+    digest[4 * i] = static_cast<unsigned char>(state[i] >> 24);
+    digest[4 * i + 1] = static_cast<unsigned char>(state[i] >> 16);
+    digest[4 * i + 2] = static_cast<unsigned char>(state[i] >> 8);
+    digest[4 * i + 3] = static_cast<unsigned char>(state[i]);
+  }
+}
+
+// SHA-NI
+
+/**
+ * The SHA extensions keep the state in the order ABEF and CDGH. Each
+ * sha256rnds2 instruction performs 2 rounds and sha256msg1/sha256msg2 extend
+ * the message schedule by 4 words.
+ */
+SHA256_SHANI static void compressShaNi(std::uint32_t *state,
+                                       const unsigned char *data,
+                                       std::size_t blocks) {
+  // reverses the bytes of each 32 bit word
+  const __m128i byteOrder =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+  __m128i state1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);        // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1B);  // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+
+  for (std::size_t block = 0; block < blocks; block++) {
+    const unsigned char *p = data + block * BLOCK_SIZE;
+    const __m128i abefSave = state0;
+    const __m128i cdghSave = state1;
+    // the last 4 groups of 4 words of the message schedule
+    __m128i w[4];
+    for (std::size_t group = 0; group < 16; group++) {
+      __m128i words;
+      if (group < 4) {
+        words = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * group)),
+            byteOrder);
+      } else {
+        words = _mm_sha256msg1_epu32(w[group % 4], w[(group + 1) % 4]);
+        words = _mm_add_epi32(
+            words, _mm_alignr_epi8(w[(group + 3) % 4], w[(group + 2) % 4], 4));
+        words = _mm_sha256msg2_epu32(words, w[(group + 3) % 4]);
+      }
+      w[group % 4] = words;
+      __m128i message = _mm_add_epi32(
+          words, _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+                     ROUND_CONSTANTS + 4 * group)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+      message = _mm_shuffle_epi32(message, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+    }
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);        // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);     // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);  // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);     // ABEF
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+}
+
+SHA256_SHANI void Sha256Batch::hashShaNi(const std::string_view *inputs,
+                                         std::size_t count,
+                                         unsigned char *digests) {
+  unsigned char tail[2 * BLOCK_SIZE];
+  for (std::size_t i = 0; i < count; i++) {
+    const unsigned char *data =
+        reinterpret_cast<const unsigned char *>(inputs[i].data());
+    std::size_t size = inputs[i].size();
+    std::uint32_t state[8];
+    std::memcpy(state, INITIAL_STATE, sizeof(state));
+    compressShaNi(state, data, size / BLOCK_SIZE);
+    compressShaNi(state, tail, padTail(data, size, tail));
+    storeDigest(state, digests + i * DIGEST_SIZE);
+  }
+}
+
+// AVX2
+
+SHA256_AVX2 static inline __m256i rotateRight(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+SHA256_AVX2 static inline __m256i add(__m256i a, __m256i b) {
+  return _mm256_add_epi32(a, b);
+}
+
+/**
+ * Compresses one block of each lane. The state holds word w of lane l at
+ * state[w * AVX2_LANES + l].
+ */
+SHA256_AVX2 static void compressAvx2(std::uint32_t *state,
+                                     const unsigned char *const *blocks) {
+  __m256i w[16];
+  for (std::size_t t = 0; t < 16; t++) {
+    std::uint32_t words[AVX2_LANES];
+    for (std::size_t lane = 0; lane < AVX2_LANES; lane++) {
+      std::uint32_t word;
+      std::memcpy(&word, blocks[lane] + 4 * t, sizeof(word));
+      words[lane] = __builtin_bswap32(word);
+    }
+    w[t] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words));
+  }
+  __m256i v[8];
+  for (std::size_t i = 0; i < 8; i++) {
+    v[i] = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(state + i * AVX2_LANES));
+  }
+  __m256i a = v[0], b = v[1], c = v[2], d = v[3];
+  __m256i e = v[4], f = v[5], g = v[6], h = v[7];
+
+  for (std::size_t t = 0; t < 64; t++) {
+    if (t >= 16) {
+      const __m256i w15 = w[(t - 15) % 16];
+      const __m256i w2 = w[(t - 2) % 16];
+      const __m256i s0 =
+          _mm256_xor_si256(_mm256_xor_si256(rotateRight(w15, 7),
+                                            rotateRight(w15, 18)),
+                           _mm256_srli_epi32(w15, 3));
+      const __m256i s1 =
+          _mm256_xor_si256(_mm256_xor_si256(rotateRight(w2, 17),
+                                            rotateRight(w2, 19)),
+                           _mm256_srli_epi32(w2, 10));
+      w[t % 16] = add(add(w[t % 16], s0), add(w[(t - 7) % 16], s1));
+    }
+    const __m256i sum1 = _mm256_xor_si256(
+        _mm256_xor_si256(rotateRight(e, 6), rotateRight(e, 11)),
+        rotateRight(e, 25));
+    const __m256i choose =
+        _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+    const __m256i t1 = add(
+        add(add(h, sum1), add(choose, w[t % 16])),
+        _mm256_set1_epi32(static_cast<int>(ROUND_CONSTANTS[t])));
+    const __m256i sum0 = _mm256_xor_si256(
+        _mm256_xor_si256(rotateRight(a, 2), rotateRight(a, 13)),
+        rotateRight(a, 22));
+    const __m256i majority = _mm256_or_si256(
+        _mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    h = g;
+    g = f;
+    f = e;
+    e = add(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = add(t1, add(sum0, majority));
+  }
+
+  const __m256i result[8] = {a, b, c, d, e, f, g, h};
+  for (std::size_t i = 0; i < 8; i++) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(state + i * AVX2_LANES),
+                        add(v[i], result[i]));
+  }
+}
+
+/**
+ * The next block of an input in a lane: first the complete blocks of the
+ * input, then the padded tail.
+ */
+struct Lane {
+  const unsigned char *data;
+  std::size_t fullBlocks;
+  std::size_t tailBlocks;
+  std::size_t block;
+  std::size_t index;
+  bool active;
+  unsigned char tail[2 * BLOCK_SIZE];
+};
+
+/**
+ * Each lane hashes one input. If an input is complete, its digest is written
+ * and the lane takes the next input, so inputs of different lengths do not
+ * leave lanes idle. Idle lanes at the end of the batch hash a zero block.
+ */
+SHA256_AVX2 void Sha256Batch::hashAvx2(const std::string_view *inputs,
+                                       std::size_t count,
+                                       unsigned char *digests) {
+  static const unsigned char zeroBlock[BLOCK_SIZE] = {};
+  std::uint32_t state[8 * AVX2_LANES];
+  Lane lanes[AVX2_LANES];
+  for (Lane &lane : lanes) {
+    lane.active = false;
+  }
+  std::size_t next = 0;
+  while (true) {
+    std::size_t active = 0;
+    const unsigned char *blocks[AVX2_LANES];
+    for (std::size_t l = 0; l < AVX2_LANES; l++) {
+      Lane &lane = lanes[l];
+      if (!lane.active && next < count) {
+        lane.data =
+            reinterpret_cast<const unsigned char *>(inputs[next].data());
+        std::size_t size = inputs[next].size();
+        lane.fullBlocks = size / BLOCK_SIZE;
+        lane.tailBlocks = padTail(lane.data, size, lane.tail);
+        lane.block = 0;
+        lane.index = next++;
+        lane.active = true;
+        for (std::size_t i = 0; i < 8; i++) {
+          state[i * AVX2_LANES + l] = INITIAL_STATE[i];
+        }
+      }
+      if (lane.active) {
+        active++;
+        blocks[l] =
+            lane.block < lane.fullBlocks
+                ? lane.data + lane.block * BLOCK_SIZE
+                : lane.tail + (lane.block - lane.fullBlocks) * BLOCK_SIZE;
+      } else {
+        blocks[l] = zeroBlock;
+      }
+    }
+    if (active == 0) {
+      return;
+    }
+    compressAvx2(state, blocks);
+    for (std::size_t l = 0; l < AVX2_LANES; l++) {
+      Lane &lane = lanes[l];
+      if (lane.active &&
+          ++lane.block == lane.fullBlocks + lane.tailBlocks) {
+        std::uint32_t laneState[8];
+        for (std::size_t i = 0; i < 8; i++) {
+          laneState[i] = state[i * AVX2_LANES + l];
+        }
+        storeDigest(laneState, digests + lane.index * DIGEST_SIZE);
+        lane.active = false;
+      }
+    }
+  }
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#else
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// The SIMD kernels are only available on x86. Sha256Batch::isSupported()
+// returns false for them.
+void Sha256Batch::hashShaNi(const std::string_view *inputs, std::size_t count,
+                            unsigned char *digests) {
+  Sha256Batch::hashOpenSsl(inputs, count, digests);
+}
+
+void Sha256Batch::hashAvx2(const std::string_view *inputs, std::size_t count,
+                           unsigned char *digests) {
+  Sha256Batch::hashOpenSsl(inputs, count, digests);
+}
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
+
+#endif
@@ -0,0 +1,126 @@
+#include "Sha256Hasher.h"
+
+#include <cstring>  // std::memcpy(...)
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+// the first bytes of an exported state
+static const unsigned char STATE_TAG[4] = {'S', '2', '5', '6'};
+
+static void storeBigEndian(unsigned long long value, std::size_t size,
+                           unsigned char *bytes) {
+  for (std::size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<unsigned char>(value >> (8 * (size - 1 - i)));
+  }
+}
+
+static unsigned long long loadBigEndian(const unsigned char *bytes,
+                                        std::size_t size) {
+  unsigned long long value = 0;
+  for (std::size_t i = 0; i < size; i++) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+// The state of an EVP context is opaque, so the export needs SHA256_CTX and
+// its functions, which OpenSSL 3.0 deprecates. They are used only here.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4996)
+#endif
+
+Sha256Hasher::Sha256Hasher() : context{} { this->reset(); }
+
+bool Sha256Hasher::update(const void *data, std::size_t size) {
+  return ::SHA256_Update(&this->context, data, size) == 1;
+}
+
+bool Sha256Hasher::update(std::string_view data) {
+  return this->update(data.data(), data.size());
+}
+
+bool Sha256Hasher::finish(unsigned char *digest) {
+  bool result = ::SHA256_Final(digest, &this->context) == 1;
+  return this->reset() && result;
+}
+
+bool Sha256Hasher::finish(std::vector<unsigned char> &digest) {
+  digest.resize(Sha256Hasher::DIGEST_SIZE);
+  return this->finish(digest.data());
+}
+
+bool Sha256Hasher::reset() { return ::SHA256_Init(&this->context) == 1; }
+
+/**
+ * OpenSSL counts the bits of the message in two 32-bit words.
+ */
+unsigned long long Sha256Hasher::getSize() const {
+  return ((static_cast<unsigned long long>(this->context.Nh) << 32) |
+          this->context.Nl) /
+         8;
+}
+
+/**
+ * The bytes of the incomplete block are kept by OpenSSL at the start of the
+ * data words in the order of the message, and their number is the size
+ * modulo the block size.
+ */
+Sha256Hasher::State Sha256Hasher::exportState() const {
+  State state = {};
+  unsigned char *position = state.data();
+  std::memcpy(position, STATE_TAG, sizeof(STATE_TAG));
+  position += sizeof(STATE_TAG);
+  for (std::size_t i = 0; i < 8; i++) {
+    storeBigEndian(this->context.h[i], 4, position);
+    position += 4;
+  }
+  storeBigEndian(this->getSize(), 8, position);
+  position += 8;
+  std::memcpy(position, this->context.data, this->context.num);
+  return state;
+}
+
+bool Sha256Hasher::importState(const State &state) {
+  const unsigned char *position = state.data();
+  if (std::memcmp(position, STATE_TAG, sizeof(STATE_TAG)) != 0) {
+    return false;
+  }
+  position += sizeof(STATE_TAG);
+  const unsigned long long size = loadBigEndian(position + 8 * 4, 8);
+  // SHA-256 is limited to 2^64 - 1 bits
+  if (size >= (1ULL << 61)) {
+    return false;
+  }
+  ::SHA256_CTX context;
+  if (::SHA256_Init(&context) != 1) {
+    return false;
+  }
+  for (std::size_t i = 0; i < 8; i++) {
+    context.h[i] = static_cast<SHA_LONG>(loadBigEndian(position, 4));
+    position += 4;
+  }
+  position += 8;
+  const unsigned long long bits = size * 8;
+  context.Nl = static_cast<SHA_LONG>(bits);
+  context.Nh = static_cast<SHA_LONG>(bits >> 32);
+  context.num = static_cast<unsigned int>(size % SHA256_CBLOCK);
+  std::memcpy(context.data, position, context.num);
+  this->context = context;
+  return true;
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <openssl/sha.h>  // SHA256_CTX ; SHA256_DIGEST_LENGTH
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace ggolbik {
+namespace cpp {
+namespace tls {
+
+/**
+ * Calculates the SHA-256 of data which arrives in chunks, e.g. from a socket.
+ * The object holds no heap memory, so it can be reused for many messages
+ * with reset() or finish() and a copy continues the same message.
+ *
+ * The intermediate state can be exported after any update() and imported
+ * into another object, e.g. after a restart, to continue hashing a large
+ * upload where it stopped. The state contains the number of bytes hashed,
+ * so the caller knows where to continue.
+ */
+class Sha256Hasher {
+ public:  // const
+  // number of bytes of a digest
+  static const std::size_t DIGEST_SIZE = SHA256_DIGEST_LENGTH;
+  // number of bytes of an exported state
+  static const std::size_t STATE_SIZE = 4 + 8 * 4 + 8 + SHA256_CBLOCK;
+
+ public:  // type definitions
+  /**
+   * The serialised state: a tag, the 8 chaining values and the number of
+   * bytes hashed in big endian order, followed by the bytes of the
+   * incomplete block. The format does not depend on the platform.
+   */
+  typedef std::array<unsigned char, STATE_SIZE> State;
+
+ public:  // construction/destruction/operators
+  Sha256Hasher();
+  /**
+   * Move constructor
+   */
+  Sha256Hasher(Sha256Hasher &&) = default;
+  /**
+   * Move assignment operator
+   */
+  Sha256Hasher &operator=(Sha256Hasher &&) = default;
+  /**
+   * Copy constructor
+   */
+  Sha256Hasher(const Sha256Hasher &) = default;
+  /**
+   * Copy assignment operator
+   */
+  Sha256Hasher &operator=(const Sha256Hasher &) = default;
+  /**
+   * Destructor
+   */
+  ~Sha256Hasher() = default;
+
+ public:  // methods
+  bool update(const void *data, std::size_t size);
+  bool update(std::string_view data);
+  /**
+   * Writes the digest of all updates and resets the hasher.
+   *
+   * @param digest receives DIGEST_SIZE bytes
+   * @return false if OpenSSL failed
+   */
+  bool finish(unsigned char *digest);
+  bool finish(std::vector<unsigned char> &digest);
+  /**
+   * Starts a new message.
+   */
+  bool reset();
+
+  /**
+   * Returns the number of bytes passed to update() since the last reset.
+   */
+  unsigned long long getSize() const;
+  State exportState() const;
+  /**
+   * Continues the message of the state.
+   *
+   * @return false if the state was not exported by a Sha256Hasher. The
+   * hasher is not changed in this case.
+   */
+  bool importState(const State &state);
+
+ private:  // fields
+  ::SHA256_CTX context;
+};
+
+}  // namespace tls
+}  // namespace cpp
+}  // namespace ggolbik
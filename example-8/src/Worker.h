@@ -1,6 +1,8 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -10,10 +12,15 @@
 #include <winsock2.h>
 #else
 #include <openssl/ssl.h>
+#include <sys/types.h>  // off_t
 
 #include "OpenSslWrapper.h"
 #endif
 
+#include "BufferPool.h"
+#include "Frame.h"
+#include "OutputQueue.h"
+
 namespace ggolbik {
 namespace cpp {
 namespace tls {
@@ -28,6 +35,9 @@ class Worker {
  private:  // const
   // 64KiByte
   static const unsigned int MAX_BUFFER_SIZE = 65535;
+  // number of reads before the responses are sent. Limits the data which is
+  // read from a fast peer before the worker writes.
+  static const unsigned int MAX_READS_PER_WAKEUP = 16;
 
  public:  // construction/destruction/operators
 /**
@@ -60,17 +70,157 @@ class Worker {
   virtual ~Worker();
 
  public:  // methods
+  /**
+   * Starts a worker thread which serves the connection.
+   */
   bool start();
+  /**
+   * Enables the worker without a thread. The connection is served by calls of
+   * onReadable() from an event loop.
+   */
+  bool activate();
   bool isRunning();
   /**
    * Stops the worker and closes the socket.
    */
   void close();
+  /**
+   * Sets the callback which is called once the connection has been closed,
+   * either by the worker thread or by close(). The callback must not call
+   * close(). Must be set before start() or activate().
+   */
+  void setFinishedCallback(std::function<void()> callback);
+  /**
+   * Echoes length-prefixed frames instead of the raw stream. TLS records do
+   * not keep the boundaries of the messages, so the frames are reassembled
+   * from the decrypted data. All frames completed by one read are echoed with
+   * a single write. Must be called before start() or activate().
+   */
+  void setFraming(bool framing);
+  /**
+   * Reads the available data and sends the responses as far as possible
+   * without blocking. Must be called by the event loop if the socket is
+   * readable.
+   *
+   * @return false if the connection has been closed by the peer or an error
+   * occured.
+   */
+  bool onReadable();
+  /**
+   * Sends the pending responses and resumes reading once the output queue
+   * has been drained. Must be called by the event loop if the socket is
+   * writable.
+   *
+   * @return false if an error occured.
+   */
+  bool onWritable();
+  /**
+   * Returns true if responses are pending. The event loop has to wait until
+   * the socket is writable.
+   */
+  bool isWritePending();
+  /**
+   * Returns true if reading is paused, because the peer does not take the
+   * pending responses. The event loop must not wait for readability then.
+   */
+  bool isReadPaused();
+#ifdef _WIN32
+  SOCKET getSocket();
+#else
+  int getSocket();
+  /**
+   * Sends the file before any response. The worker takes the ownership of the
+   * descriptor and closes it once the file has been sent. Reading is paused
+   * until then. Must be called before start() or activate().
+   *
+   * With kTLS the kernel encrypts the file and it is sent with sendfile()
+   * without copying it to user space. Otherwise the file is read into pooled
+   * buffers and sent with SSL_write().
+   *
+   * @param fd the descriptor of the file
+   * @param size the number of bytes to send
+   */
+  void sendFile(int fd, std::size_t size);
+  /**
+   * Returns true if the kernel encrypts the data sent on the connection.
+   */
+  bool isKtlsActive();
+#endif
 
  private:  // helper methods
   void run();
-  bool readString(std::string &message);
+  /**
+   * Calls the finished callback. Subsequent calls do nothing.
+   */
+  void notifyFinished();
+#ifdef _WIN32
+  /**
+   * Reads the available data into a pooled buffer.
+   *
+   * @param view the read data. Shares the pooled buffer.
+   * @return false if the connection has been closed or an error occured.
+   */
+  bool read(BufferView &view);
+#else
+  /**
+   * Reads the available data into a pooled buffer without blocking.
+   *
+   * @param view the read data. Shares the pooled buffer.
+   * @return the size of the read data, 0 if the read would block and -1 if
+   * the connection has been closed or an error occured.
+   */
+  int tryRead(BufferView &view);
+  /**
+   * Reads up to MAX_READS_PER_WAKEUP times and queues the responses. Stops
+   * early if the read would block or the output queue is full.
+   *
+   * @return false if the connection has been closed or an error occured.
+   */
+  bool receive();
+  /**
+   * Sends the pending responses as far as possible without blocking.
+   *
+   * @return false if an error occured.
+   */
+  bool flush();
+  /**
+   * Sends or queues the next part of the file as far as possible without
+   * blocking.
+   *
+   * @return 1 if the file has been sent, 0 if the write would block and -1 if
+   * an error occured.
+   */
+  int flushFile();
+#endif
+  /**
+   * Copies the data into pooled buffers and writes them.
+   */
   bool write(const byte data[], size_t length);
+  /**
+   * Writes the bytes of the view without copying them. On Linux the view is
+   * queued and sent as far as the socket accepts it without blocking.
+   */
+  bool write(const BufferView &view);
+  /**
+   * Feeds the read data to the frame parser and encodes all complete frames
+   * into one response.
+   *
+   * @param response the encoded frames or an empty view if no frame has been
+   * completed
+   * @return false if the peer sent an invalid frame.
+   */
+  bool echoFrames(const BufferView &data, BufferView &response);
+#ifndef _WIN32
+  /**
+   * Blocks until the socket is ready for the events or the worker is woken up
+   * by close().
+   *
+   * @param events POLLIN to wait for data or POLLOUT to wait for space in the
+   * send buffer.
+   * @return false if the worker has been woken up to stop or an error occured.
+   */
+  bool waitForSocket(short events);
+#endif
 
  private:  // fields
   std::mutex mutexPublicMethods;
@@ -79,18 +229,69 @@ class Worker {
   SOCKET clientSocket;
 #else
   int clientSocket;
+  /**
+   * An eventfd which is written by close() to wake up a blocking
+   * waitForSocket().
+   */
+  int wakeupFd;
 #endif
   std::atomic_bool enabled;
   std::atomic_bool running;
+  std::atomic_bool finished;
+  std::function<void()> finishedCallback;
+  /**
+   * Whether the stream consists of length-prefixed frames.
+   */
+  bool framing;
+  FrameParser frameParser;
+#ifndef _WIN32
+  /**
+   * Whether the connection is served by a worker thread or by an event loop.
+   */
+  bool threaded;
+  /**
+   * The responses which have not been sent yet.
+   */
+  OutputQueue outputQueue;
+  /**
+   * The file which is sent before the responses or -1.
+   */
+  int fileFd;
+  off_t fileOffset;
+  std::size_t fileRemaining;
+#endif
+  /**
+   * The size of the next receive buffer (see BufferPool::getNextReadSize).
+   */
+  std::size_t readSize = BufferPool::MIN_SIZE;
   std::thread workerThread;
 
  public:  // TLS methods
-  bool readStringTls(std::string &message);
+#ifndef _WIN32
+  /**
+   * Reads the decrypted data of the next TLS record into a pooled buffer
+   * without blocking. A record holds at most 16KiByte and does not
+   * correspond to a message of the peer.
+   *
+   * @return the size of the read data, 0 if the read would block and -1 if
+   * the connection has been closed or an error occured.
+   */
+  int tryReadTls(BufferView &view);
+#endif
+  /**
+   * Copies the data into pooled buffers and writes them with as few
+   * SSL_write() calls as possible.
+   */
   bool writeTls(const byte data[], size_t length);
 
  private:  // TLS fields
 #ifndef _WIN32
   OpenSslWrapper::TlsPtr tlsPtr;
+  /**
+   * Whether the kernel encrypts the sent data (kTLS). The responses are
+   * written to the socket directly then.
+   */
+  bool ktlsSend;
 #endif
 };
 
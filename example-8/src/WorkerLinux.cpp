@@ -4,14 +4,19 @@
 #include <errno.h>  // errno - is thread safe. On Linux, the global errno variable is thread-specific. POSIX requires that errno be threadsafe.
 #include <netinet/in.h>  // contains constants and structures needed for internet domain address.
 #include <openssl/err.h>
+#include <poll.h>          // ::poll(...) ; pollfd ; POLLIN ; POLLOUT
+#include <sys/eventfd.h>   // ::eventfd(...)
 #include <sys/socket.h>  // includes a number of definitions of structures needed for sockets.
 #include <unistd.h>  // ::close(int), ::read(int, void*, size_t)
 
+#include <cstdint>  // uint64_t
 #include <cstring>
 #include <iostream>
 #include <limits>  // for numeric_limits
 #include <memory>
 #include <string>
+#include <utility>  // std::move
+#include <vector>
 
 #include "Worker.h"
 
@@ -19,10 +24,36 @@ namespace ggolbik {
 namespace cpp {
 namespace tls {
 
+/**
+ * The eventfd is created non-blocking, so close() never blocks on it.
+ *
+ * The method call
+ *   int eventfd(unsigned int initval, int flags);
+ * is defined in header <sys/eventfd.h>
+ */
 Worker::Worker(int socket, ::SSL* ssl)
-    : clientSocket{socket}, enabled{false}, running{false}, tlsPtr{ssl} {}
-
-Worker::~Worker() { this->close(); }
+    : clientSocket{socket},
+      wakeupFd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)},
+      enabled{false},
+      running{false},
+      finished{false},
+      framing{false},
+      threaded{false},
+      fileFd{-1},
+      fileOffset{0},
+      fileRemaining{0},
+      tlsPtr{ssl},
+      ktlsSend{ssl != nullptr && OpenSslWrapper::isKtlsSendActive(ssl)} {}
+
+Worker::~Worker() {
+  this->close();
+  if (this->wakeupFd != -1) {
+    ::close(this->wakeupFd);
+  }
+  if (this->fileFd != -1) {
+    ::close(this->fileFd);
+  }
+}
 
 /**
  * errno is thread safe. On Linux, the global errno variable is thread-specific.
@@ -53,8 +84,14 @@ bool Worker::start() {
     return false;
   }
 
+  if (this->wakeupFd == -1) {
+    std::cerr << "Invalid eventfd" << std::endl;
+    return false;
+  }
+
   this->enabled = true;
   this->running = true;
+  this->threaded = true;
 
   this->workerThread = std::thread(&Worker::run, this);
 
@@ -63,6 +100,39 @@ bool Worker::start() {
   return true;
 }
 
+bool Worker::activate() {
+  // lock mutex
+  std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
+
+  if (this->clientSocket == -1) {
+    std::cerr << "Invalid socket" << std::endl;
+    return false;
+  }
+
+  if (!this->tlsPtr) {
+    std::cout << "There is no TLS connection." << std::endl;
+    return false;
+  }
+
+  this->enabled = true;
+  this->running = true;
+
+  return true;
+}
+
+int Worker::getSocket() { return this->clientSocket; }
+
+void Worker::sendFile(int fd, std::size_t size) {
+  if (this->fileFd != -1) {
+    ::close(this->fileFd);
+  }
+  this->fileFd = fd;
+  this->fileOffset = 0;
+  this->fileRemaining = size;
+}
+
+bool Worker::isKtlsActive() { return this->ktlsSend; }
+
 bool Worker::isRunning() {
   // lock mutex
   std::unique_lock<std::mutex> lock(this->mutexPublicMethods);
@@ -91,9 +161,15 @@ void Worker::close() {
   if (this->enabled) {
     this->enabled = false;
 
-    std::cout << "Join worker thread" << std::endl;
+    // wake up the worker thread if it waits for data
+    uint64_t value = 1;
+    if (::write(this->wakeupFd, &value, sizeof(value)) != sizeof(value) &&
+        errno != EAGAIN) {
+      printError();
+    }
 
     if (this->workerThread.joinable()) {
+      std::cout << "Join worker thread" << std::endl;
       this->workerThread.join();
     }
 
@@ -113,26 +189,39 @@ void Worker::close() {
     }
     this->clientSocket = -1;
     this->running = false;
+
+    // a worker served by an event loop is finished by close()
+    this->notifyFinished();
   }
 }
 
-bool Worker::readString(std::string& message) {
+/**
+ * The socket is non-blocking. A single read takes the data which is available
+ * and returns immediately if there is none.
+ *
+ * The method call
+ *   ssize_t read(int fd, void *buf, size_t count);
+ * is defined in header <unistd.h>
+ */
+int Worker::tryRead(BufferView& view) {
   if (this->tlsPtr) {
-    return this->readStringTls(message);
+    return this->tryReadTls(view);
   }
-  byte recvbuf[Worker::MAX_BUFFER_SIZE];
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte* recvbuf = buffer.data();
 
-  message = "";
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::read(this->clientSocket, recvbuf, Worker::MAX_BUFFER_SIZE);
+    rc = ::read(this->clientSocket, recvbuf, buffer.capacity());
     if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
       // The file descriptor fd refers to a file other than a socket and has
       // been marked nonblocking (O_NONBLOCK), and the read would block.
-      if (this->enabled) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      }
+      return 0;
+    } else if (rc < 0 && errno == EINTR) {
+      // interrupted by a signal
       continue;
     } else if (rc < 0) {
       // an error occurred
@@ -144,64 +233,269 @@ bool Worker::readString(std::string& message) {
       break;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
-      return true;
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
+      return static_cast<int>(rc);
     }
   }
 
-  return false;
+  return -1;
 }
 
-bool Worker::readStringTls(std::string& message) {
-  byte recvbuf[Worker::MAX_BUFFER_SIZE];
+int Worker::tryReadTls(BufferView& view) {
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte* recvbuf = buffer.data();
 
-  message = "";
+  view.reset();
 
-  int rc;
+  if (!this->enabled) {
+    return -1;
+  }
+
+  // SSL_get_error() requires an empty error queue. An event loop thread serves
+  // many connections, so errors of a closed connection might be left over.
+  ::ERR_clear_error();
+  int rc = ::SSL_read(this->tlsPtr.get(), recvbuf,
+                      static_cast<int>(buffer.capacity()));
+  if (rc <= 0) {
+    // failed to read data
+    int error = ::SSL_get_error(this->tlsPtr.get(), rc);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+      // all available data has been consumed. TLS might have to write during
+      // a read, e.g. for a renegotiation. The pending write is completed by
+      // the next read.
+      return 0;
+    } else if (error == SSL_ERROR_ZERO_RETURN) {
+      // the peer closed the TLS connection
+      return -1;
+    }
+    // an error occurred or the peer closed the socket
+    printError();
+    ::ERR_print_errors_fp(stderr);
+    std::cerr << "Failed to read tls" << std::endl;
+    return -1;
+  }
+
+  // data has been read
+  this->readSize = BufferPool::getNextReadSize(
+      buffer.capacity(), static_cast<std::size_t>(rc));
+  view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
+  return rc;
+}
+
+/**
+ * poll() waits for one of a set of file descriptors to become ready to perform
+ * I/O. The worker waits for the socket and the eventfd, so close() can
+ * interrupt the wait without a timeout.
+ *
+ * The method call
+ *   int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+ * is defined in header <poll.h>
+ */
+bool Worker::waitForSocket(short events) {
   while (this->enabled) {
-    rc = ::SSL_read(this->tlsPtr.get(), recvbuf, Worker::MAX_BUFFER_SIZE);
-    if (rc <= 0) {
-      // failed to read data
-      int error = ::SSL_get_error(this->tlsPtr.get(), rc);
-      if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
-        if (this->enabled) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        continue;
-      } else {
-        // an error occurred
-        printError();
-        std::cerr << "Failed to read tls" << std::endl;
-        break;
-      }
+    pollfd fds[2] = {};
+    fds[0].fd = this->clientSocket;
+    fds[0].events = events;
+    fds[1].fd = this->wakeupFd;
+    fds[1].events = POLLIN;
+
+    // a negative timeout waits until one of the descriptors is ready
+    int rc = ::poll(fds, 2, -1);
+    if (rc < 0 && errno == EINTR) {
+      // interrupted by a signal
+      continue;
+    } else if (rc < 0) {
+      printError();
+      std::cerr << "Failed to poll" << std::endl;
+      return false;
     }
-    // data has been read
-    message = std::string(recvbuf, static_cast<size_t>(rc));
+
+    if (fds[1].revents != 0) {
+      // woken up by close()
+      return false;
+    }
+    // POLLERR and POLLHUP are reported by the next read or write.
     return true;
   }
-
   return false;
 }
 
+bool Worker::receive() {
+  // SSL_read returns a single record, so more records might be buffered
+  // already. Stop reading while the peer does not take the responses.
+  for (unsigned int i = 0; i < Worker::MAX_READS_PER_WAKEUP &&
+                          !this->outputQueue.isFull() && this->fileFd == -1;
+       i++) {
+    BufferView message;
+    int rc = this->tryRead(message);
+    if (rc == 0) {
+      return true;
+    } else if (rc < 0) {
+      return false;
+    }
+
+    if (this->framing) {
+      BufferView response;
+      if (!this->echoFrames(message, response)) {
+        return false;
+      }
+      if (!response.empty()) {
+        this->outputQueue.push(std::move(response));
+      }
+      continue;
+    }
+
+    std::cout << (this->threaded ? "Worker" : "Event loop")
+              << " thread ID: " << std::this_thread::get_id() << " Data: ";
+    std::cout.write(message.data(), message.size());
+    std::cout << std::endl;
+    // the response shares the read buffer
+    this->outputQueue.push(std::move(message));
+  }
+  return this->enabled;
+}
+
+/**
+ * With kTLS the kernel encrypts the data written to the socket, so the
+ * responses are sent with writev() like on a plain socket.
+ */
+bool Worker::flush() {
+  // without kTLS the file is sent through the output queue
+  int rc = 1;
+  if (this->fileFd != -1 && !this->ktlsSend) {
+    rc = this->flushFile();
+  }
+  if (rc >= 0) {
+    rc = this->tlsPtr && !this->ktlsSend
+             ? this->outputQueue.flushTls(this->tlsPtr.get())
+             : this->outputQueue.flush(this->clientSocket);
+  }
+  // with kTLS the file is sent once the responses queued before have been sent
+  if (rc > 0 && this->fileFd != -1 && this->ktlsSend &&
+      this->outputQueue.empty()) {
+    rc = this->flushFile();
+  }
+  if (rc < 0) {
+    printError();
+    ::ERR_print_errors_fp(stderr);
+    std::cerr << "Failed to send data to client" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * SSL_sendfile() passes the file to sendfile(2). The kernel reads the file
+ * and encrypts it without a copy to user space. It requires kTLS.
+ *
+ * The method calls
+ *   ossl_ssize_t SSL_sendfile(SSL *s, int fd, off_t offset, size_t size, int
+ * flags);
+ *   ssize_t pread(int fd, void *buf, size_t count, off_t offset);
+ * are defined in header <openssl/ssl.h> and <unistd.h>
+ */
+int Worker::flushFile() {
+  if (this->ktlsSend) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    while (this->fileRemaining > 0) {
+      ::ERR_clear_error();
+      ossl_ssize_t rc =
+          ::SSL_sendfile(this->tlsPtr.get(), this->fileFd, this->fileOffset,
+                         this->fileRemaining, 0);
+      if (rc <= 0) {
+        int error = ::SSL_get_error(this->tlsPtr.get(), static_cast<int>(rc));
+        return error == SSL_ERROR_WANT_WRITE ? 0 : -1;
+      }
+      this->fileOffset += rc;
+      this->fileRemaining -= static_cast<std::size_t>(rc);
+    }
+#endif
+  } else {
+    // the output queue limits the part of the file which is read ahead
+    while (this->fileRemaining > 0 && !this->outputQueue.isFull()) {
+      std::size_t count = this->fileRemaining;
+      if (count > BufferPool::MAX_SIZE) {
+        count = BufferPool::MAX_SIZE;
+      }
+      BufferRef buffer = BufferPool::acquire(count);
+      ssize_t rc =
+          ::pread(this->fileFd, buffer.data(), count, this->fileOffset);
+      if (rc <= 0) {
+        // an error occured or the file has been truncated
+        return -1;
+      }
+      this->outputQueue.push(
+          BufferView(std::move(buffer), 0, static_cast<std::size_t>(rc)));
+      this->fileOffset += rc;
+      this->fileRemaining -= static_cast<std::size_t>(rc);
+    }
+  }
+
+  if (this->fileRemaining > 0) {
+    return 0;
+  }
+  ::close(this->fileFd);
+  this->fileFd = -1;
+  return 1;
+}
+
+bool Worker::onReadable() {
+  bool connected = this->receive();
+  // the responses of all reads are sent with as few writes as possible
+  return this->flush() && connected;
+}
+
+bool Worker::onWritable() {
+  bool paused = this->outputQueue.isFull() || this->fileFd != -1;
+  if (!this->flush()) {
+    return false;
+  }
+  if (paused && !this->outputQueue.isFull() && this->fileFd == -1) {
+    // the peer took enough data. TLS records which have been buffered while
+    // reading was paused are not reported by epoll, so read them now.
+    return this->onReadable();
+  }
+  return true;
+}
+
+bool Worker::isWritePending() {
+  return !this->outputQueue.empty() || this->fileFd != -1;
+}
+
+bool Worker::isReadPaused() {
+  return (this->outputQueue.isFull() || this->fileFd != -1) &&
+         !this->outputQueue.wantsRead();
+}
+
 void Worker::run() {
   if (!this->tlsPtr) {
     std::cout << "There is no TLS connection." << std::endl;
   } else {
     // Receive until the peer shuts down the connection
     while (this->enabled) {
-      std::string message;
-      if (this->readString(message)) {
-        std::cout << "Worker thread ID: " << this->workerThread.get_id()
-                  << " Data: " << message << std::endl;
-        if (!this->write(message.c_str(), message.size())) {
-          std::cerr << "Failed to send data to client" << std::endl;
-        }
-      } else {
-        // failed to read
+      if (!this->onReadable()) {
+        break;
+      }
+
+      short events = 0;
+      if (!this->isReadPaused()) {
+        events |= POLLIN;
+      }
+      if (this->isWritePending()) {
+        events |= POLLOUT;
+      }
+      if (!this->waitForSocket(events)) {
         break;
       }
     }
   }
+  this->outputQueue.clear();
+
+  // SSL_shutdown() writes to the socket, so the TLS connection must be closed
+  // before the socket. The descriptor might be reused by a new connection.
+  this->tlsPtr.reset();
 
   if (!closeSocket(this->clientSocket)) {
     printError();
@@ -213,91 +507,82 @@ void Worker::run() {
   this->running = false;
   std::cout << "Stopped Worker thread ID: " << this->workerThread.get_id()
             << std::endl;
-}
-
-bool Worker::write(const byte data[], size_t length) {
-  if (this->tlsPtr) {
-    return this->writeTls(data, length);
-  }
-  if (length == 0) {
-    return true;
-  }
 
-  size_t position = 0;
-  int remaining = length;
+  this->notifyFinished();
+}
 
-  ssize_t rc;
-  while (this->enabled && remaining > 0) {
-    rc = ::write(this->clientSocket, data + (sizeof(byte) * position),
-                 remaining);
+void Worker::setFinishedCallback(std::function<void()> callback) {
+  this->finishedCallback = callback;
+}
 
-    if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-      std::cout << "Worker write AGAIN" << std::endl;
-      // The file descriptor fd refers to a file other than a socket and has
-      // been marked nonblocking (O_NONBLOCK), and the read would block.
-      if (this->enabled) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      }
-      continue;
-    } else if (rc < 0) {
-      // an error occurred
-      printError();
-      std::cerr << "Failed to write" << std::endl;
-      break;
-    } else if (rc == 0) {
-      // reached end of file
-      break;
-    }
+void Worker::setFraming(bool framing) {
+  this->framing = framing;
+  this->frameParser.reset();
+}
 
-    remaining -= rc;
-    position += rc;
+void Worker::notifyFinished() {
+  if (!this->finished.exchange(true) && this->finishedCallback) {
+    this->finishedCallback();
   }
+}
 
-  if (remaining == 0) {
-    return true;
+/**
+ * Copies the data into pooled buffers of at most BufferPool::MAX_SIZE bytes.
+ */
+static void pushCopy(OutputQueue& queue, const char data[], size_t length) {
+  size_t position = 0;
+  while (position < length) {
+    size_t count = length - position;
+    if (count > BufferPool::MAX_SIZE) {
+      count = BufferPool::MAX_SIZE;
+    }
+    BufferRef buffer = BufferPool::acquire(count);
+    std::memcpy(buffer.data(), data + position, count);
+    queue.push(BufferView(std::move(buffer), 0, count));
+    position += count;
   }
+}
 
-  return false;
+bool Worker::write(const BufferView& view) {
+  this->outputQueue.push(view);
+  return this->flush();
 }
 
-bool Worker::writeTls(const byte data[], size_t length) {
-  if (length == 0) {
-    return true;
+/**
+ * A frame which lies within one read shares the read buffer until the
+ * response has been encoded.
+ */
+bool Worker::echoFrames(const BufferView& data, BufferView& response) {
+  response.reset();
+  if (!this->frameParser.feed(data)) {
+    std::cerr << "Received invalid frame" << std::endl;
+    return false;
   }
-
-  size_t position = 0;
-  int remaining = length;
-
-  ssize_t rc;
-  while (this->enabled && remaining > 0) {
-    rc = ::SSL_write(this->tlsPtr.get(), data + (sizeof(byte) * position),
-                     remaining);
-    if (rc <= 0) {
-      // failed to read data
-      int error = ::SSL_get_error(this->tlsPtr.get(), rc);
-      if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
-        if (this->enabled) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        continue;
-      } else {
-        // an error occurred
-        printError();
-        ::ERR_print_errors_fp(stderr);
-        std::cerr << "Failed to write tls." << std::endl;
-        break;
-      }
-    }
-
-    remaining -= rc;
-    position += rc;
+  std::vector<BufferView> frames;
+  BufferView frame;
+  while (this->frameParser.next(frame)) {
+    frames.push_back(std::move(frame));
+  }
+  if (!frames.empty()) {
+    std::cout << (this->threaded ? "Worker" : "Event loop")
+              << " thread ID: " << std::this_thread::get_id()
+              << " Frames: " << frames.size() << std::endl;
+    response = Frame::encode(frames);
   }
+  return true;
+}
 
-  if (remaining == 0) {
-    return true;
+bool Worker::write(const byte data[], size_t length) {
+  if (this->tlsPtr) {
+    return this->writeTls(data, length);
   }
+  pushCopy(this->outputQueue, data, length);
+  return this->outputQueue.flush(this->clientSocket) >= 0;
+}
 
-  return false;
+bool Worker::writeTls(const byte data[], size_t length) {
+  pushCopy(this->outputQueue, data, length);
+  return this->flush();
 }
 
 }  // namespace tls
@@ -1,6 +1,8 @@
 #ifdef _WIN32
 
 #include <iostream>
+#include <utility>  // std::move
+#include <vector>
 // Windows system header files must be lower case.
 #include <winsock2.h>  // The Winsock2.h header file internally includes core elements from the Windows.h header file, so there is not usually an #include line for the Windows.h header file in Winsock applications.
 
@@ -11,7 +13,11 @@ namespace cpp {
 namespace tls {
 
 Worker::Worker(SOCKET socket)
-    : clientSocket{socket}, enabled{false}, running{false} {}
+    : clientSocket{socket},
+      enabled{false},
+      running{false},
+      finished{false},
+      framing{false} {}
 
 Worker::~Worker() { this->close(); }
 
@@ -62,6 +68,21 @@ bool Worker::isRunning() {
   return this->enabled || this->running;
 }
 
+bool Worker::activate() {
+  std::cerr << "NOT IMPLEMENTED" << std::endl;
+  return false;
+}
+
+bool Worker::onReadable() { return false; }
+
+bool Worker::onWritable() { return false; }
+
+bool Worker::isWritePending() { return false; }
+
+bool Worker::isReadPaused() { return false; }
+
+SOCKET Worker::getSocket() { return this->clientSocket; }
+
 static bool closeSocket(SOCKET socket) {
   if (socket == INVALID_SOCKET) {
     // invalid socket
@@ -108,16 +129,27 @@ void Worker::close() {
 void Worker::run() {
   // Receive until the peer shuts down the connection
   while (this->enabled) {
-    std::string message;
-    if (this->readString(message)) {
-      std::cout << "Data: " << message << std::endl;
-      if (!this->write(message.c_str(), message.size())) {
-        std::cerr << "Failed to send data to client" << std::endl;
-      }
-    } else {
+    BufferView message;
+    if (!this->read(message)) {
       // failed to read
       break;
     }
+    if (this->framing) {
+      BufferView response;
+      if (!this->echoFrames(message, response)) {
+        break;
+      }
+      if (!response.empty() && !this->write(response)) {
+        std::cerr << "Failed to send data to client" << std::endl;
+      }
+      continue;
+    }
+    std::cout << "Data: ";
+    std::cout.write(message.data(), message.size());
+    std::cout << std::endl;
+    if (!this->write(message)) {
+      std::cerr << "Failed to send data to client" << std::endl;
+    }
   }
 
   if (!closeSocket(this->clientSocket)) {
@@ -129,16 +161,35 @@ void Worker::run() {
   this->running = false;
   std::cout << "Stopped Worker thread ID: " << this->workerThread.get_id()
             << std::endl;
+
+  this->notifyFinished();
 }
 
-bool Worker::readString(std::string &message) {
-  byte recvbuf[Worker::MAX_BUFFER_SIZE];
+void Worker::setFinishedCallback(std::function<void()> callback) {
+  this->finishedCallback = callback;
+}
 
-  message = "";
+void Worker::setFraming(bool framing) {
+  this->framing = framing;
+  this->frameParser.reset();
+}
+
+void Worker::notifyFinished() {
+  if (!this->finished.exchange(true) && this->finishedCallback) {
+    this->finishedCallback();
+  }
+}
+
+bool Worker::read(BufferView &view) {
+  // the buffer returns to the pool when the last view has been released
+  BufferRef buffer = BufferPool::acquire(this->readSize);
+  byte *recvbuf = buffer.data();
+
+  view.reset();
 
   ssize_t rc;
   while (this->enabled) {
-    rc = ::recv(this->clientSocket, recvbuf, Worker::MAX_BUFFER_SIZE, 0);
+    rc = ::recv(this->clientSocket, recvbuf, buffer.capacity(), 0);
     if (rc < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
       // The file descriptor fd refers to a file other than a socket and has
       // been marked nonblocking (O_NONBLOCK), and the read would block.
@@ -158,7 +209,9 @@ bool Worker::readString(std::string &message) {
       break;
     } else {
       // data has been read
-      message = std::string(recvbuf, static_cast<size_t>(rc));
+      this->readSize = BufferPool::getNextReadSize(
+          buffer.capacity(), static_cast<std::size_t>(rc));
+      view = BufferView(std::move(buffer), 0, static_cast<size_t>(rc));
       return true;
     }
   }
@@ -166,6 +219,27 @@ bool Worker::readString(std::string &message) {
   return false;
 }
 
+bool Worker::write(const BufferView &view) {
+  return this->write(view.data(), view.size());
+}
+
+bool Worker::echoFrames(const BufferView &data, BufferView &response) {
+  response.reset();
+  if (!this->frameParser.feed(data)) {
+    std::cerr << "Received invalid frame" << std::endl;
+    return false;
+  }
+  std::vector<BufferView> frames;
+  BufferView frame;
+  while (this->frameParser.next(frame)) {
+    frames.push_back(std::move(frame));
+  }
+  if (!frames.empty()) {
+    response = Frame::encode(frames);
+  }
+  return true;
+}
+
 bool Worker::write(const byte data[], size_t length) {
   if (length == 0) {
     return true;
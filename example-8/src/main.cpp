@@ -2,9 +2,15 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "Algorithm.h"
+#include "Base64Decoder.h"
+#include "Base64Encoder.h"
+#include "Benchmark.h"
 #include "Client.h"
+#include "KeyStore.h"
+#include "LoadGenerator.h"
 #include "OpenSslWrapper.h"
 #include "Server.h"
 
@@ -14,16 +20,30 @@ static bool fileExists(const std::string& name) {
 }
 
 static int runServer(const std::string& serverAddress = "",
-                     unsigned short port = 5044, const std::string& key = "",
+                     unsigned short port = 5044,
+                     ggolbik::cpp::tls::Server::Mode mode =
+                         ggolbik::cpp::tls::Server::Mode::ThreadPerConnection,
+                     unsigned int loopCount = 0,
+                     unsigned int handshakeTimeout = 0,
+                     long sessionCacheSize = -1,
+                     long ticketKeyRotation = -1, bool ktls = false,
+                     bool framing = false,
+                     const std::string& greetingFile = "",
+                     unsigned int certWatchInterval = 0,
+                     ggolbik::cpp::tls::OpenSslWrapper::KeyAlgorithm
+                         keyAlgorithm = ggolbik::cpp::tls::OpenSslWrapper::
+                             DEFAULT_KEY_ALGORITHM,
+                     const std::string& key = "",
                      const std::string& cert = "", std::string password = "") {
   std::cout << "Starting server..." << std::endl;
-  ggolbik::cpp::tls::Server server(port, serverAddress);
+  ggolbik::cpp::tls::Server server(port, serverAddress, mode, loopCount);
   if (key.empty() && cert.empty()) {
     if (!fileExists(server.getKeyFileName()) ||
         !fileExists(server.getCertFileName())) {
       std::cout << "Generate self signed certificate." << std::endl;
       if (!ggolbik::cpp::tls::OpenSslWrapper::createSelfSignedCert(
-              server.getKeyFileName(), server.getCertFileName(), password)) {
+              server.getKeyFileName(), server.getCertFileName(), password,
+              keyAlgorithm)) {
         std::cerr << "Failed to create self signed certificate." << std::endl;
         return -1;
       }
@@ -36,6 +56,19 @@ static int runServer(const std::string& serverAddress = "",
   if (!cert.empty()) {
     server.setCertFileName(cert);
   }
+  if (handshakeTimeout > 0) {
+    server.setHandshakeTimeout(handshakeTimeout);
+  }
+  if (sessionCacheSize >= 0) {
+    server.setSessionCacheSize(static_cast<unsigned int>(sessionCacheSize));
+  }
+  if (ticketKeyRotation >= 0) {
+    server.setTicketKeyRotation(static_cast<unsigned int>(ticketKeyRotation));
+  }
+  server.setKtls(ktls);
+  server.setFraming(framing);
+  server.setGreetingFileName(greetingFile);
+  server.setCertificateWatchInterval(certWatchInterval);
   server.open();
 
   if (!server.isOpen()) {
@@ -45,11 +78,37 @@ static int runServer(const std::string& serverAddress = "",
 
   std::cout << "Started server." << std::endl;
 
-  std::cout << ">>> Type any key and press return to stop." << std::endl;
+  std::cout << ">>> Type 'r' and press return to reload the certificate."
+            << std::endl;
+  std::cout << ">>> Type any other key and press return to stop." << std::endl;
   char k;
-  std::cin >> k;
+  while (std::cin >> k && k == 'r') {
+    if (server.reloadCertificate()) {
+      std::cout << "Certificate will be used by new connections." << std::endl;
+    }
+  }
 
   std::cout << "Stopping server..." << std::endl;
+  std::cout << "Open connections: " << server.getConnectionCount()
+            << std::endl;
+  std::cout << "Served connections: " << server.getTotalConnectionCount()
+            << std::endl;
+  std::cout << "Timed out handshakes: " << server.getHandshakeTimeoutCount()
+            << std::endl;
+  ggolbik::cpp::tls::HandshakeStatistics statistics =
+      server.getHandshakeStatistics();
+  std::cout << "Full handshakes: " << statistics.fullCount << std::endl;
+  std::cout << "Resumed handshakes: " << statistics.resumedCount << " ("
+            << statistics.getResumptionRate() << "%)" << std::endl;
+  std::cout << "Handshake CPU time saved: "
+            << statistics.getSavedCpuNanoseconds() / 1000000.0 << " ms"
+            << std::endl;
+  std::cout << "Certificate reloads: " << server.getCertificateReloadCount()
+            << std::endl;
+  if (server.isKtls()) {
+    std::cout << "kTLS connections: " << server.getKtlsConnectionCount()
+              << std::endl;
+  }
 
   server.close();
 
@@ -62,7 +121,7 @@ static int runServer(const std::string& serverAddress = "",
 }
 
 static int runClient(const std::string& serverAddress = "127.0.0.1",
-                     unsigned short port = 5044) {
+                     unsigned short port = 5044, bool framing = false) {
   std::cout << "Starting client..." << std::endl;
   ggolbik::cpp::tls::Client client(serverAddress, port);
 
@@ -76,7 +135,16 @@ static int runClient(const std::string& serverAddress = "127.0.0.1",
               << std::endl;
     std::string message;
     do {
-      if (message != "") {
+      if (message != "" && framing) {
+        // the server echoes the frame, so the response can be awaited
+        ggolbik::cpp::tls::BufferView frame;
+        if (!client.writeFrame(message.c_str(), message.size()) ||
+            !client.readFrame(frame)) {
+          std::cerr << "> Failed to exchange frame." << std::endl;
+          break;
+        }
+        std::cout << "Response: " << frame.toString() << std::endl;
+      } else if (message != "") {
         if (client.write(message.c_str(), message.size())) {
           std::cout << "> Data has been sent." << std::endl;
         } else {
@@ -103,10 +171,68 @@ static int runClient(const std::string& serverAddress = "127.0.0.1",
   return 0;
 }
 
+/**
+ * The keys and certificates of the sign and verify tasks are parsed once per
+ * process.
+ */
+static ggolbik::cpp::tls::KeyStore& getKeyStore() {
+  static ggolbik::cpp::tls::KeyStore keyStore;
+  return keyStore;
+}
+
+/**
+ * Reads the file in chunks of 64 KiB and prints the encoded or decoded data
+ * of each chunk, so the memory does not grow with the size of the file.
+ */
+static bool streamBase64File(const std::string& fileName, bool encode,
+                             ggolbik::cpp::tls::Base64::Alphabet alphabet) {
+  static const std::size_t chunkSize = 64 * 1024;
+  std::ifstream file(fileName.c_str(), std::ifstream::binary);
+  std::vector<char> chunk(chunkSize);
+  std::vector<char> output(
+      ggolbik::cpp::tls::Base64Encoder::getMaxUpdateSize(chunkSize));
+  unsigned char* bytes = reinterpret_cast<unsigned char*>(output.data());
+  ggolbik::cpp::tls::Base64Encoder encoder(alphabet);
+  ggolbik::cpp::tls::Base64Decoder decoder(alphabet);
+  while (file.good()) {
+    file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    std::size_t size = static_cast<std::size_t>(file.gcount());
+    std::size_t written = 0;
+    if (encode) {
+      written = encoder.update(
+          reinterpret_cast<const unsigned char*>(chunk.data()), size,
+          output.data());
+    } else if (!decoder.update(chunk.data(), size, bytes, written)) {
+      std::cerr << "The file is not valid base64." << std::endl;
+      return false;
+    }
+    std::cout.write(output.data(), static_cast<std::streamsize>(written));
+  }
+  if (file.bad()) {
+    std::cerr << "Failed to read the file." << std::endl;
+    return false;
+  }
+  std::size_t written = 0;
+  if (encode) {
+    written = encoder.finish(output.data());
+  } else if (!decoder.finish(bytes, written)) {
+    std::cerr << "The file is not valid base64." << std::endl;
+    return false;
+  }
+  std::cout.write(output.data(), static_cast<std::streamsize>(written));
+  std::cout << std::endl;
+  return true;
+}
+
 static int runAlgorithm(const std::string& task, const std::string& input,
                         const std::string& signature,
-                        const std::string fileName, std::string key = "",
-                        std::string cert = "", std::string password = "") {
+                        const std::string fileName,
+                        ggolbik::cpp::tls::OpenSslWrapper::KeyAlgorithm
+                            keyAlgorithm = ggolbik::cpp::tls::OpenSslWrapper::
+                                DEFAULT_KEY_ALGORITHM,
+                        std::string key = "",
+                        std::string cert = "", std::string password = "",
+                        unsigned int threads = 0) {
   if (task == "base64-encode") {
     std::string encoded;
     if (!input.empty()) {
@@ -114,6 +240,13 @@ static int runAlgorithm(const std::string& task, const std::string& input,
         std::cout << "base64-encoded (input): " << encoded << std::endl;
         return 0;
       }
+    } else if (!fileName.empty() && fileExists(fileName)) {
+      std::cout << "base64-encoded (file): ";
+      if (streamBase64File(fileName, true,
+                           ggolbik::cpp::tls::Base64::Alphabet::Standard)) {
+        return 0;
+      }
+      std::cout << std::endl;
     }
   } else if (task == "base64-decode") {
     std::string decoded;
@@ -122,6 +255,13 @@ static int runAlgorithm(const std::string& task, const std::string& input,
         std::cout << "base64-decoded (input): " << decoded << std::endl;
         return 0;
       }
+    } else if (!fileName.empty() && fileExists(fileName)) {
+      std::cout << "base64-decoded (file): ";
+      if (streamBase64File(fileName, false,
+                           ggolbik::cpp::tls::Base64::Alphabet::Standard)) {
+        return 0;
+      }
+      std::cout << std::endl;
     }
   } else if (task == "base64url-encode") {
     std::string encoded;
@@ -130,6 +270,13 @@ static int runAlgorithm(const std::string& task, const std::string& input,
         std::cout << "base64url-encoded (input): " << encoded << std::endl;
         return 0;
       }
+    } else if (!fileName.empty() && fileExists(fileName)) {
+      std::cout << "base64url-encoded (file): ";
+      if (streamBase64File(fileName, true,
+                           ggolbik::cpp::tls::Base64::Alphabet::Url)) {
+        return 0;
+      }
+      std::cout << std::endl;
     }
   } else if (task == "base64url-decode") {
     std::string decoded;
@@ -138,6 +285,13 @@ static int runAlgorithm(const std::string& task, const std::string& input,
         std::cout << "base64url-decoded (input): " << decoded << std::endl;
         return 0;
       }
+    } else if (!fileName.empty() && fileExists(fileName)) {
+      std::cout << "base64url-decoded (file): ";
+      if (streamBase64File(fileName, false,
+                           ggolbik::cpp::tls::Base64::Alphabet::Url)) {
+        return 0;
+      }
+      std::cout << std::endl;
     }
   } else if (task == "sha256") {
     std::string hashString;
@@ -152,14 +306,23 @@ static int runAlgorithm(const std::string& task, const std::string& input,
         return 0;
       }
     }
+  } else if (task == "sha256-tree") {
+    std::string hashString;
+    if (!fileName.empty() && fileExists(fileName)) {
+      if (ggolbik::cpp::tls::Algorithm::calcSha256TreeFile(fileName, hashString,
+                                                           threads)) {
+        std::cout << "sha256-tree (file): " << hashString << std::endl;
+        return 0;
+      }
+    }
   } else if (task == "sign") {
     if (key.empty() && cert.empty()) {
       key = "key.pem";
       cert = "cert.pem";
       if (!fileExists(key) || !fileExists(cert)) {
         std::cout << "Generate self signed certificate." << std::endl;
-        if (!ggolbik::cpp::tls::OpenSslWrapper::createSelfSignedCert(key, cert,
-                                                                     "")) {
+        if (!ggolbik::cpp::tls::OpenSslWrapper::createSelfSignedCert(
+                key, cert, "", keyAlgorithm)) {
           std::cerr << "Failed to create self signed certificate." << std::endl;
           return -1;
         }
@@ -168,8 +331,7 @@ static int runAlgorithm(const std::string& task, const std::string& input,
     }
 
     ggolbik::cpp::tls::OpenSslWrapper::TlsKey privateKey = {};
-    if (!ggolbik::cpp::tls::OpenSslWrapper::readKeyFile(key, privateKey,
-                                                        password)) {
+    if (!getKeyStore().getKey(key, password, privateKey)) {
       std::cerr << "Failed to read key." << std::endl;
       return -1;
     }
@@ -197,8 +359,8 @@ static int runAlgorithm(const std::string& task, const std::string& input,
       cert = "cert.pem";
       if (!fileExists(key) || !fileExists(cert)) {
         std::cout << "Generate self signed certificate." << std::endl;
-        if (!ggolbik::cpp::tls::OpenSslWrapper::createSelfSignedCert(key, cert,
-                                                                     "")) {
+        if (!ggolbik::cpp::tls::OpenSslWrapper::createSelfSignedCert(
+                key, cert, "", keyAlgorithm)) {
           std::cerr << "Failed to create self signed certificate." << std::endl;
           return -1;
         }
@@ -206,16 +368,11 @@ static int runAlgorithm(const std::string& task, const std::string& input,
       std::cout << "Using self signed certificate." << std::endl;
     }
 
-    ggolbik::cpp::tls::OpenSslWrapper::TlsX509Cert x509Cert = {};
-    if (!ggolbik::cpp::tls::OpenSslWrapper::readCertFile(cert, x509Cert, "")) {
+    ggolbik::cpp::tls::OpenSslWrapper::TlsKey pubKey = {};
+    if (!getKeyStore().getCertKey(cert, pubKey)) {
       std::cerr << "Failed to read cert." << std::endl;
       return -1;
     }
-    // ggolbik::cpp::tls::OpenSslWrapper::displayCert(x509Cert);
-    ggolbik::cpp::tls::OpenSslWrapper::TlsKey pubKey = {};
-    if (!ggolbik::cpp::tls::OpenSslWrapper::readCertKey(x509Cert, pubKey)) {
-      std::cerr << "Failed to read key." << std::endl;
-    }
 
     if (!input.empty()) {
       std::string encodedSignature;
@@ -231,24 +388,97 @@ static int runAlgorithm(const std::string& task, const std::string& input,
   return -1;
 }
 
+static int runBenchmark(
+    const std::string& task, unsigned int milliseconds,
+    ggolbik::cpp::tls::OpenSslWrapper::KeyAlgorithm keyAlgorithm,
+    unsigned int threads, const std::string& fileName,
+    ggolbik::cpp::tls::Server::Mode mode, unsigned short port,
+    unsigned int messages, unsigned int idle) {
+  if (task.empty() || task == "keys") {
+    return ggolbik::cpp::tls::Benchmark::runKeyAlgorithms(milliseconds);
+  } else if (task == "signatures") {
+    return ggolbik::cpp::tls::Benchmark::runSignatures(keyAlgorithm,
+                                                       milliseconds, threads);
+  } else if (task == "keystore") {
+    return ggolbik::cpp::tls::Benchmark::runKeyStore(keyAlgorithm,
+                                                     milliseconds);
+  } else if (task == "base64") {
+    return ggolbik::cpp::tls::Benchmark::runBase64(milliseconds);
+  } else if (task == "hashfile") {
+    return ggolbik::cpp::tls::Benchmark::runHashFile(fileName, milliseconds,
+                                                     threads);
+  } else if (task == "sha256batch") {
+    return ggolbik::cpp::tls::Benchmark::runSha256Batch(milliseconds);
+  } else if (task == "hex") {
+    return ggolbik::cpp::tls::Benchmark::runHex(milliseconds);
+  } else if (task == "latency") {
+    return ggolbik::cpp::tls::Benchmark::runLatency(mode, port, messages,
+                                                    idle);
+  }
+  std::cerr << "Unknown benchmark '" << task << "'." << std::endl;
+  return -1;
+}
+
 static void printHelp() {
   std::cout << "Usage:" << std::endl;
   std::cout << "\tActions:" << std::endl;
   std::cout << "\t\tserver" << std::endl;
   std::cout << "\t\tclient" << std::endl;
   std::cout << "\t\talgorithm" << std::endl;
+  std::cout << "\t\tloadgen" << std::endl;
+  std::cout << "\t\tbenchmark" << std::endl;
   std::cout << "\tParameters:" << std::endl;
   std::cout << "\t\thost=<IP-Address>" << std::endl;
   std::cout << "\t\tport=<Port Number>" << std::endl;
+  std::cout << "\t\tmode=<thread|eventloop>" << std::endl;
+  std::cout << "\t\tloops=<number of event loop threads>" << std::endl;
   std::cout << "\t\tkey=<path to key file>" << std::endl;
   std::cout << "\t\tcert=<path to cert file>" << std::endl;
+  std::cout << "\t\tkey-algorithm=<rsa2048|rsa3072|rsa4096|p256|p384|ed25519> "
+               "of a generated key"
+            << std::endl;
+  std::cout << "\t\thandshake-timeout=<milliseconds to complete the TLS "
+               "handshake>"
+            << std::endl;
+  std::cout << "\t\tsession-cache=<max number of cached TLS sessions, 0 "
+               "disables the cache>"
+            << std::endl;
+  std::cout << "\t\twatch-cert=<milliseconds between checks of the key and "
+               "cert files, 0 disables the check>"
+            << std::endl;
+  std::cout << "\t\tktls=<on|off>" << std::endl;
+  std::cout << "\t\tframing=<on|off> length-prefixed messages of server, "
+               "client and loadgen"
+            << std::endl;
+  std::cout << "\t\tgreeting=<file sent to each client by the server>"
+            << std::endl;
+  std::cout << "\t\tticket-rotation=<seconds until the session ticket key is "
+               "replaced, 0 disables tickets>"
+            << std::endl;
   std::cout << "\t\ttask=<base64-encode|base64-decode|base64url-"
-               "encode|base64url-decode|sha256|sign|verify>"
+               "encode|base64url-decode|sha256|sha256-tree|sign|verify>"
             << std::endl;
   std::cout << "\t\tinput=<data to consume>" << std::endl;
   std::cout << "\t\tsignature=<base64 signature of input>" << std::endl;
   std::cout << "\t\tfile=<file which contains the data to consume>"
             << std::endl;
+  std::cout << "\t\tconnections=<number of loadgen connections>" << std::endl;
+  std::cout << "\t\trate=<messages per second of all connections for loadgen>"
+            << std::endl;
+  std::cout << "\t\tsize=<message size in bytes for loadgen>" << std::endl;
+  std::cout << "\t\tduration=<seconds of load for loadgen>" << std::endl;
+  std::cout << "\t\tmessages=<number of messages for benchmark task=latency>"
+            << std::endl;
+  std::cout << "\t\tidle=<pause before each latency message in ms>"
+            << std::endl;
+  std::cout << "\t\ttask=<keys|signatures|keystore|base64|hashfile|"
+               "sha256batch|hex|latency> for benchmark"
+            << std::endl;
+  std::cout << "\t\tthreads=<number of benchmark or sha256-tree threads, 0 "
+               "uses one per CPU core>"
+            << std::endl;
+  std::cout << "\t\ttime=<milliseconds to repeat each benchmark operation>"
+            << std::endl;
   std::cout << "\tExample:" << std::endl;
   std::cout << "\t\tproject_cpp_binary client host=127.0.0.1 port=5044"
             << std::endl;
@@ -259,16 +489,57 @@ class Configuration {
   bool isServer;
   bool isClient;
   bool isAlgorithm;
+  bool isLoadgen;
+  bool isBenchmark;
   std::string serverAddress = "127.0.0.1";
   int port = 5044;
+  ggolbik::cpp::tls::Server::Mode serverMode =
+      ggolbik::cpp::tls::Server::Mode::ThreadPerConnection;
+  unsigned int loopCount = 0;
+  unsigned long handshakeTimeout = 0;
+  unsigned long certWatchInterval = 0;
+  long sessionCacheSize = -1;
+  long ticketKeyRotation = -1;
+  bool ktls = false;
+  bool framing = false;
+  std::string greetingFile = "";
   std::string key = "";
   std::string cert = "";
+  ggolbik::cpp::tls::OpenSslWrapper::KeyAlgorithm keyAlgorithm =
+      ggolbik::cpp::tls::OpenSslWrapper::DEFAULT_KEY_ALGORITHM;
   std::string algorithmTask;
   std::string algorithmInput;
   std::string algorithmFile;
   std::string algorithmSignature;
+  unsigned long connections = 4;
+  unsigned long rate = 1000;
+  unsigned long size = 64;
+  unsigned long duration = 10;
+  unsigned long messages = 100;
+  unsigned long idle = 10;
+  unsigned long benchmarkTime = ggolbik::cpp::tls::Benchmark::DEFAULT_MILLISECONDS;
+  unsigned long benchmarkThreads = 0;
 };
 
+/**
+ * Parses the value of a numeric parameter like "size=1024".
+ */
+static bool parseNumber(const std::string& argument,
+                        const std::string& delimiter, unsigned long& value) {
+  if (argument.rfind(delimiter, 0) != 0) {
+    return false;
+  }
+  std::string strValue = argument.substr(delimiter.size());
+  try {
+    value = stoul(strValue);
+    return true;
+  } catch (std::invalid_argument& e) {
+    std::cerr << "Failed to parse " << delimiter << "'" << strValue << "'. "
+              << e.what() << std::endl;
+  }
+  return false;
+}
+
 static bool parseArguments(Configuration& configuration, int argc,
                            char* argv[]) {
   configuration = {};
@@ -285,6 +556,30 @@ static bool parseArguments(Configuration& configuration, int argc,
     if (std::string("algorithm").compare(argv[i]) == 0) {
       configuration.isAlgorithm = true;
     }
+    if (std::string("loadgen").compare(argv[i]) == 0) {
+      configuration.isLoadgen = true;
+    }
+    if (std::string("benchmark").compare(argv[i]) == 0) {
+      configuration.isBenchmark = true;
+    }
+    parseNumber(argv[i], "connections=", configuration.connections);
+    parseNumber(argv[i], "rate=", configuration.rate);
+    parseNumber(argv[i], "size=", configuration.size);
+    parseNumber(argv[i], "duration=", configuration.duration);
+    parseNumber(argv[i], "messages=", configuration.messages);
+    parseNumber(argv[i], "idle=", configuration.idle);
+    parseNumber(argv[i], "time=", configuration.benchmarkTime);
+    parseNumber(argv[i], "threads=", configuration.benchmarkThreads);
+    parseNumber(argv[i], "handshake-timeout=", configuration.handshakeTimeout);
+    parseNumber(argv[i], "watch-cert=", configuration.certWatchInterval);
+    // -1 keeps the default of the server
+    unsigned long value;
+    if (parseNumber(argv[i], "session-cache=", value)) {
+      configuration.sessionCacheSize = static_cast<long>(value);
+    }
+    if (parseNumber(argv[i], "ticket-rotation=", value)) {
+      configuration.ticketKeyRotation = static_cast<long>(value);
+    }
     if (std::string(argv[i]).rfind("host=", 0) == 0) {
       configuration.serverAddress = std::string(argv[i]);
       std::string delimiter = "host=";
@@ -320,6 +615,64 @@ static bool parseArguments(Configuration& configuration, int argc,
                   << std::endl;
       }
     }
+    if (std::string(argv[i]).rfind("mode=", 0) == 0) {
+      std::string strMode = std::string(argv[i]);
+      std::string delimiter = "mode=";
+      strMode =
+          strMode.substr(delimiter.size(), strMode.size() - delimiter.size());
+      if (strMode == "eventloop") {
+        configuration.serverMode =
+            ggolbik::cpp::tls::Server::Mode::EventLoop;
+      } else if (strMode == "thread") {
+        configuration.serverMode =
+            ggolbik::cpp::tls::Server::Mode::ThreadPerConnection;
+      } else {
+        std::cerr << "Unknown mode '" << strMode << "'." << std::endl;
+      }
+    }
+    if (std::string(argv[i]).rfind("ktls=", 0) == 0) {
+      std::string strKtls = std::string(argv[i]).substr(5);
+      if (strKtls == "on") {
+        configuration.ktls = true;
+      } else if (strKtls == "off") {
+        configuration.ktls = false;
+      } else {
+        std::cerr << "Unknown ktls '" << strKtls << "'." << std::endl;
+      }
+    }
+    if (std::string(argv[i]).rfind("framing=", 0) == 0) {
+      std::string strFraming = std::string(argv[i]).substr(8);
+      if (strFraming == "on") {
+        configuration.framing = true;
+      } else if (strFraming == "off") {
+        configuration.framing = false;
+      } else {
+        std::cerr << "Unknown framing '" << strFraming << "'." << std::endl;
+      }
+    }
+    if (std::string(argv[i]).rfind("key-algorithm=", 0) == 0) {
+      std::string strAlgorithm = std::string(argv[i]).substr(14);
+      if (!ggolbik::cpp::tls::OpenSslWrapper::parseKeyAlgorithm(
+              strAlgorithm, configuration.keyAlgorithm)) {
+        std::cerr << "Unknown key algorithm '" << strAlgorithm << "'."
+                  << std::endl;
+      }
+    }
+    if (std::string(argv[i]).rfind("greeting=", 0) == 0) {
+      configuration.greetingFile = std::string(argv[i]).substr(9);
+    }
+    if (std::string(argv[i]).rfind("loops=", 0) == 0) {
+      std::string strLoops = std::string(argv[i]);
+      std::string delimiter = "loops=";
+      strLoops =
+          strLoops.substr(delimiter.size(), strLoops.size() - delimiter.size());
+      try {
+        configuration.loopCount = (unsigned int)stoul(strLoops);
+      } catch (std::invalid_argument& e) {
+        std::cerr << "Failed to parse loops '" << strLoops << "'. " << e.what()
+                  << std::endl;
+      }
+    }
     if (std::string(argv[i]).rfind("task=", 0) == 0) {
       configuration.algorithmTask = std::string(argv[i]);
       std::string delimiter = "task=";
@@ -352,12 +705,14 @@ static bool parseArguments(Configuration& configuration, int argc,
   }
 
   if (!configuration.isServer && !configuration.isClient &&
-      !configuration.isAlgorithm) {
+      !configuration.isAlgorithm && !configuration.isLoadgen &&
+      !configuration.isBenchmark) {
     std::cerr << "Action must be selected." << std::endl;
     return false;
-  } else if ((configuration.isServer && configuration.isClient) ||
-             (configuration.isServer && configuration.isAlgorithm) ||
-             (configuration.isClient && configuration.isAlgorithm)) {
+  } else if (configuration.isServer + configuration.isClient +
+                 configuration.isAlgorithm + configuration.isLoadgen +
+                 configuration.isBenchmark >
+             1) {
     std::cerr << "You can not select multiple actions." << std::endl;
     return false;
   }
@@ -365,8 +720,18 @@ static bool parseArguments(Configuration& configuration, int argc,
   // print parameters
   std::cout << "Host: " << configuration.serverAddress << std::endl;
   std::cout << "Port: " << configuration.port << std::endl;
+  std::cout << "Mode: "
+            << (configuration.serverMode ==
+                        ggolbik::cpp::tls::Server::Mode::EventLoop
+                    ? "eventloop"
+                    : "thread")
+            << std::endl;
   std::cout << "Key: " << configuration.key << std::endl;
   std::cout << "Cert: " << configuration.cert << std::endl;
+  std::cout << "Key algorithm: "
+            << ggolbik::cpp::tls::OpenSslWrapper::getKeyAlgorithmName(
+                   configuration.keyAlgorithm)
+            << std::endl;
   std::cout << "Task: " << configuration.algorithmTask << std::endl;
   std::cout << "Input: " << configuration.algorithmInput << std::endl;
   std::cout << "Signature: " << configuration.algorithmSignature << std::endl;
@@ -391,12 +756,37 @@ int main(int argc, char* argv[]) {
 #endif
 
   if (configuration.isServer) {
-    return runServer(configuration.serverAddress, configuration.port);
+    return runServer(configuration.serverAddress, configuration.port,
+                     configuration.serverMode, configuration.loopCount,
+                     static_cast<unsigned int>(configuration.handshakeTimeout),
+                     configuration.sessionCacheSize,
+                     configuration.ticketKeyRotation, configuration.ktls,
+                     configuration.framing, configuration.greetingFile,
+                     static_cast<unsigned int>(configuration.certWatchInterval),
+                     configuration.keyAlgorithm, configuration.key,
+                     configuration.cert);
   } else if (configuration.isClient) {
-    return runClient(configuration.serverAddress, configuration.port);
+    return runClient(configuration.serverAddress, configuration.port,
+                     configuration.framing);
   } else if (configuration.isAlgorithm) {
     return runAlgorithm(
         configuration.algorithmTask, configuration.algorithmInput,
-        configuration.algorithmSignature, configuration.algorithmFile);
+        configuration.algorithmSignature, configuration.algorithmFile,
+        configuration.keyAlgorithm, "", "", "",
+        static_cast<unsigned int>(configuration.benchmarkThreads));
+  } else if (configuration.isLoadgen) {
+    return ggolbik::cpp::tls::LoadGenerator::run(
+        configuration.serverAddress, configuration.port,
+        configuration.connections, configuration.rate, configuration.size,
+        configuration.duration, configuration.framing);
+  } else if (configuration.isBenchmark) {
+    return runBenchmark(
+        configuration.algorithmTask,
+        static_cast<unsigned int>(configuration.benchmarkTime),
+        configuration.keyAlgorithm,
+        static_cast<unsigned int>(configuration.benchmarkThreads),
+        configuration.algorithmFile, configuration.serverMode,
+        configuration.port, static_cast<unsigned int>(configuration.messages),
+        static_cast<unsigned int>(configuration.idle));
   }
 }
\ No newline at end of file